@@ -0,0 +1,92 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Build time of large networks with 1 to N build threads.
+
+The fused functions are lowered and their LLVM code is generated on
+TVM_NUM_BUILD_THREADS threads. The cache of the compile engine is cleared
+before each build so that every build lowers all the functions. With
+--cache-dir, one more build loads the functions from a persistent cache.
+see README.md for the usage of this script.
+"""
+import argparse
+import os
+import time
+
+from tvm import relay
+
+from util import get_network
+
+
+def count_fused_functions(mod, params, target):
+    """The number of primitive functions the graph calls after fusion"""
+    with relay.build_config(opt_level=3):
+        opt_mod, _ = relay.optimize(mod, target, params)
+    count = [0]
+
+    def visit(expr):
+        if isinstance(expr, relay.Call) and isinstance(expr.op, relay.Function):
+            count[0] += 1
+    relay.analysis.post_order_visit(opt_mod["main"], visit)
+    return count[0]
+
+
+def build_once(mod, params, target):
+    """Return the seconds of one build from an empty compile cache"""
+    relay.backend.compile_engine.get().clear()
+    tic = time.time()
+    with relay.build_config(opt_level=3):
+        relay.build(mod, target=target, params=params)
+    return time.time() - tic
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--network", type=str, default=None,
+                        choices=['resnet-50', 'resnet-152', 'inception_v3', 'densenet-201'])
+    parser.add_argument("--target", type=str, default="llvm")
+    parser.add_argument("--threads", type=int, default=os.cpu_count(),
+                        help="The largest number of build threads.")
+    parser.add_argument("--repeat", type=int, default=1)
+    parser.add_argument("--cache-dir", type=str, default=None,
+                        help="Also time builds loading the functions from this persistent cache.")
+    args = parser.parse_args()
+
+    networks = [args.network] if args.network else ['resnet-152', 'inception_v3']
+    counts = [1]
+    while counts[-1] * 2 <= args.threads:
+        counts.append(counts[-1] * 2)
+    if counts[-1] != args.threads:
+        counts.append(args.threads)
+
+    columns = ["%d thr" % n for n in counts] + (["cached"] if args.cache_dir else [])
+    print("%-14s %6s" % ("Network", "funcs") + "".join("%9s" % c for c in columns) + "  (s)")
+    print("-" * (21 + 9 * len(columns)))
+    engine = relay.backend.compile_engine.get()
+    engine.set_cache_dir(None)
+    for network in networks:
+        mod, params, _, _ = get_network(network, batch_size=1)
+        num_funcs = count_fused_functions(mod, params, args.target)
+        res = []
+        for num_threads in counts:
+            os.environ["TVM_NUM_BUILD_THREADS"] = str(num_threads)
+            res.append(min(build_once(mod, params, args.target) for _ in range(args.repeat)))
+        if args.cache_dir:
+            engine.set_cache_dir(args.cache_dir)
+            build_once(mod, params, args.target)  # fill the persistent cache
+            res.append(min(build_once(mod, params, args.target) for _ in range(args.repeat)))
+            engine.set_cache_dir(None)
+        print("%-14s %6d" % (network, num_funcs) + "".join("%9.1f" % r for r in res))
@@ -0,0 +1,114 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Throughput of weight-bound CPU kernels under different memory placements.
+
+Runs dense and batch_matmul with large weights with the default allocation,
+transparent huge pages (TVM_CPU_HUGE_PAGES=thp) and, on multi-node
+machines, interleaved NUMA placement (TVM_CPU_NUMA_POLICY=interleave).
+Each mode runs in its own process since the allocator reads its
+configuration once.
+see README.md for the usage of this script.
+"""
+import argparse
+import os
+import subprocess
+import sys
+
+import numpy as np
+
+import tvm
+from tvm import relay
+import tvm.contrib.graph_runtime as runtime
+
+
+def get_workload(name, size, batch_size):
+    """Return a single-kernel relay function, its input shapes and flop count"""
+    if name == 'dense':
+        data = relay.var("data", shape=(batch_size, size))
+        weight = relay.var("weight", shape=(size, size))
+        out = relay.nn.dense(data, weight)
+        shapes = {"data": (batch_size, size), "weight": (size, size)}
+        flop = 2 * batch_size * size * size
+    elif name == 'batch_matmul':
+        heads = 16
+        dim = size // heads
+        data = relay.var("data", shape=(heads, batch_size, dim))
+        weight = relay.var("weight", shape=(heads, dim * heads, dim))
+        out = relay.nn.batch_matmul(data, weight)
+        shapes = {"data": (heads, batch_size, dim), "weight": (heads, dim * heads, dim)}
+        flop = 2 * heads * batch_size * dim * dim * heads
+    else:
+        raise ValueError("Unsupported workload: " + name)
+    func = relay.Function(relay.analysis.free_vars(out), out)
+    return tvm.IRModule.from_expr(func), shapes, flop
+
+
+def run_one(workload, target, repeat, size, batch_size):
+    """Measure throughput in the current process"""
+    mod, shapes, flop = get_workload(workload, size, batch_size)
+    with relay.build_config(opt_level=3):
+        graph, lib, _ = relay.build(mod, target=target)
+    ctx = tvm.cpu(0)
+    module = runtime.create(graph, lib, ctx)
+    for name, shape in shapes.items():
+        module.set_input(name, tvm.nd.array(np.random.uniform(size=shape).astype("float32")))
+    ftimer = module.module.time_evaluator("run", ctx, number=10, repeat=repeat)
+    ftimer()  # warm up
+    res = np.array(ftimer().results)
+    weight_gb = np.prod(shapes["weight"]) * 4 / 1e9
+    print("%-14s %8.3f %8.2f %8.2f" % (
+        workload, np.mean(res) * 1000, flop / np.mean(res) / 1e9, weight_gb / np.mean(res)))
+    sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--workload", type=str, choices=['dense', 'batch_matmul'], default=None)
+    parser.add_argument("--target", type=str, default="llvm")
+    parser.add_argument("--repeat", type=int, default=20)
+    parser.add_argument("--size", type=int, default=16384,
+                        help="Weight dimension, 16384 gives 1GB of float32 weights.")
+    parser.add_argument("--batch-size", type=int, default=1)
+    parser.add_argument("--child", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    workloads = [args.workload] if args.workload else ['dense', 'batch_matmul']
+    if args.child:
+        for wkl in workloads:
+            run_one(wkl, args.target, args.repeat, args.size, args.batch_size)
+        sys.exit(0)
+
+    modes = [("default", {}),
+             ("thp", {"TVM_CPU_HUGE_PAGES": "thp"}),
+             ("explicit", {"TVM_CPU_HUGE_PAGES": "explicit"})]
+    if len([n for n in os.listdir("/sys/devices/system/node") if n.startswith("node")]) > 1:
+        modes.append(("thp+interleave", {"TVM_CPU_HUGE_PAGES": "thp",
+                                         "TVM_CPU_NUMA_POLICY": "interleave"}))
+    for mode, mode_env in modes:
+        env = dict(os.environ)
+        env.update(mode_env)
+        print("--------------------------------------------------")
+        print(mode)
+        print("%-14s %8s %8s %8s" % ("Workload", "ms", "GFLOPS", "GB/s"))
+        print("--------------------------------------------------")
+        sys.stdout.flush()
+        cmd = [sys.executable, __file__, "--child",
+               "--target", args.target, "--repeat", str(args.repeat),
+               "--size", str(args.size), "--batch-size", str(args.batch_size)]
+        if args.workload:
+            cmd += ["--workload", args.workload]
+        subprocess.check_call(cmd, env=env)
@@ -0,0 +1,122 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Tail latency of CPU kernels under background load.
+
+Compares the static thread pool schedule with work stealing
+(TVM_THREAD_POOL_WORK_STEALING=1). Each mode runs in its own process since
+the thread pool reads its configuration once.
+see README.md for the usage of this script.
+"""
+import argparse
+import multiprocessing
+import os
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+import tvm
+from tvm import relay
+import tvm.contrib.graph_runtime as runtime
+
+
+def get_workload(name, batch_size):
+    """Return a single-kernel relay function and its input shapes"""
+    if name == 'conv2d':
+        data = relay.var("data", shape=(batch_size, 64, 56, 56))
+        weight = relay.var("weight", shape=(64, 64, 3, 3))
+        out = relay.nn.conv2d(data, weight, kernel_size=(3, 3), padding=(1, 1), channels=64)
+        shapes = {"data": (batch_size, 64, 56, 56), "weight": (64, 64, 3, 3)}
+    elif name == 'dense':
+        data = relay.var("data", shape=(batch_size, 1024))
+        weight = relay.var("weight", shape=(4096, 1024))
+        out = relay.nn.dense(data, weight)
+        shapes = {"data": (batch_size, 1024), "weight": (4096, 1024)}
+    else:
+        raise ValueError("Unsupported workload: " + name)
+    func = relay.Function(relay.analysis.free_vars(out), out)
+    return tvm.IRModule.from_expr(func), shapes
+
+
+def busy_loop(stop_time):
+    """Background load, keeps one core busy"""
+    x = 0
+    while time.time() < stop_time:
+        x += 1
+
+
+def run_one(workload, target, repeat, batch_size):
+    """Measure latency percentiles in the current process"""
+    mod, shapes = get_workload(workload, batch_size)
+    with relay.build_config(opt_level=3):
+        graph, lib, params = relay.build(mod, target=target)
+    ctx = tvm.cpu(0)
+    module = runtime.create(graph, lib, ctx)
+    for name, shape in shapes.items():
+        module.set_input(name, tvm.nd.array(np.random.uniform(size=shape).astype("float32")))
+    ftimer = module.module.time_evaluator("run", ctx, number=1, repeat=repeat)
+    ftimer()  # warm up
+    res = np.array(ftimer().results) * 1000
+    print("%-10s %8.3f %8.3f %8.3f %8.3f" % (
+        workload, np.mean(res), np.percentile(res, 50),
+        np.percentile(res, 99), np.max(res)))
+    sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--workload", type=str, choices=['conv2d', 'dense'], default=None)
+    parser.add_argument("--target", type=str, default="llvm")
+    parser.add_argument("--repeat", type=int, default=1000)
+    parser.add_argument("--batch-size", type=int, default=1)
+    parser.add_argument("--background", type=int, default=1,
+                        help="Number of background processes spinning during the measurement.")
+    parser.add_argument("--grain", type=int, default=4,
+                        help="Tasks per worker when work stealing is enabled.")
+    parser.add_argument("--child", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    workloads = [args.workload] if args.workload else ['conv2d', 'dense']
+    if args.child:
+        for wkl in workloads:
+            run_one(wkl, args.target, args.repeat, args.batch_size)
+        sys.exit(0)
+
+    loads = [multiprocessing.Process(target=busy_loop, args=(time.time() + 3600,))
+             for _ in range(args.background)]
+    for p in loads:
+        p.start()
+    try:
+        for mode, stealing in [("static", "0"), ("work-stealing", "1")]:
+            env = dict(os.environ)
+            env["TVM_THREAD_POOL_WORK_STEALING"] = stealing
+            env["TVM_THREAD_POOL_STEAL_GRAIN"] = str(args.grain)
+            print("--------------------------------------------------")
+            print("%s, %d background process(es)" % (mode, args.background))
+            print("%-10s %8s %8s %8s %8s (ms)" % ("Workload", "mean", "p50", "p99", "max"))
+            print("--------------------------------------------------")
+            sys.stdout.flush()
+            cmd = [sys.executable, __file__, "--child",
+                   "--target", args.target, "--repeat", str(args.repeat),
+                   "--batch-size", str(args.batch_size)]
+            if args.workload:
+                cmd += ["--workload", args.workload]
+            subprocess.check_call(cmd, env=env)
+    finally:
+        for p in loads:
+            p.terminate()
@@ -0,0 +1,102 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Throughput of Relay VMs sharing one executable from 1 to N threads.
+
+Each thread drives its own VM through run_async, so the calls do not hold
+the Python GIL. The VMs allocate from the global allocator of the context
+or from allocators of their own.
+see README.md for the usage of this script.
+"""
+import argparse
+import gc
+import os
+import time
+
+import numpy as np
+
+
+def get_workload(num_layers, hidden):
+    """A batch 1 MLP, small kernels so that allocation is a visible cost"""
+    data = relay.var("data", shape=(1, hidden))
+    out = data
+    params = []
+    for i in range(num_layers):
+        weight = relay.var("weight%d" % i, shape=(hidden, hidden))
+        out = relay.nn.relu(relay.nn.dense(out, weight))
+        params.append(weight)
+    mod = tvm.IRModule.from_expr(relay.Function([data] + params, out))
+    args = [np.random.uniform(-1, 1, size=(1, hidden)).astype("float32")]
+    args += [np.random.uniform(-1, 1, size=(hidden, hidden)).astype("float32")
+             for _ in range(num_layers)]
+    return mod, args
+
+
+def run_one(exe, args, num_threads, allocator, requests):
+    """Return the inferences per second of num_threads VMs"""
+    ctx = tvm.cpu()
+    vms = []
+    for _ in range(num_threads):
+        vm = tvm.runtime.vm.VirtualMachine(exe)
+        vm.init(ctx)
+        if allocator == "local":
+            vm.set_allocator("pooled")
+        vm.run(*args)  # warm up
+        vms.append(vm)
+    tic = time.time()
+    futures = [vm.run_async(*args) for _ in range(requests) for vm in vms]
+    for future in futures:
+        future.result()
+    return num_threads * requests / (time.time() - tic)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--threads", type=int, default=os.cpu_count(),
+                        help="The largest number of concurrent VMs.")
+    parser.add_argument("--layers", type=int, default=8)
+    parser.add_argument("--hidden", type=int, default=256)
+    parser.add_argument("--requests", type=int, default=200, help="Calls per VM.")
+    args = parser.parse_args()
+
+    # one runtime thread per VM, and single threaded kernels so that the
+    # VMs do not oversubscribe the cores.
+    os.environ["TVM_NUM_ASYNC_THREADS"] = str(args.threads)
+    os.environ.setdefault("TVM_NUM_THREADS", "1")
+    import tvm
+    from tvm import relay
+
+    mod, inputs = get_workload(args.layers, args.hidden)
+    exe = relay.vm.compile(mod, "llvm")
+    counts = [1]
+    while counts[-1] * 2 <= args.threads:
+        counts.append(counts[-1] * 2)
+    if counts[-1] != args.threads:
+        counts.append(args.threads)
+
+    modes = [("global naive", "naive", "global"),
+             ("global pooled", "pooled", "global"),
+             ("per-VM pooled", "naive", "local")]
+    print("%-16s" % "Allocator" + "".join("%10s" % ("%d thr" % n) for n in counts)
+          + "  (inferences/s)")
+    print("-" * (16 + 10 * len(counts)))
+    for name, global_kind, allocator in modes:
+        gc.collect()
+        tvm.runtime.vm.set_allocator(tvm.cpu(), global_kind)
+        res = [run_one(exe, inputs, n, allocator, args.requests) for n in counts]
+        print("%-16s" % name + "".join("%10.1f" % r for r in res))
+    gc.collect()
+    tvm.runtime.vm.set_allocator(tvm.cpu(), "naive")
@@ -0,0 +1,109 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Dispatch overhead of the Relay VM on control flow heavy models.
+
+The kernels are tiny so the time per executed instruction is dominated
+by the interpreter: register moves, frames of the calls and closures,
+scalar conditions and the packed calls.
+see README.md for the usage of this script.
+"""
+import argparse
+import time
+
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.relay.loops import while_loop
+from tvm.relay.scope_builder import ScopeBuilder
+
+
+def lstm_loop(num_steps, hidden):
+    """An LSTM cell applied num_steps times in a while loop, a closure call per step"""
+    x = relay.var("x", shape=(1, hidden))
+    weight = relay.var("weight", shape=(4 * hidden, 2 * hidden))
+    i = relay.var("i", shape=(), dtype="int32")
+    h = relay.var("h", shape=(1, hidden))
+    c = relay.var("c", shape=(1, hidden))
+
+    def cond(i, h, c):
+        return i < relay.const(num_steps, "int32")
+
+    def body(i, h, c):
+        gates = relay.nn.dense(relay.concatenate([x, h], axis=1), weight)
+        in_gate, forget_gate, cell_gate, out_gate = relay.split(gates, 4, axis=1)
+        new_c = relay.sigmoid(forget_gate) * c + \
+            relay.sigmoid(in_gate) * relay.tanh(cell_gate)
+        new_h = relay.sigmoid(out_gate) * relay.tanh(new_c)
+        return i + relay.const(1, "int32"), new_h, new_c
+
+    loop = while_loop(cond, [i, h, c], body)
+    zeros = relay.zeros(shape=(1, hidden), dtype="float32")
+    out = relay.TupleGetItem(loop(relay.const(0, "int32"), zeros, zeros), 1)
+    mod = tvm.IRModule()
+    mod["main"] = relay.Function([x, weight], out)
+    args = [np.random.uniform(-1, 1, size=(1, hidden)).astype("float32"),
+            np.random.uniform(-1, 1, size=(4 * hidden, 2 * hidden)).astype("float32")]
+    return mod, args
+
+
+def tree_recursion(depth):
+    """fib(n) = fib(n - 1) + fib(n - 2), a global call per node of the call tree"""
+    mod = tvm.IRModule()
+    fib = relay.GlobalVar("fib")
+    n = relay.var("n", shape=(), dtype="int32")
+    sb = ScopeBuilder()
+    with sb.if_scope(relay.less(n, relay.const(2, "int32"))):
+        sb.ret(relay.const(1, "int32"))
+    with sb.else_scope():
+        sb.ret(relay.add(fib(relay.subtract(n, relay.const(1, "int32"))),
+                         fib(relay.subtract(n, relay.const(2, "int32")))))
+    mod[fib] = relay.Function([n], sb.get(), ret_type=relay.TensorType((), "int32"))
+    arg = relay.var("n", shape=(), dtype="int32")
+    mod["main"] = relay.Function([arg], fib(arg))
+    return mod, [np.array(depth, dtype="int32")]
+
+
+def run_one(name, mod, args, repeat):
+    """Measure the time of a call and of each executed instruction"""
+    exe = relay.vm.compile(mod, "llvm")
+    vm = tvm.runtime.vm.VirtualMachine(exe)
+    vm.init(tvm.cpu())
+    get_num_executed = vm.mod["get_num_executed"]
+    vm.run(*args)  # warm up
+    start = get_num_executed()
+    tic = time.time()
+    for _ in range(repeat):
+        vm.run(*args)
+    elapsed = time.time() - tic
+    num_instrs = (get_num_executed() - start) / repeat
+    print("%-16s %10.3f %12d %10.1f" % (
+        name, elapsed / repeat * 1e3, num_instrs, elapsed / repeat / num_instrs * 1e9))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--steps", type=int, default=100, help="Steps of the LSTM loop.")
+    parser.add_argument("--hidden", type=int, default=8, help="Hidden size of the LSTM.")
+    parser.add_argument("--depth", type=int, default=15, help="Argument of the recursion.")
+    parser.add_argument("--repeat", type=int, default=20)
+    args = parser.parse_args()
+
+    print("%-16s %10s %12s %10s" % ("Workload", "ms/call", "instrs/call", "ns/instr"))
+    print("--------------------------------------------------")
+    run_one("lstm_loop", *lstm_loop(args.steps, args.hidden), repeat=args.repeat)
+    run_one("tree_recursion", *tree_recursion(args.depth), repeat=args.repeat)
@@ -60,13 +60,18 @@
 #include <tvm/node/container.h>
 #include <tvm/ir/error.h>
 #include <tvm/ir/module.h>
+#include <chrono>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace tvm {
 namespace transform {
 
-// Forward declare for TraceFunc.
+// Forward declare for TraceFunc and PassProfilerNode.
 class PassInfo;
+class Pass;
+class PassContext;
 
 /*! \brief A callback for tracing passes, useful for debugging and logging.
  *
@@ -76,6 +81,91 @@ using TraceFunc =
                                 const PassInfo& ctx,
                                 bool is_before)>;
 
+/*!
+ * \brief PassProfilerNode records the passes run by Sequential.
+ *
+ *  Each record holds the wall time of the pass, the number of IR nodes
+ *  reachable from the module before and after it, and how much the peak
+ *  resident memory of the process grew while it ran. Counting the nodes is
+ *  linear in the size of the module, and the counts of the nested passes
+ *  are part of the time of the enclosing Sequential.
+ * \sa PassProfiler
+ */
+class PassProfilerNode : public Object {
+ public:
+  /*! \brief The measurements of a pass. */
+  struct Record {
+    /*! \brief The name of the pass. */
+    std::string name;
+    /*! \brief The number of enclosing passes which are recorded. */
+    int depth{0};
+    /*! \brief The start time of the pass since the profiler was created. */
+    int64_t start_us{0};
+    /*! \brief The wall time of the pass. */
+    int64_t duration_us{0};
+    /*! \brief The number of IR nodes before the pass. */
+    int64_t nodes_before{0};
+    /*! \brief The number of IR nodes after the pass. */
+    int64_t nodes_after{0};
+    /*!
+     * \brief The growth of the peak resident memory of the process during the pass.
+     *
+     *  The peak never decreases, so a pass which stays below an earlier peak
+     *  records 0, and so do all the passes when the peak is unknown.
+     */
+    int64_t memory_growth_kb{0};
+  };
+
+  /*!
+   * \brief Run a pass and record it.
+   * \param pass The pass.
+   * \param mod The module to run the pass on.
+   * \param pass_ctx The context of the pass.
+   * \return The updated module.
+   */
+  TVM_DLL IRModule Run(const Pass& pass, const IRModule& mod, const PassContext& pass_ctx);
+  /*! \return The records ordered by start time. */
+  TVM_DLL std::vector<Record> GetRecords() const;
+  /*! \brief Remove all the records. */
+  TVM_DLL void Clear();
+  /*! \return The records as a JSON array of objects. */
+  TVM_DLL std::string AsJSON() const;
+  /*! \return The records in the Chrome trace event format, for chrome://tracing. */
+  TVM_DLL std::string AsChromeTrace() const;
+
+  void VisitAttrs(AttrVisitor* v) {}
+
+  static constexpr const char* _type_key = "relay.PassProfiler";
+  TVM_DECLARE_FINAL_OBJECT_INFO(PassProfilerNode, Object);
+
+ private:
+  /*! \brief The time all the records start from. */
+  std::chrono::steady_clock::time_point origin_{std::chrono::steady_clock::now()};
+  /*! \brief The records in order of start time. */
+  std::vector<Record> records_;
+  /*! \brief The number of passes being recorded. */
+  int depth_{0};
+  /*! \brief The number of calls to Clear, the records of older runs are dropped. */
+  uint64_t generation_{0};
+  /*! \brief Protects the records. */
+  mutable std::mutex mutex_;
+};
+
+/*!
+ * \brief Managed reference to PassProfilerNode.
+ * \sa PassProfilerNode
+ */
+class PassProfiler : public ObjectRef {
+ public:
+  /*!
+   * \brief Create an empty profiler.
+   * \return The created profiler.
+   */
+  TVM_DLL static PassProfiler Create();
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(PassProfiler, ObjectRef, PassProfilerNode);
+};
+
 /*!
  * \brief PassContextNode contains the information that a pass can rely on,
  * such as analysis results.
@@ -101,6 +191,9 @@ class PassContextNode : public Object {
 
   TraceFunc trace_func;
 
+  /*! \brief The profiler of the passes run by Sequential, undefined to disable it. */
+  PassProfiler profiler;
+
   PassContextNode() = default;
 
   void VisitAttrs(AttrVisitor* v) {
@@ -108,6 +201,7 @@ class PassContextNode : public Object {
     v->Visit("fallback_device", &fallback_device);
     v->Visit("required_pass", &required_pass);
     v->Visit("disabled_pass", &disabled_pass);
+    v->Visit("profiler", &profiler);
   }
 
   static constexpr const char* _type_key = "relay.PassContext";
@@ -26,10 +26,14 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace tvm {
 namespace runtime {
+
+class ThreadPool;
+
 namespace threading {
 
 /*!
@@ -81,6 +85,18 @@ class ThreadGroup {
    */
   int Configure(AffinityMode mode, int nthreads, bool exclude_worker0);
 
+  /*!
+   * \brief configure the CPU id affinity with an explicit list of CPUs
+   *
+   * \param cpus The CPU ids, worker i is bound to cpus[i % cpus.size()].
+   * \param exclude_worker0 Whether to use the main thread as a worker.
+   *        If `true`, cpus[0] is left to the thread running worker 0 and
+   *        the affinity of the main thread is not changed.
+   *
+   * \return The number of workers to use.
+   */
+  int Configure(const std::vector<unsigned int>& cpus, bool exclude_worker0);
+
  private:
   Impl* impl_;
 };
@@ -95,6 +111,86 @@ void Yield();
  */
 int MaxConcurrency();
 
+/*!
+ * \brief Get the CPUs of each NUMA node from /sys/devices/system/node.
+ *
+ *  Within a node, the first hardware thread of each physical core comes
+ *  first. When the topology is unknown, all CPUs are in a single node.
+ *
+ * \param physical_only Whether to leave out the extra hyper-threads of each core.
+ * \return The CPU ids of each node.
+ */
+std::vector<std::vector<unsigned int> > NumaNodeCpus(bool physical_only = false);
+
+/*!
+ * \brief Create a named thread pool with its own worker threads.
+ *
+ *  Parallel launches of a thread are sent to its own thread-local pool
+ *  by default. A named pool is shared by every thread that binds it with
+ *  ThreadPoolScope, launches from different threads are serialized, so
+ *  several models can each be given a disjoint set of cores.
+ *
+ * \param name The name of the pool, must not be registered yet.
+ * \param num_threads The number of threads, including the launching thread
+ *        which runs task 0. 0 means cpus.size(), or MaxConcurrency() when
+ *        cpus is empty.
+ * \param cpus The CPUs the workers are bound to, empty to use the default
+ *        affinity policy.
+ */
+void CreateThreadPool(const std::string& name,
+                      int num_threads,
+                      const std::vector<unsigned int>& cpus);
+
+/*!
+ * \brief Remove a named thread pool from the registry.
+ *  The pool is destroyed when the last ThreadPoolScope or runtime using it is released.
+ * \param name The name of the pool.
+ */
+void RemoveThreadPool(const std::string& name);
+
+/*!
+ * \brief Get a named thread pool.
+ * \param name The name of the pool.
+ * \return The pool, nullptr when name is empty.
+ */
+std::shared_ptr<ThreadPool> GetThreadPool(const std::string& name);
+
+/*!
+ * \brief Get the number of workers of the pool the parallel launches of
+ *  the calling thread go to, see ThreadPoolScope.
+ * \return The largest number of tasks a launch can be split into.
+ */
+int CurrentConcurrency();
+
+/*!
+ * \brief RAII scope which sends the parallel launches of the current
+ *  thread to a given pool.
+ */
+class ThreadPoolScope {
+ public:
+  /*!
+   * \brief Enter the scope.
+   * \param pool The pool to use, nullptr keeps the current one.
+   */
+  explicit ThreadPoolScope(const std::shared_ptr<ThreadPool>& pool);
+  ~ThreadPoolScope();
+
+ private:
+  ThreadPool* prev_;
+};
+
+/*!
+ * \brief Run a task on one of the threads the runtime keeps for asynchronous calls.
+ *
+ *  Tasks with the same key run one at a time in submission order, tasks
+ *  with different keys run concurrently. The number of threads is read from
+ *  TVM_NUM_ASYNC_THREADS, 4 by default.
+ *
+ * \param key The key serializing the tasks, usually the object they run on.
+ * \param task The task, it must not throw.
+ */
+void RunAsync(const void* key, std::function<void()> task);
+
 
 }  // namespace threading
 }  // namespace runtime
@@ -28,7 +28,9 @@
 #include <tvm/runtime/memory.h>
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -36,8 +38,13 @@
 
 namespace tvm {
 namespace runtime {
+
+class MappedFile;
+
 namespace vm {
 
+class Allocator;
+
 /*!
  * \brief An object representing a closure. This object is used by both the
  * Relay VM and interpreter.
@@ -113,6 +120,7 @@ enum class Opcode {
   LoadConsti = 14U,
   Fatal = 15U,
   AllocStorage = 16U,
+  AllocStaticTensor = 17U,
 };
 
 /*! \brief A single virtual machine instruction.
@@ -240,6 +248,20 @@ struct Instruction {
       /*! \brief The hint of the dtype. */
       DLDataType dtype_hint;
     } alloc_storage;
+    struct /* AllocStaticTensor Operands */ {
+      /*! \brief The static storage slot, unique in the executable. */
+      Index slot;
+      /*! \brief The size of the storage. */
+      Index allocation_size;
+      /*! \brief The alignment of the storage. */
+      Index alignment;
+      /*! \brief The number of dimensions. */
+      uint32_t ndim;
+      /*! \brief The shape of tensor. */
+      int64_t* shape;
+      /*! \brief The datatype of tensor, also the dtype hint of the storage. */
+      DLDataType dtype;
+    } alloc_static_tensor;
   };
 
   /*!
@@ -382,8 +404,29 @@ struct Instruction {
   static Instruction AllocStorage(RegName size, RegName alignment,
                                   DLDataType dtype_hint, RegName dst);
 
+  /*!
+   * \brief Allocate a tensor in a storage of its own, both of static size.
+   *
+   *  This fuses the AllocStorage and AllocTensor emitted for a static shape,
+   *  with the sizes as immediates. The VM keeps the storages of each slot
+   *  and reuses one once no tensor refers to it anymore.
+   *
+   * \param slot The static storage slot, unique in the executable.
+   * \param allocation_size The size of the storage.
+   * \param alignment The alignment of the storage.
+   * \param shape The shape of the tensor.
+   * \param dtype The dtype of the tensor.
+   * \param dst The destination register.
+   * \return The alloc static tensor instruction.
+   */
+  static Instruction AllocStaticTensor(Index slot, Index allocation_size, Index alignment,
+                                       const std::vector<int64_t>& shape, DLDataType dtype,
+                                       RegName dst);
+
   Instruction();
   Instruction(const Instruction& instr);
+  /*! \brief Take over the operands of instr, which is left as a Fatal. */
+  Instruction(Instruction&& instr) noexcept;
   Instruction& operator=(const Instruction& instr);
   ~Instruction();
 
@@ -436,18 +479,23 @@ struct VMFrame {
   /*! \brief A pointer into the caller function's instructions. */
   const Instruction* code;
 
-  /*! \brief Statically allocated space for objects */
-  std::vector<ObjectRef> register_file;
+  /*! \brief The first register of the frame in the register stack of the VM. */
+  Index register_base;
+
+  /*! \brief The number of registers of the frame. */
+  Index register_file_size;
 
   /*! \brief Register in caller's frame to put return value */
   RegName caller_return_register;
 
-  VMFrame(Index pc, Index func_index, Index args, const Instruction* code, Index register_file_size)
+  VMFrame(Index pc, Index func_index, Index args, const Instruction* code,
+          Index register_base, Index register_file_size)
       : pc(pc),
         func_index(func_index),
         args(args),
         code(code),
-        register_file(register_file_size),
+        register_base(register_base),
+        register_file_size(register_file_size),
         caller_return_register(0) {}
 };
 
@@ -462,6 +510,9 @@ struct VMFrame {
  *  - Primitive name section, containing the function name of the primitive ops
  *  used by the virtual machine.
  *  - Code section, handling the VM functions and bytecode.
+ *
+ * An executable is not modified by the virtual machines running it, any
+ * number of them can share one, each used by one thread at a time.
  */
 class Executable : public ModuleNode {
  public:
@@ -494,6 +545,41 @@ class Executable : public ModuleNode {
    */
   static runtime::Module Load(const std::string& code, const runtime::Module lib);
 
+  /*!
+   * \brief Serialize the executable into the mapped format.
+   *
+   *  The file starts with a versioned header and a table of sections, each
+   *  aligned to 64 bytes: globals, primitive names, code, the index of the
+   *  constants and their data. The code is a flat array of opcodes and
+   *  operands, the constants are stored aligned so they can be used in place.
+   *
+   * \return The binary representation of the VM.
+   */
+  TVMByteArray SaveMapped();
+
+  /*!
+   * \brief Load an executable saved by SaveMapped.
+   *
+   *  The file is mapped, the constants are created on first use as arrays
+   *  pointing into the mapping, so loading does not read them.
+   *
+   * \param file_name The name of the file.
+   * \param lib The compiled runtime library.
+   *
+   * \return exe The constructed executable.
+   */
+  static runtime::Module LoadMapped(const std::string& file_name, const runtime::Module lib);
+
+  /*!
+   * \brief Get a constant of the pool.
+   * \param index The index of the constant.
+   * \return The constant, a CPU array pointing into the file for a mapped executable.
+   */
+  ObjectRef GetConstant(Index index) const;
+
+  /*! \return The number of constants in the pool. */
+  size_t NumConstants() const;
+
   /*!
    * \brief Get the serialized form of the `functions`. This is
    * essentially bytecode serialization.
@@ -566,6 +652,11 @@ class Executable : public ModuleNode {
   /*! \brief The runtime module/library that contains both the host and also the device
    * code when executing on non-CPU devices. */
   runtime::Module lib;
+  /*!
+   * \brief Serializes the lookup of the primitive functions in `lib` by the
+   *  virtual machines loading this executable, modules may build them lazily.
+   */
+  mutable std::mutex lib_mutex;
   /*! \brief The global constant pool. */
   std::vector<ObjectRef> constants;
   /*! \brief A map from globals (as strings) to their index in the function map. */
@@ -634,8 +725,20 @@ class Executable : public ModuleNode {
    */
   void LoadCodeSection(dmlc::Stream* strm);
 
+  /*! \brief A constant in the file of a mapped executable. */
+  struct MappedConstant {
+    DLDataType dtype;
+    std::vector<int64_t> shape;
+    char* data;
+    uint64_t nbytes;
+  };
+
   /*! \brief The serialized bytecode. */
   std::string code_;
+  /*! \brief The file of a mapped executable, nullptr otherwise. */
+  std::shared_ptr<MappedFile> mapped_file_;
+  /*! \brief The constants of a mapped executable, in place of `constants`. */
+  std::vector<MappedConstant> mapped_constants_;
 };
 
 /*!
@@ -648,6 +751,11 @@ class Executable : public ModuleNode {
  * enabling one to easily pass around VMs, execute them on
  * multiple threads, or serialize them to disk or over the
  * wire.
+ *
+ * A virtual machine must not be invoked from several threads at once.
+ * Concurrent inference uses one virtual machine per thread on a shared
+ * executable; giving each its own allocator avoids the lock of the global
+ * allocator of the context.
  */
 class VirtualMachine : public runtime::ModuleNode {
  public:
@@ -690,6 +798,29 @@ class VirtualMachine : public runtime::ModuleNode {
   std::vector<PackedFunc> packed_funcs_;
   /*! \brief The current stack of call frames. */
   std::vector<VMFrame> frames_;
+  /*!
+   * \brief The registers of the frames, one after the other.
+   *
+   *  The stack keeps its size when the frames are popped, so calls reuse
+   *  the registers of the previous ones instead of allocating a register
+   *  file each time.
+   */
+  std::vector<ObjectRef> registers_;
+  /*! \brief The registers of the current frame, inside registers_. */
+  ObjectRef* frame_registers_{nullptr};
+  /*! \brief The scratch arguments of InvokePacked, reused across calls. */
+  std::vector<ObjectRef> packed_args_;
+  /*! \brief The scratch argument values of InvokePacked. */
+  std::vector<TVMValue> packed_values_;
+  /*! \brief The scratch argument type codes of InvokePacked. */
+  std::vector<int> packed_codes_;
+  /*! \brief The number of instructions executed by the VM. */
+  uint64_t num_executed_{0};
+  /*!
+   * \brief The storages kept for each static storage slot. A storage no
+   *  other object refers to is free to hold the next tensor of the slot.
+   */
+  std::vector<std::vector<ObjectRef> > static_storage_;
   /*! \brief The fuction table index of the current function. */
   Index func_index_;
   /*! \brief The current pointer to the code section. */
@@ -704,13 +835,22 @@ class VirtualMachine : public runtime::ModuleNode {
   std::unordered_map<std::string, std::vector<ObjectRef>> inputs_;
   /*! \brief The set of TVM contexts the VM is currently executing on. */
   std::vector<TVMContext> ctxs_;
+  /*! \brief The thread pool bound to this VM, nullptr for the default one. */
+  std::shared_ptr<ThreadPool> thread_pool_;
+  /*! \brief The allocator of this VM, nullptr for the global one of the context. */
+  std::shared_ptr<Allocator> allocator_;
 
-  /*! \brief Push a call frame on to the call stack. */
+  /*!
+   * \brief Push a call frame on to the call stack.
+   *
+   *  The registers of the frame are taken from the top of registers_,
+   *  references into registers_ are invalidated.
+   */
   void PushFrame(Index arg_count, Index ret_pc, const VMFunction& vm_func);
 
   /*!
-   * \brief Pop a frame off the call stack.
-   * \return The number of frames left.
+   * \brief Pop a frame off the call stack, releasing the objects in its registers.
+   * \return The number of frames before popping.
    */
   Index PopFrame();
 
@@ -721,12 +861,19 @@ class VirtualMachine : public runtime::ModuleNode {
    */
   inline void WriteRegister(RegName reg, const ObjectRef& obj);
 
+  /*!
+   * \brief Move an object into a VM register.
+   * \param reg The register to write to.
+   * \param obj The object to write to.
+   */
+  inline void WriteRegister(RegName reg, ObjectRef&& obj);
+
   /*!
    * \brief Read a VM register.
    * \param reg The register to read from.
-   * \return The read object.
+   * \return The read object, valid until the next frame is pushed.
    */
-  inline ObjectRef ReadRegister(RegName reg) const;
+  inline const ObjectRef& ReadRegister(RegName reg) const;
 
   /*!
    * \brief Read a VM register and cast it to int32_t
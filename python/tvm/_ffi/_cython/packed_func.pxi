@@ -23,7 +23,7 @@ from ..base import string_types, py2cerror
 from ..runtime_ctypes import DataType, TVMContext, TVMByteArray
 
 
-cdef void tvm_callback_finalize(void* fhandle):
+cdef void tvm_callback_finalize(void* fhandle) with gil:
     local_pyfunc = <object>(fhandle)
     Py_DECREF(local_pyfunc)
 
@@ -225,12 +225,16 @@ cdef inline int FuncCall3(void* chandle,
                           int* ret_tcode) except -1:
     cdef TVMValue[3] values
     cdef int[3] tcodes
+    cdef int c_api_ret_code
     nargs = len(args)
     temp_args = []
     for i in range(nargs):
         make_arg(args[i], &values[i], &tcodes[i], temp_args)
-    CALL(TVMFuncCall(chandle, &values[0], &tcodes[0],
-                     nargs, ret_val, ret_tcode))
+    # release the GIL, the call may wait for threads which call back into python
+    with nogil:
+        c_api_ret_code = TVMFuncCall(chandle, &values[0], &tcodes[0],
+                                     nargs, ret_val, ret_tcode)
+    CALL(c_api_ret_code)
     return 0
 
 cdef inline int FuncCall(void* chandle,
@@ -245,13 +249,16 @@ cdef inline int FuncCall(void* chandle,
 
     cdef vector[TVMValue] values
     cdef vector[int] tcodes
+    cdef int c_api_ret_code
     values.resize(max(nargs, 1))
     tcodes.resize(max(nargs, 1))
     temp_args = []
     for i in range(nargs):
         make_arg(args[i], &values[i], &tcodes[i], temp_args)
-    CALL(TVMFuncCall(chandle, &values[0], &tcodes[0],
-                     nargs, ret_val, ret_tcode))
+    with nogil:
+        c_api_ret_code = TVMFuncCall(chandle, &values[0], &tcodes[0],
+                                     nargs, ret_val, ret_tcode)
+    CALL(c_api_ret_code)
     return 0
 
 
@@ -15,6 +15,8 @@
 # specific language governing permissions and limitations
 # under the License.
 """Minimum graph runtime that executes graph containing TVM PackedFunc."""
+import concurrent.futures
+import json
 import numpy as np
 import tvm._ffi
 
@@ -63,6 +65,111 @@ def create(graph_json_str, libmod, ctx):
     return GraphModule(fcreate(graph_json_str, libmod, *device_type_id))
 
 
+def create_model(graph_json_str, libmod, ctx):
+    """Create a model whose parameters are shared by the executors created from it.
+
+    Parameters
+    ----------
+    graph_json_str : str or graph class
+        The graph to be deployed in json format output by json graph.
+
+    libmod : tvm.runtime.Module
+        The module of the corresponding function
+
+    ctx : TVMContext or list of TVMContext
+        The context to deploy the module, as in create.
+
+    Returns
+    -------
+    graph_model : GraphModel
+        The model, load its parameters then create the executors.
+    """
+    if not isinstance(graph_json_str, string_types):
+        try:
+            graph_json_str = graph_json_str._tvm_graph_json()
+        except AttributeError:
+            raise ValueError("Type %s is not supported" % type(graph_json_str))
+
+    ctx, num_rpc_ctx, device_type_id = get_device_ctx(libmod, ctx)
+
+    if num_rpc_ctx == len(ctx):
+        fcreate = ctx[0]._rpc_sess.get_function("tvm.graph_runtime.create_model")
+    else:
+        fcreate = tvm._ffi.get_global_func("tvm.graph_runtime.create_model")
+
+    return GraphModel(fcreate(graph_json_str, libmod, *device_type_id))
+
+
+def create_batcher(graph_module, input_names, max_latency_ms=1.0):
+    """Batch the concurrent requests on a graph runtime.
+
+    The graph is compiled for a fixed batch on the first axis of the
+    given inputs and of all the outputs. Each request holds some rows
+    of the batch. The requests are run together once they fill the
+    batch, or once the oldest one waited for max_latency_ms, the
+    missing rows are padded with zeros.
+
+    Parameters
+    ----------
+    graph_module : GraphModule
+        The runtime, with its parameters set. It must not be used
+        directly afterwards.
+
+    input_names : list of str
+        The inputs given by each request.
+
+    max_latency_ms : float
+        How long a request waits for the batch to fill.
+
+    Returns
+    -------
+    batcher : GraphBatcher
+        The batcher, its run method can be called from many threads.
+    """
+    fcreate = tvm._ffi.get_global_func("tvm.graph_runtime.create_batcher")
+    module = fcreate(graph_module.module, int(max_latency_ms * 1000), *input_names)
+    return GraphBatcher(module, graph_module, input_names)
+
+
+def create_pipeline(graph_model, num_stages, pools=None, num_slots=0, profile_repeat=10):
+    """Stream micro-batches through a graph split into stages.
+
+    The operators are measured, then split in graph order into stages
+    of about the same cost. Each stage runs on its own thread and thread
+    pool, and a micro-batch moves to the next stage once the previous
+    one is done with it, so the stages run different micro-batches at
+    the same time.
+
+    Parameters
+    ----------
+    graph_model : GraphModel
+        The model, with its parameters loaded.
+
+    num_stages : int
+        The number of stages.
+
+    pools : list of str, optional
+        The thread pool of each stage, created by
+        :py:func:`tvm.runtime.create_thread_pool`, for example one per
+        socket with :py:func:`tvm.runtime.create_numa_thread_pools`.
+
+    num_slots : int
+        The number of micro-batches in flight, 0 for num_stages + 1.
+
+    profile_repeat : int
+        The number of runs measuring the cost of the operators.
+
+    Returns
+    -------
+    pipeline : GraphPipeline
+        The pipeline.
+    """
+    pools = list(pools) if pools else []
+    fcreate = tvm._ffi.get_global_func("tvm.graph_runtime.create_pipeline")
+    module = fcreate(graph_model.module, num_stages, num_slots, profile_repeat, *pools)
+    return GraphPipeline(module)
+
+
 def get_device_ctx(libmod, ctx):
     """Parse and validate all the device context(s).
 
@@ -111,6 +218,195 @@ def get_device_ctx(libmod, ctx):
     return ctx, num_rpc_ctx, device_type_id
 
 
+class GraphModel(object):
+    """Wrapper of the model runtime module.
+
+    The parameters are loaded once and shared read-only by all the
+    executors created from the model, each executor only allocates
+    its own intermediate buffers.
+
+    Parameters
+    ----------
+    module : tvm.runtime.Module
+        The internal tvm module that holds the graph and the parameters.
+
+    Examples
+    --------
+    .. code-block:: python
+
+       model = graph_runtime.create_model(graph, lib, tvm.cpu())
+       model.load_params(tvm.relay.save_param_dict(params))
+       executors = [model.create_executor() for _ in range(num_threads)]
+    """
+
+    def __init__(self, module):
+        self.module = module
+        self._load_params = module["load_params"]
+        self._load_mapped_params = module["load_mapped_params"]
+        self._create_executor = module["create_executor"]
+
+    def load_params(self, params_bytes):
+        """Load the parameters from serialized byte array of parameter dict.
+
+        Parameters
+        ----------
+        params_bytes : bytearray
+            The serialized parameter dict.
+        """
+        self._load_params(bytearray(params_bytes))
+
+    def load_mapped_params(self, file_name):
+        """Load the parameters from a file saved by relay.save_mapped_param_dict.
+
+        Parameters
+        ----------
+        file_name : str
+            The path of the parameter file.
+        """
+        self._load_mapped_params(file_name)
+
+    def create_executor(self):
+        """Create an executor sharing the parameters of the model.
+
+        The shared parameters cannot be set on the executor, and the
+        arrays returned by get_input for them must not be written.
+
+        Returns
+        -------
+        graph_module : GraphModule
+            The executor.
+        """
+        return GraphModule(self._create_executor())
+
+
+class GraphBatcher(object):
+    """Wrapper of the batcher runtime module.
+
+    Parameters
+    ----------
+    module : tvm.runtime.Module
+        The internal batcher module.
+
+    graph_module : GraphModule
+        The batched runtime.
+
+    input_names : list of str
+        The inputs given by each request.
+    """
+
+    def __init__(self, module, graph_module, input_names):
+        self.module = module
+        self.input_names = list(input_names)
+        self.batch_size = module["get_batch_size"]()
+        self._run = module["run"]
+        self._get_stats = module["get_stats"]
+        self._reset_stats = module["reset_stats"]
+        self._outputs = [graph_module.get_output(i)
+                         for i in range(graph_module.get_num_outputs())]
+
+    def run(self, **inputs):
+        """Run one request, blocks until its batch ran.
+
+        Parameters
+        ----------
+        inputs : dict of str to NDArray or numpy.ndarray
+            The inputs of the request, each with the same number of rows.
+
+        Returns
+        -------
+        outputs : list of NDArray
+            The rows of the outputs for this request.
+        """
+        args = [tvm.nd.array(inputs[name]) if not isinstance(inputs[name], tvm.nd.NDArray)
+                else inputs[name] for name in self.input_names]
+        rows = args[0].shape[0]
+        outputs = [tvm.nd.empty((rows,) + tuple(out.shape[1:]), out.dtype)
+                   for out in self._outputs]
+        self._run(*(args + outputs))
+        return outputs
+
+    def stats(self):
+        """Get the request, batch and latency counters.
+
+        Returns
+        -------
+        stats : dict
+            The counters since the last reset.
+        """
+        return json.loads(self._get_stats())
+
+    def reset_stats(self):
+        """Reset the counters."""
+        self._reset_stats()
+
+
+class GraphPipeline(object):
+    """Wrapper of the pipeline runtime module.
+
+    Parameters
+    ----------
+    module : tvm.runtime.Module
+        The internal pipeline module.
+    """
+
+    def __init__(self, module):
+        self.module = module
+        self.num_slots = module["get_num_slots"]()
+        self._submit = module["submit"]
+        self._wait = module["wait"]
+        self._get_stats = module["get_stats"]
+        self._reset_stats = module["reset_stats"]
+        get_output = module["get_output"]
+        self._outputs = [get_output(i) for i in range(module["get_num_outputs"]())]
+
+    def run(self, batches):
+        """Run micro-batches through the stages.
+
+        Parameters
+        ----------
+        batches : list of dict of str to NDArray or numpy.ndarray
+            The inputs of each micro-batch.
+
+        Returns
+        -------
+        outputs : list of list of NDArray
+            The outputs of each micro-batch, in order.
+        """
+        results = []
+        for i, inputs in enumerate(batches):
+            if i >= self.num_slots:
+                results.append(self._wait_one())
+            args = []
+            for name, value in inputs.items():
+                if not isinstance(value, tvm.nd.NDArray):
+                    value = tvm.nd.array(value)
+                args += [name, value]
+            self._submit(*args)
+        while len(results) < len(batches):
+            results.append(self._wait_one())
+        return results
+
+    def _wait_one(self):
+        outputs = [tvm.nd.empty(out.shape, out.dtype) for out in self._outputs]
+        self._wait(*outputs)
+        return outputs
+
+    def stats(self):
+        """Get the stages and their utilization.
+
+        Returns
+        -------
+        stats : dict
+            The node range, estimated cost and busy time of each stage,
+            since the last reset.
+        """
+        return json.loads(self._get_stats())
+
+    def reset_stats(self):
+        """Reset the counters."""
+        self._reset_stats()
+
+
 class GraphModule(object):
     """Wrapper runtime module.
 
@@ -133,11 +429,18 @@ class GraphModule(object):
         self.module = module
         self._set_input = module["set_input"]
         self._run = module["run"]
+        self._run_async = module["run_async"]
         self._get_output = module["get_output"]
         self._get_input = module["get_input"]
         self._get_num_outputs = module["get_num_outputs"]
         self._load_params = module["load_params"]
+        self._load_mapped_params = module["load_mapped_params"]
         self._share_params = module["share_params"]
+        self._set_thread_pool = module["set_thread_pool"]
+        self._set_inter_op_parallelism = module["set_inter_op_parallelism"]
+        self._set_memory_arena = module["set_memory_arena"]
+        self._get_storage_bytes = module["get_storage_bytes"]
+        self._clone = module["clone"]
 
     def set_input(self, key=None, value=None, **params):
         """Set inputs to the module via kwargs
@@ -175,6 +478,34 @@ class GraphModule(object):
             self.set_input(**input_dict)
         self._run()
 
+    def run_async(self, **input_dict):
+        """Run forward execution of the graph on a runtime thread.
+
+        The runs of a module are done in order. The inputs must not be
+        set again before the returned future is done.
+
+        Parameters
+        ----------
+        input_dict: dict of str to NDArray
+            List of input values to be feed to
+
+        Returns
+        -------
+        future : concurrent.futures.Future
+            Done when the run finished, get the outputs afterwards.
+        """
+        if input_dict:
+            self.set_input(**input_dict)
+        future = concurrent.futures.Future()
+
+        def _done(error):
+            if error:
+                future.set_exception(tvm.error.TVMError(error))
+            else:
+                future.set_result(None)
+        self._run_async(_done)
+        return future
+
     def get_num_outputs(self):
         """Get the number of outputs from the graph
 
@@ -243,6 +574,20 @@ class GraphModule(object):
         """
         self._load_params(bytearray(params_bytes))
 
+    def load_mapped_params(self, file_name):
+        """Load parameters from a file saved by relay.save_mapped_param_dict.
+
+        The file is mapped into memory, parameters on CPU point into it
+        without a copy so that processes loading the same file share
+        the memory.
+
+        Parameters
+        ----------
+        file_name : str
+            The path of the parameter file.
+        """
+        self._load_mapped_params(file_name)
+
     def share_params(self, other, params_bytes):
         """Share parameters from pre-existing GraphRuntime instance.
 
@@ -256,6 +601,74 @@ class GraphModule(object):
         """
         self._share_params(other.module, bytearray(params_bytes))
 
+    def set_thread_pool(self, name):
+        """Run the parallel operators of this module on a named thread pool.
+
+        Parameters
+        ----------
+        name : str
+            The pool created by :py:func:`tvm.runtime.create_thread_pool`,
+            empty to use the pool of the calling thread.
+        """
+        self._set_thread_pool(name)
+
+    def set_inter_op_parallelism(self, num_streams):
+        """Set the number of operators that may run at the same time.
+
+        Operators whose inputs are ready run concurrently on the thread pool,
+        their parallel loops use the remaining workers.
+
+        Parameters
+        ----------
+        num_streams : int
+            The number of concurrent operators, 1 runs them in graph order.
+        """
+        self._set_inter_op_parallelism(num_streams)
+
+    def set_memory_arena(self, enable=True, workspace_bytes=-1):
+        """Place all the storage and workspaces of the module in one allocation.
+
+        The storage is only laid out by this call. Arrays returned by
+        ``get_input`` or ``get_output`` before it and inputs set with
+        ``set_input_zero_copy`` must be fetched or set again. Workspaces of
+        the parallel tasks running on the worker threads, and of all the
+        operators when the inter-op parallelism is above 1, still come from
+        the workspace pool.
+
+        Parameters
+        ----------
+        enable : bool
+            Whether to use the arena.
+
+        workspace_bytes : int
+            The size of the workspace region. When negative, the module runs
+            once with the current inputs to measure it.
+        """
+        self._set_memory_arena(enable, workspace_bytes)
+
+    def get_storage_bytes(self):
+        """Get the bytes allocated for the inputs, outputs and intermediates.
+
+        Returns
+        -------
+        nbytes : int
+            The bytes, without the workspace region of the arena.
+        """
+        return self._get_storage_bytes()
+
+    def clone(self):
+        """Create a module with the same graph and a copy of its storage.
+
+        The copy includes the parameters and the inputs, so each request
+        thread can run its own clone.
+
+        Returns
+        -------
+        module : GraphModule
+            The new module.
+        """
+        return GraphModule(self._clone())
+
     def __getitem__(self, key):
         """Get internal module function
 
@@ -19,6 +19,7 @@
 import types
 import inspect
 import functools
+import json
 
 import tvm._ffi
 
@@ -51,6 +52,91 @@ class PassInfo(Object):
             _ffi_transform_api.PassInfo, opt_level, name, required)
 
 
+@tvm._ffi.register_object("relay.PassProfiler")
+class PassProfiler(Object):
+    """Record the passes run by Sequential in a PassContext.
+
+    Each record holds the wall time of the pass, the number of IR nodes
+    reachable from the module before and after it, and how much the peak
+    resident memory of the process grew in KB while it ran. The peak never
+    decreases, so a pass staying below an earlier peak records 0, and so do
+    all the passes when the peak is unknown.
+
+    Examples
+    --------
+    .. code-block:: python
+
+        profiler = tvm.transform.PassProfiler()
+        with relay.build_config(opt_level=3, profiler=profiler):
+            relay.build(mod, target="llvm", params=params)
+        print(profiler.summary())
+        profiler.save("passes.json", fmt="chrome")
+    """
+    def __init__(self):
+        self.__init_handle_by_constructor__(_ffi_transform_api.PassProfiler)
+
+    def records(self):
+        """Get the records ordered by start time.
+
+        Returns
+        -------
+        records : List[dict]
+            The name, depth, start_us, duration_us, nodes_before, nodes_after
+            and memory_growth_kb of each pass. The depth is the number of
+            enclosing recorded passes.
+        """
+        return json.loads(_ffi_transform_api.PassProfilerAsJSON(self))
+
+    def save(self, path, fmt="json"):
+        """Save the records to a file.
+
+        Parameters
+        ----------
+        path : str
+            The path of the file.
+
+        fmt : str
+            "json" for the list of records, "chrome" for the Chrome trace
+            event format which chrome://tracing and Perfetto open.
+        """
+        if fmt == "json":
+            data = _ffi_transform_api.PassProfilerAsJSON(self)
+        elif fmt == "chrome":
+            data = _ffi_transform_api.PassProfilerAsChromeTrace(self)
+        else:
+            raise ValueError("Unknown format %s, expect json or chrome" % fmt)
+        with open(path, "w") as f:
+            f.write(data)
+
+    def summary(self):
+        """Summarize the time of the passes by name.
+
+        Returns
+        -------
+        summary : str
+            A table of the passes sorted by total time. The share is the
+            time over the time of the outermost recorded passes.
+        """
+        records = self.records()
+        total = sum(r["duration_us"] for r in records if r["depth"] == 0) or 1
+        stats = {}
+        for r in records:
+            stat = stats.setdefault(r["name"], [0, 0, 0])
+            stat[0] += 1
+            stat[1] += r["duration_us"]
+            stat[2] = max(stat[2], r["memory_growth_kb"])
+        lines = ["%-32s %6s %12s %7s %14s" % (
+            "Pass", "calls", "time(ms)", "share", "mem growth(MB)")]
+        for name, (calls, time_us, growth) in sorted(stats.items(), key=lambda kv: -kv[1][1]):
+            lines.append("%-32s %6d %12.2f %6.1f%% %14.1f" % (
+                name, calls, time_us / 1000.0, 100.0 * time_us / total, growth / 1024.0))
+        return "\n".join(lines)
+
+    def clear(self):
+        """Remove all the records."""
+        _ffi_transform_api.PassProfilerClear(self)
+
+
 @tvm._ffi.register_object("relay.PassContext")
 class PassContext(Object):
     """The basis where a Relay optimization/analysis runs on.
@@ -70,13 +156,20 @@ class PassContext(Object):
 
     disabled_pass : Optional[Union[List[str], Set[str], Tuple[str]]]
         The list of passes that are disabled.
+
+    trace : Optional[Callable[[IRModule, PassInfo, bool], None]]
+        A tracing function for debugging or introspection.
+
+    profiler : Optional[PassProfiler]
+        Record the passes run by Sequential in the context.
     """
     def __init__(self,
                  opt_level=2,
                  fallback_device=_nd.cpu(),
                  required_pass=None,
                  disabled_pass=None,
-                 trace=None):
+                 trace=None,
+                 profiler=None):
         if isinstance(fallback_device, str):
             fallback_device = _nd.context(fallback_device).device_type
         elif isinstance(fallback_device, TVMContext):
@@ -97,7 +190,7 @@ class PassContext(Object):
 
         self.__init_handle_by_constructor__(_ffi_transform_api.PassContext, opt_level,
                                             fallback_device, required,
-                                            disabled, trace)
+                                            disabled, trace, profiler)
 
     def __enter__(self):
         _ffi_transform_api.EnterPassContext(self)
@@ -19,6 +19,7 @@
 from __future__ import absolute_import
 
 import logging
+import os
 import numpy as np
 import tvm
 from tvm import te
@@ -297,6 +298,23 @@ class CompileEngine(Object):
             msg += "--------------------------\n"
             raise RuntimeError(msg)
 
+    def lower_all(self, source_funcs, target=None):
+        """Lower a batch of source_funcs concurrently.
+
+        The functions are scheduled and lowered on up to TVM_NUM_BUILD_THREADS
+        threads and cached, later calls of lower return the cached results.
+
+        Parameters
+        ----------
+        source_funcs : List[Union[tvm.relay.Function, CCacheKey]]
+            The source relay functions.
+
+        target : tvm.Target
+            The target platform.
+        """
+        keys = [_get_cache_key(func, target) for func in source_funcs]
+        _backend._CompileEngineLowerAll(self, keys)
+
     def lower_shape_func(self, source_func, target=None):
         key = _get_cache_key(source_func, target)
         return _backend._CompileEngineLowerShapeFunc(self, key)
@@ -324,6 +342,35 @@ class CompileEngine(Object):
         """clear the existing cached functions"""
         _backend._CompileEngineClear(self)
 
+    def set_cache_dir(self, path):
+        """Persist the lowered functions in a directory shared across processes.
+
+        A function whose source, target, build config and TVM version match
+        an entry of the directory is loaded instead of lowered. The AutoTVM
+        dispatch context is not part of the key, use one directory per
+        tuning configuration. Only functions for CPU targets are cached, the
+        kernels of device targets are always lowered. The directory defaults
+        to the environment variable TVM_COMPILE_CACHE_DIR.
+
+        Parameters
+        ----------
+        path : str or None
+            The directory, created when missing. None disables the cache.
+        """
+        if path:
+            os.makedirs(path, exist_ok=True)
+        _backend._CompileEngineSetCacheDir(self, path or "")
+
+    def get_cache_dir(self):
+        """Get the directory of the persistent cache.
+
+        Returns
+        -------
+        path : str or None
+            The directory, None when the cache is disabled.
+        """
+        return _backend._CompileEngineGetCacheDir(self) or None
+
     def items(self):
         """List items in the cache.
 
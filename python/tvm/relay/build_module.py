@@ -64,9 +64,27 @@ def _convert_param_map(params):
 class BuildModule(object):
     """Build an IR module to run on TVM graph runtime. This class is used
     to expose the `RelayBuildModule` APIs implemented in C++.
+
+    Parameters
+    ----------
+    incremental : bool
+        Whether each build reuses the code generated by the previous builds
+        of this object. The fused functions a module has in common with the
+        previously built ones are not lowered and their code is not generated
+        again, so rebuilding a module after changing a few layers only
+        generates code for the changed fused functions. The module returned
+        by the build imports the modules generated by the builds.
+
+    memory_plan : str
+        How the storage of the graph is planned. "token" reuses whole buffers
+        of the same size class, "offset" places all the tensors of a single
+        device graph at byte offsets of one address space, so tensors of
+        different sizes share bytes once they are dead.
     """
-    def __init__(self):
+    def __init__(self, incremental=False, memory_plan="token"):
         self.mod = _build_module._BuildModule()
+        self.mod["set_incremental"](incremental)
+        self.mod["set_memory_plan"](memory_plan)
         self._get_graph_json = self.mod["get_graph_json"]
         self._get_module = self.mod["get_module"]
         self._build = self.mod["build"]
@@ -180,7 +198,7 @@ class BuildModule(object):
         return ret
 
 
-def build(mod, target=None, target_host=None, params=None):
+def build(mod, target=None, target_host=None, params=None, memory_plan="token"):
     """Helper function that builds a Relay function to run on TVM graph
     runtime.
 
@@ -207,6 +225,10 @@ def build(mod, target=None, target_host=None, params=None):
         Input parameters to the graph that do not change
         during inference time. Used for constant folding.
 
+    memory_plan : str
+        How the storage of the graph is planned, "token" or "offset".
+        See :py:class:`BuildModule`.
+
     Returns
     -------
     graph_json : str
@@ -246,7 +268,7 @@ def build(mod, target=None, target_host=None, params=None):
         tophub_context = autotvm.util.EmptyContext()
 
     with tophub_context:
-        bld_mod = BuildModule()
+        bld_mod = BuildModule(memory_plan=memory_plan)
         graph_json, mod, params = bld_mod.build(mod, target, target_host, params)
     return graph_json, mod, params
 
@@ -21,6 +21,7 @@ import tvm._ffi
 
 
 _save_param_dict = tvm._ffi.get_global_func("tvm.relay._save_param_dict")
+_save_mapped_param_dict = tvm._ffi.get_global_func("tvm.relay._save_mapped_param_dict")
 _load_param_dict = tvm._ffi.get_global_func("tvm.relay._load_param_dict")
 
 def save_param_dict(params):
@@ -59,6 +60,39 @@ def save_param_dict(params):
     return _save_param_dict(*args)
 
 
+def save_mapped_param_dict(params):
+    """Save parameter dictionary in the mapped format.
+
+    The tensors are stored aligned in the file, so that GraphModule
+    "load_mapped_params" can map the file and use them in place.
+
+    Parameters
+    ----------
+    params : dict of str to NDArray
+        The parameter dictionary.
+
+    Returns
+    -------
+    param_bytes: bytearray
+        Serialized parameters, to be written to a file.
+
+    Examples
+    --------
+    .. code-block:: python
+
+       graph, lib, params = tvm.relay.build(func, target=target, params=params)
+       with open("deploy.params", "wb") as fo:
+           fo.write(tvm.relay.save_mapped_param_dict(params))
+       module = graph_runtime.create(graph, lib, tvm.cpu(0))
+       module.load_mapped_params("deploy.params")
+    """
+    args = []
+    for k, v in params.items():
+        args.append(k)
+        args.append(tvm.nd.array(v))
+    return _save_mapped_param_dict(*args)
+
+
 def load_param_dict(param_bytes):
     """Load parameter dictionary to binary bytes.
 
@@ -36,7 +36,8 @@ def build_config(opt_level=2,
                  fallback_device=_nd.cpu(),
                  required_pass=None,
                  disabled_pass=None,
-                 trace=None):
+                 trace=None,
+                 profiler=None):
     """Configure the build behavior by setting config variables.
 
     Parameters
@@ -74,13 +75,16 @@ def build_config(opt_level=2,
     trace: Callable[[IRModule, PassInfo, bool], None]
         A tracing function for debugging or introspection.
 
+    profiler: tvm.transform.PassProfiler, optional
+        Record the time, IR size and peak memory of the passes run by Sequential.
+
     Returns
     -------
     pass_context: PassContext
         The pass context for optimizations.
     """
     return PassContext(opt_level, fallback_device, required_pass,
-                       disabled_pass, trace)
+                       disabled_pass, trace, profiler)
 
 
 @register_relay_node
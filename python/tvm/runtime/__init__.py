@@ -28,3 +28,5 @@ from .object_generic import convert_to_object, convert, const
 from .ndarray import context, cpu, gpu, opencl, cl, vulkan, metal, mtl
 from .ndarray import vpi, rocm, opengl, ext_dev, micro_dev
 from .module import load_module, enabled, system_lib
+from .thread_pool import create_thread_pool, create_numa_thread_pools, remove_thread_pool
+from .thread_pool import get_thread_pool_stats, reset_thread_pool_stats
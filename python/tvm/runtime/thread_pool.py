@@ -0,0 +1,93 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Named thread pools of the CPU runtime."""
+import json
+
+from . import _ffi_api
+
+
+def create_thread_pool(name, num_threads=0, cpus=None):
+    """Create a named thread pool with its own worker threads.
+
+    Runtimes bound to the pool with ``set_thread_pool`` run their parallel
+    operators on it instead of on the pool of the calling thread, so several
+    models can serve concurrently on disjoint cores.
+
+    Parameters
+    ----------
+    name : str
+        The name of the pool.
+
+    num_threads : int
+        The number of threads, including the calling thread which runs the
+        first task. 0 means ``len(cpus)``, or all cores when cpus is not given.
+
+    cpus : list of int, optional
+        The CPU ids the workers are bound to.
+    """
+    cpus = list(cpus) if cpus else []
+    _ffi_api.CreateThreadPool(name, num_threads, *cpus)
+
+
+def create_numa_thread_pools(prefix="numa"):
+    """Create one named thread pool per NUMA node.
+
+    Each pool runs on the physical cores of one node, so a model bound to it
+    keeps its parallel loops and first-touch memory on a single socket.
+
+    Parameters
+    ----------
+    prefix : str
+        The pools are named prefix followed by the node index.
+
+    Returns
+    -------
+    names : list of str
+        The names of the pools, in node order.
+    """
+    num_nodes = _ffi_api.CreateNumaThreadPools(prefix)
+    return ["%s%d" % (prefix, i) for i in range(num_nodes)]
+
+
+def remove_thread_pool(name):
+    """Remove a named thread pool.
+
+    The pool is destroyed once no runtime is bound to it.
+
+    Parameters
+    ----------
+    name : str
+        The name of the pool.
+    """
+    _ffi_api.RemoveThreadPool(name)
+
+
+def get_thread_pool_stats():
+    """Get the wait counters of the thread pool used by the calling thread.
+
+    Returns
+    -------
+    stats : dict
+        The wait policy, the average idle gap between launches and, for each
+        worker, the time spent spinning, parked and working in microseconds.
+    """
+    return json.loads(_ffi_api.GetThreadPoolStats())
+
+
+def reset_thread_pool_stats():
+    """Reset the wait counters of the thread pool used by the calling thread."""
+    _ffi_api.ResetThreadPoolStats()
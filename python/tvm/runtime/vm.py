@@ -20,6 +20,7 @@ The Relay Virtual Machine runtime.
 
 Implements a Python interface to executing the compiled VM object.
 """
+import concurrent.futures
 import numpy as np
 
 import tvm
@@ -57,12 +58,64 @@ def convert(args):
     return cargs
 
 
+def set_allocator(ctx, kind="best_fit", arena_size=2 << 20, high_water=0,
+                  release="high_water"):
+    """Select the allocator the VM uses for the storage of a context.
+
+    It must be called while no VM buffer of the context is alive.
+
+    Parameters
+    ----------
+    ctx : TVMContext
+        The context of the allocations.
+
+    kind : str
+        "naive" allocates every buffer from the device, "pooled" keeps freed
+        buffers for requests of the same size, "best_fit" carves buffers out
+        of larger arenas, reusing freed blocks of any size.
+
+    arena_size : int
+        The minimum size of the arenas requested from the device, for best_fit.
+
+    high_water : int
+        The reserved bytes above which free arenas are released, 0 means no
+        limit, for best_fit.
+
+    release : str
+        When fully free arenas go back to the device, for best_fit:
+        "keep", "high_water" or "eager".
+    """
+    _ffi_api.SetVMAllocator(ctx.device_type, ctx.device_id, kind,
+                            arena_size, high_water, release)
+
+
+def get_allocator_memory(ctx, reserved=False):
+    """Get the bytes of the live VM buffers of a context.
+
+    Parameters
+    ----------
+    ctx : TVMContext
+        The context of the allocations.
+
+    reserved : bool
+        Whether to get the bytes held from the device instead, including
+        the free blocks the allocator keeps.
+
+    Returns
+    -------
+    nbytes : int
+        The bytes in use, or held.
+    """
+    return _ffi_api.GetVMAllocatorMemory(ctx.device_type, ctx.device_id, reserved)
+
+
 class Executable(object):
     """Relay VM executable"""
     def __init__(self, mod):
         self.mod = mod
         self._function_params = {}
         self._save = self.mod["save"]
+        self._save_mapped = self.mod["save_mapped"]
         self._get_lib = self.mod["get_lib"]
         self._get_bytecode = self.mod["get_bytecode"]
         self._get_stats = self.mod["get_stats"]
@@ -165,6 +218,48 @@ from tvm import te
 
         return Executable(_ffi_api.Load_Executable(bytecode, lib))
 
+    def save_mapped(self, path):
+        """Save the bytecode and the constants in the mapped format.
+
+        The sections of the file are aligned so that :py:func:`load_mapped`
+        maps it instead of reading it: the code is decoded in place and the
+        constants are used from the mapping on first use.
+
+        Parameters
+        ----------
+        path : str
+            The file to write.
+
+        Notes
+        -----
+        The library is not part of the file, save it with
+        ``exe.lib.export_library``.
+        """
+        with open(path, "wb") as fo:
+            fo.write(self._save_mapped())
+
+    @staticmethod
+    def load_mapped(path, lib):
+        """Load an executable saved by :py:func:`save_mapped`.
+
+        Parameters
+        ----------
+        path : str
+            The file saved by save_mapped.
+
+        lib : :py:class:`~tvm.runtime.Module`
+            The runtime module that contains the generated code.
+
+        Returns
+        -------
+        exec: Executable
+            The executable, its constants stay in the mapped file.
+        """
+        if lib is not None and not isinstance(lib, tvm.runtime.Module):
+            raise TypeError("lib is expected to be the type of tvm.runtime.Module" +
+                            ", but received {}".format(type(lib)))
+        return Executable(_ffi_api.Load_MappedExecutable(path, lib))
+
     @property
     def lib(self):
         """Get the library that contains hardware dependent code.
@@ -281,7 +376,10 @@ class VirtualMachine(object):
         self._exec = mod
         self._init = self.mod["init"]
         self._invoke = self.mod["invoke"]
+        self._invoke_async = self.mod["invoke_async"]
         self._set_input = self.mod["set_input"]
+        self._set_thread_pool = self.mod["set_thread_pool"]
+        self._set_allocator = self.mod["set_allocator"]
 
     def init(self, ctx):
         """Initialize the context in the VM.
@@ -294,6 +392,54 @@ class VirtualMachine(object):
         args = [ctx.device_type, ctx.device_id]
         self._init(*args)
 
+    def set_thread_pool(self, name):
+        """Run the parallel operators of this VM on a named thread pool.
+
+        Parameters
+        ----------
+        name : str
+            The pool created by :py:func:`tvm.runtime.create_thread_pool`,
+            empty to use the pool of the calling thread.
+        """
+        self._set_thread_pool(name)
+
+    def set_allocator(self, kind="pooled", arena_size=2 << 20, high_water=0,
+                      release="high_water"):
+        """Give this VM an allocator of its own for the context it runs on.
+
+        Virtual machines sharing an executable can run concurrently, one
+        thread each. With their own allocators they do not contend on the
+        global allocator of the context. It must be called after init.
+
+        Parameters
+        ----------
+        kind : str
+            "global" to use the allocator of the context again, otherwise
+            the kind of the allocator as in :py:func:`set_allocator`.
+
+        arena_size : int
+            The minimum size of the arenas requested from the device, for best_fit.
+
+        high_water : int
+            The reserved bytes above which free arenas are released, 0 means no
+            limit, for best_fit.
+
+        release : str
+            When fully free arenas go back to the device, for best_fit:
+            "keep", "high_water" or "eager".
+        """
+        self._set_allocator(kind, arena_size, high_water, release)
+
+    def get_allocator_memory(self):
+        """Get the bytes held by the allocator of this VM.
+
+        Returns
+        -------
+        nbytes : int
+            The bytes in use.
+        """
+        return self.mod["get_allocator_memory"]()
+
     def set_input(self, func_name, *args, **kwargs):
         """Set the input to a function.
 
@@ -347,6 +493,58 @@ class VirtualMachine(object):
             self.set_input(func_name, *args, **kwargs)
         return self._invoke(func_name)
 
+    def invoke_async(self, func_name, *args, **kwargs):
+        """Invoke a function on a runtime thread.
+
+        The calls of a virtual machine are done in order. The inputs are
+        taken when this is called, they can be set again right away.
+
+        Parameters
+        ----------
+        func_name : str
+            The name of the function.
+
+        args : list[tvm.runtime.NDArray] or list[np.ndarray]
+            The arguments to the function.
+
+        kwargs: dict of str to tvm.runtime.NDArray or np.ndarray
+            Named arguments to the function.
+
+        Returns
+        -------
+        future : concurrent.futures.Future
+            The future of the output.
+        """
+        if args or kwargs:
+            self.set_input(func_name, *args, **kwargs)
+        future = concurrent.futures.Future()
+
+        def _done(result, error):
+            if error:
+                future.set_exception(tvm.error.TVMError(error))
+            else:
+                future.set_result(result)
+        self._invoke_async(func_name, _done)
+        return future
+
+    def run_async(self, *args, **kwargs):
+        """Run the main function on a runtime thread.
+
+        Parameters
+        ----------
+        args : list[tvm.runtime.NDArray] or list[np.ndarray]
+            The arguments to the function.
+
+        kwargs: dict of str to tvm.runtime.NDArray or np.ndarray
+            Named arguments to the function.
+
+        Returns
+        -------
+        future : concurrent.futures.Future
+            The future of the output.
+        """
+        return self.invoke_async("main", *args, **kwargs)
+
     def run(self, *args, **kwargs):
         """Run the main function.
 
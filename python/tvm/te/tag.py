@@ -15,20 +15,29 @@
 # specific language governing permissions and limitations
 # under the License.
 """Tag class for TVM operators."""
+import threading
 import warnings
 from tvm._ffi.base import decorate
 
 class TagScope(object):
     """Tag scope object to set tag for operators, working as context
     manager and decorator both. See also tag_scope.
+
+    The current scope is per thread, the compile engine lowers functions
+    on several threads.
     """
-    _current = None
+    _local = threading.local()
+
+    @classmethod
+    def _get(cls):
+        return getattr(cls._local, "current", None)
 
     @classmethod
     def get_current(cls):
-        if cls._current:
-            cls._current.accessed = True
-        return cls._current
+        current = cls._get()
+        if current:
+            current.accessed = True
+        return current
 
     def __init__(self, tag):
         self._old_scope = None
@@ -36,17 +45,17 @@ class TagScope(object):
         self.accessed = False
 
     def __enter__(self):
-        if TagScope._current is not None:
+        if TagScope._get() is not None:
             raise ValueError("nested op_tag is not allowed for now")
-        self._old_scope = TagScope._current
-        TagScope._current = self
+        self._old_scope = TagScope._get()
+        TagScope._local.current = self
         return self
 
     def __exit__(self, ptype, value, trace):
         assert self._old_scope is None
         if not self.accessed:
             warnings.warn("Tag '%s' declared via TagScope was not used." % (self.tag,))
-        TagScope._current = self._old_scope
+        TagScope._local.current = self._old_scope
 
     def __call__(self, fdecl):
         def tagged_fdecl(func, *args, **kwargs):
@@ -21,18 +21,26 @@
  * \file src/ir/transform.cc
  * \brief Infrastructure for transformation passes.
  */
+#include <dmlc/json.h>
 #include <dmlc/thread_local.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/device_api.h>
+#include <tvm/node/reflection.h>
 #include <tvm/node/repr_printer.h>
 #include <tvm/ir/transform.h>
 
 // TODO(tqchen): Update to use String container after it is merged.
 #include <tvm/tir/expr.h>
 
+#include <map>
+#include <sstream>
 #include <stack>
 #include <unordered_set>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
 namespace tvm {
 namespace transform {
 
@@ -91,6 +99,184 @@ void PassContext::Trace(const IRModule& module, const PassInfo& info, bool is_be
     }
 }
 
+namespace {
+/*! \brief Count the objects reachable from a node through its attributes. */
+class NodeCounter : public AttrVisitor {
+ public:
+  int64_t Count(const ObjectRef& root) {
+    Push(root.get());
+    while (!stack_.empty()) {
+      Object* node = stack_.back();
+      stack_.pop_back();
+      if (node->IsInstance<ArrayNode>()) {
+        for (const auto& it : static_cast<ArrayNode*>(node)->data) {
+          Push(it.get());
+        }
+      } else if (node->IsInstance<MapNode>()) {
+        for (const auto& kv : static_cast<MapNode*>(node)->data) {
+          Push(kv.first.get());
+          Push(kv.second.get());
+        }
+      } else if (node->IsInstance<StrMapNode>()) {
+        for (const auto& kv : static_cast<StrMapNode*>(node)->data) {
+          Push(kv.second.get());
+        }
+      } else {
+        reflection_->VisitAttrs(node, this);
+      }
+    }
+    return static_cast<int64_t>(visited_.size());
+  }
+
+  void Visit(const char* key, double* value) final {}
+  void Visit(const char* key, int64_t* value) final {}
+  void Visit(const char* key, uint64_t* value) final {}
+  void Visit(const char* key, int* value) final {}
+  void Visit(const char* key, bool* value) final {}
+  void Visit(const char* key, std::string* value) final {}
+  void Visit(const char* key, void** value) final {}
+  void Visit(const char* key, DataType* value) final {}
+  void Visit(const char* key, runtime::NDArray* value) final {}
+  void Visit(const char* key, ObjectRef* value) final {
+    Push(value->get());
+  }
+
+ private:
+  void Push(const Object* node) {
+    if (node == nullptr || !visited_.insert(node).second) return;
+    stack_.push_back(const_cast<Object*>(node));
+  }
+
+  ReflectionVTable* reflection_ = ReflectionVTable::Global();
+  std::unordered_set<const Object*> visited_;
+  std::vector<Object*> stack_;
+};
+
+/*! \brief The peak resident memory of the process in KB, 0 when unknown. */
+int64_t PeakMemoryKB() {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+  return static_cast<int64_t>(usage.ru_maxrss) / 1024;
+#else
+  return static_cast<int64_t>(usage.ru_maxrss);
+#endif
+#else
+  return 0;
+#endif
+}
+
+/*! \brief A complete event of the Chrome trace event format. */
+struct TraceEvent {
+  PassProfilerNode::Record record;
+
+  void Save(dmlc::JSONWriter* writer) const {
+    std::map<std::string, int64_t> args{
+      {"nodes_before", record.nodes_before},
+      {"nodes_after", record.nodes_after},
+      {"memory_growth_kb", record.memory_growth_kb}};
+    writer->BeginObject();
+    writer->WriteObjectKeyValue("name", record.name);
+    writer->WriteObjectKeyValue("cat", std::string("pass"));
+    writer->WriteObjectKeyValue("ph", std::string("X"));
+    writer->WriteObjectKeyValue("ts", record.start_us);
+    writer->WriteObjectKeyValue("dur", record.duration_us);
+    writer->WriteObjectKeyValue("pid", 0);
+    writer->WriteObjectKeyValue("tid", 0);
+    writer->WriteObjectKeyValue("args", args);
+    writer->EndObject();
+  }
+};
+}  // namespace
+
+PassProfiler PassProfiler::Create() {
+  return PassProfiler(make_object<PassProfilerNode>());
+}
+
+IRModule PassProfilerNode::Run(const Pass& pass,
+                               const IRModule& mod,
+                               const PassContext& pass_ctx) {
+  Record record;
+  record.name = pass->Info()->name;
+  record.nodes_before = NodeCounter().Count(mod);
+  int64_t peak_before = PeakMemoryKB();
+  auto start = std::chrono::steady_clock::now();
+  record.start_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(start - origin_).count();
+  size_t index;
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    record.depth = depth_++;
+    index = records_.size();
+    generation = generation_;
+    records_.push_back(record);
+  }
+  IRModule updated_mod;
+  try {
+    updated_mod = pass(mod, pass_ctx);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --depth_;
+    throw;
+  }
+  record.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+  record.nodes_after = NodeCounter().Count(updated_mod);
+  record.memory_growth_kb = PeakMemoryKB() - peak_before;
+  std::lock_guard<std::mutex> lock(mutex_);
+  --depth_;
+  // the record is gone if the profiler was cleared while the pass ran.
+  if (generation == generation_) records_[index] = record;
+  return updated_mod;
+}
+
+std::vector<PassProfilerNode::Record> PassProfilerNode::GetRecords() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return records_;
+}
+
+void PassProfilerNode::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  records_.clear();
+  ++generation_;
+}
+
+std::string PassProfilerNode::AsJSON() const {
+  std::ostringstream os;
+  dmlc::JSONWriter writer(&os);
+  writer.BeginArray();
+  for (const Record& record : GetRecords()) {
+    writer.WriteArraySeperator();
+    writer.BeginObject();
+    writer.WriteObjectKeyValue("name", record.name);
+    writer.WriteObjectKeyValue("depth", record.depth);
+    writer.WriteObjectKeyValue("start_us", record.start_us);
+    writer.WriteObjectKeyValue("duration_us", record.duration_us);
+    writer.WriteObjectKeyValue("nodes_before", record.nodes_before);
+    writer.WriteObjectKeyValue("nodes_after", record.nodes_after);
+    writer.WriteObjectKeyValue("memory_growth_kb", record.memory_growth_kb);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  return os.str();
+}
+
+std::string PassProfilerNode::AsChromeTrace() const {
+  std::ostringstream os;
+  dmlc::JSONWriter writer(&os);
+  std::vector<TraceEvent> events;
+  for (const Record& record : GetRecords()) {
+    events.push_back(TraceEvent{record});
+  }
+  writer.BeginObject();
+  writer.WriteObjectKeyValue("displayTimeUnit", std::string("ms"));
+  writer.WriteObjectKeyValue("traceEvents", events);
+  writer.EndObject();
+  return os.str();
+}
+
 class ModulePass;
 
 /*!
@@ -312,6 +498,12 @@ Pass GetPass(const std::string& pass_name) {
   return (*f)();
 }
 
+// Run a pass of a Sequential, recorded by the profiler of the context if any.
+inline IRModule RunPass(const Pass& pass, const IRModule& mod, const PassContext& pass_ctx) {
+  if (!pass_ctx->profiler.defined()) return pass(mod, pass_ctx);
+  return pass_ctx->profiler->Run(pass, mod, pass_ctx);
+}
+
 // TODO(zhiics): we currenlty only sequentially execute each pass in
 // a Sequential without the consideration of their orders. The phase
 // ordering problem needs to be handled in the future.
@@ -326,9 +518,9 @@ IRModule SequentialNode::operator()(const IRModule& module,
     for (const auto& it : pass_info->required) {
       const auto* name = it.as<tvm::tir::StringImmNode>();
       CHECK(name);
-      mod = GetPass(name->value)(mod, pass_ctx);
+      mod = RunPass(GetPass(name->value), mod, pass_ctx);
     }
-    mod = pass(mod, pass_ctx);
+    mod = RunPass(pass, mod, pass_ctx);
   }
   return mod;
 }
@@ -429,14 +621,37 @@ TVM_REGISTER_GLOBAL("transform.PassContext")
   tvm::Array<tvm::PrimExpr> required = args[2];
   tvm::Array<tvm::PrimExpr> disabled = args[3];
   TraceFunc trace_func = args[4];
+  PassProfiler profiler;
+  if (args.num_args > 5) profiler = args[5];
   pctx->opt_level = opt_level;
   pctx->fallback_device = fallback_device;
   pctx->required_pass = std::move(required);
   pctx->disabled_pass = std::move(disabled);
   pctx->trace_func = std::move(trace_func);
+  pctx->profiler = std::move(profiler);
   *ret = pctx;
 });
 
+TVM_REGISTER_NODE_TYPE(PassProfilerNode);
+
+TVM_REGISTER_GLOBAL("transform.PassProfiler")
+.set_body_typed(PassProfiler::Create);
+
+TVM_REGISTER_GLOBAL("transform.PassProfilerAsJSON")
+.set_body_typed([](PassProfiler profiler) {
+  return profiler->AsJSON();
+});
+
+TVM_REGISTER_GLOBAL("transform.PassProfilerAsChromeTrace")
+.set_body_typed([](PassProfiler profiler) {
+  return profiler->AsChromeTrace();
+});
+
+TVM_REGISTER_GLOBAL("transform.PassProfilerClear")
+.set_body_typed([](PassProfiler profiler) {
+  profiler->Clear();
+});
+
 TVM_STATIC_IR_FUNCTOR(ReprPrinter, vtable)
 .set_dispatch<PassContextNode>([](const ObjectRef& ref, ReprPrinter* p) {
   auto* node = static_cast<const PassContextNode*>(ref.get());
@@ -29,8 +29,13 @@
 #include <tvm/relay/transform.h>
 #include <tvm/relay/qnn/transform.h>
 #include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "utils.h"
+#include "../../runtime/composite_module.h"
 
 namespace tvm {
 namespace relay {
@@ -51,6 +56,17 @@ struct BuildOutput {
   std::unordered_map<std::string, tvm::runtime::NDArray> params;
 };
 
+/*!
+ * \brief Module generated by one incremental build
+ *
+ */
+struct BuildPart {
+  /*! \brief The module built from the functions */
+  runtime::Module mod;
+  /*! \brief The lowered functions built into the module */
+  std::vector<LoweredFunc> funcs;
+};
+
 /*!
  * \brief GraphCodegen module wrapper
  *
@@ -63,8 +79,8 @@ struct GraphCodegen {
   }
   ~GraphCodegen() {}
 
-  void Init(runtime::Module* m, TargetsMap targets) {
-    CallFunc("init", m, targets);
+  void Init(runtime::Module* m, TargetsMap targets, const std::string& memory_plan) {
+    CallFunc("init", m, targets, memory_plan);
   }
 
   void Codegen(const Function& func) {
@@ -135,6 +151,18 @@ class RelayBuildModule : public runtime::ModuleNode {
         CHECK_EQ(args.num_args, 3);
         this->Build(args[0], args[1], args[2]);
       });
+    } else if (name == "set_incremental") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->incremental_ = args[0];
+        if (!this->incremental_) this->parts_.clear();
+      });
+    } else if (name == "set_memory_plan") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        std::string memory_plan = args[0];
+        CHECK(memory_plan == "token" || memory_plan == "offset")
+            << "Unknown memory plan " << memory_plan << ", expect token or offset";
+        this->memory_plan_ = memory_plan;
+      });
     } else if (name == "list_params") {
       return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
         *rv = this->ListParamNames();
@@ -444,7 +472,7 @@ class RelayBuildModule : public runtime::ModuleNode {
 
     // Generate code for the updated function.
     graph_codegen_ = std::unique_ptr<GraphCodegen>(new GraphCodegen());
-    graph_codegen_->Init(nullptr, targets_);
+    graph_codegen_->Init(nullptr, targets_, memory_plan_);
     graph_codegen_->Codegen(func);
 
     ret_.graph_json = graph_codegen_->GetJSON();
@@ -453,6 +481,8 @@ class RelayBuildModule : public runtime::ModuleNode {
     auto lowered_funcs = graph_codegen_->GetLoweredFunc();
     if (lowered_funcs.size() == 0) {
       LOG(WARNING) << "no lowered funcs exist in the compiled module";
+    } else if (incremental_ && !IsSystemLib()) {
+      ret_.mod = BuildIncremental(lowered_funcs);
     } else {
       ret_.mod = tvm::build(
         lowered_funcs,
@@ -475,6 +505,96 @@ class RelayBuildModule : public runtime::ModuleNode {
     }
   }
 
+  /*!
+   * \brief Build the lowered functions reusing the modules of the previous builds.
+   *
+   *  The compile engine returns the same lowered functions for the fused
+   *  functions a new module has in common with the previous ones. A module
+   *  built before is reused when it holds some of these functions and no
+   *  other function under the name of a needed one. Only the remaining
+   *  functions are built, into a new module. The modules are imported by a
+   *  new composite module, so the returned module of a previous build is
+   *  left untouched.
+   *
+   * \param lowered_funcs The lowered functions of each target.
+   * \return The composite module holding all the functions.
+   */
+  runtime::Module BuildIncremental(const Map<std::string, Array<LoweredFunc> >& lowered_funcs) {
+    // The code of the functions also depends on the host and the build config.
+    std::ostringstream os;
+    os << target_host_ << "\n" << BuildConfig::Current();
+    if (os.str() != parts_config_) {
+      parts_.clear();
+      parts_config_ = os.str();
+    }
+    std::unordered_map<std::string, LoweredFunc> needed;
+    for (const auto& kv : lowered_funcs) {
+      for (const auto& f : kv.second) {
+        needed[f->name] = f;
+      }
+    }
+    std::vector<BuildPart> parts;
+    std::unordered_set<std::string> built;
+    for (const auto& part : parts_) {
+      bool used = false;
+      bool stale = false;
+      for (const auto& f : part.funcs) {
+        auto it = needed.find(f->name);
+        if (it == needed.end()) continue;
+        if (it->second.same_as(f)) {
+          used = true;
+        } else {
+          stale = true;
+        }
+      }
+      if (used && !stale) {
+        parts.push_back(part);
+        for (const auto& f : part.funcs) {
+          built.insert(f->name);
+        }
+      }
+    }
+    Map<std::string, Array<LoweredFunc> > changed;
+    BuildPart part;
+    for (const auto& kv : lowered_funcs) {
+      Array<LoweredFunc> funcs;
+      for (const auto& f : kv.second) {
+        if (built.count(f->name)) continue;
+        funcs.push_back(f);
+        part.funcs.push_back(f);
+      }
+      if (funcs.size() != 0) {
+        changed.Set(kv.first, funcs);
+      }
+    }
+    if (!part.funcs.empty()) {
+      part.mod = tvm::build(changed, target_host_, BuildConfig::Current());
+      parts.push_back(part);
+    }
+    parts_ = std::move(parts);
+
+    runtime::Module mod = runtime::CompositeModuleCreate();
+    for (const auto& it : parts_) {
+      mod.Import(it.mod);
+    }
+    return mod;
+  }
+
+  /*!
+   * \brief Check whether the code is built as a system library.
+   *
+   * \return Whether any target asks for a system library.
+   */
+  bool IsSystemLib() const {
+    if (target_host_.defined() && target_host_->str().find("--system-lib") != std::string::npos) {
+      return true;
+    }
+    for (const auto& kv : targets_) {
+      if (kv.second->str().find("--system-lib") != std::string::npos) return true;
+    }
+    return false;
+  }
+
  protected:
   std::unique_ptr<GraphCodegen> graph_codegen_;
   /*! \brief target device */
@@ -485,6 +605,14 @@ class RelayBuildModule : public runtime::ModuleNode {
   std::unordered_map<std::string, runtime::NDArray> params_;
   /*! \brief building output */
   BuildOutput ret_;
+  /*! \brief whether to reuse the modules of the previous builds */
+  bool incremental_{false};
+  /*! \brief the modules of the last incremental build */
+  std::vector<BuildPart> parts_;
+  /*! \brief the host target and build config of parts_ */
+  std::string parts_config_;
+  /*! \brief the memory planner of the graph, "token" or "offset" */
+  std::string memory_plan_{"token"};
 };
 
 runtime::Module RelayBuildCreate() {
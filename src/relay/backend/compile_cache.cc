@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file relay/backend/compile_cache.cc
+ * \brief Persistent cache of the functions lowered by the compile engine.
+ */
+#include <tvm/ir/module.h>
+#include <tvm/node/serialization.h>
+#include <tvm/runtime/c_runtime_api.h>
+#include <tvm/tir/expr.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+
+#include "compile_cache.h"
+
+namespace tvm {
+namespace relay {
+
+namespace {
+// 64 bit FNV-1a, the file names must not depend on the process.
+uint64_t StableHash(const std::string& str) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : str) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::string GetString(const Map<std::string, ObjectRef>& entry, const std::string& name) {
+  if (!entry.count(name)) return "";
+  const auto* str = entry[name].as<tir::StringImmNode>();
+  return str != nullptr ? str->value : "";
+}
+}  // namespace
+
+std::string PersistentCompileCache::KeyText(const CCacheKey& key) const {
+  std::ostringstream os;
+  os << "tvm " << TVM_VERSION << "\n"
+     << "target " << key->target->str() << "\n"
+     << BuildConfig::Current() << "\n"
+     << AsText(key->source_func, true);
+  return os.str();
+}
+
+std::string PersistentCompileCache::EntryPath(const std::string& key_text) const {
+  std::ostringstream os;
+  os << dir_ << "/" << std::hex << StableHash(key_text) << ".json";
+  return os.str();
+}
+
+ObjectPtr<CachedFuncNode> PersistentCompileCache::Load(const std::string& key_text,
+                                                       const Target& target,
+                                                       std::string* base_name) const {
+  std::ifstream fs(EntryPath(key_text), std::ios::in | std::ios::binary);
+  if (!fs) return nullptr;
+  std::string json((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
+  auto cache_node = make_object<CachedFuncNode>();
+  try {
+    auto entry = Downcast<Map<std::string, ObjectRef>>(LoadJSON(json));
+    if (GetString(entry, "key") != key_text || !entry.count("funcs")) return nullptr;
+    cache_node->funcs = Downcast<Array<tir::LoweredFunc>>(entry["funcs"]);
+    cache_node->func_name = GetString(entry, "func_name");
+    *base_name = GetString(entry, "base_name");
+  } catch (const dmlc::Error&) {
+    LOG(WARNING) << "Ignore the unreadable compile cache entry " << EntryPath(key_text);
+    return nullptr;
+  }
+  cache_node->target = target;
+  return cache_node;
+}
+
+void PersistentCompileCache::Save(const std::string& key_text,
+                                  const std::string& base_name,
+                                  const CachedFuncNode* cfunc) const {
+  Map<std::string, ObjectRef> entry;
+  entry.Set("key", tir::StringImmNode::make(key_text));
+  entry.Set("base_name", tir::StringImmNode::make(base_name));
+  entry.Set("func_name", tir::StringImmNode::make(cfunc->func_name));
+  entry.Set("funcs", cfunc->funcs);
+  std::string json = SaveJSON(entry);
+  // Write a private file and rename it, readers never see a partial entry.
+  std::string path = EntryPath(key_text);
+  std::ostringstream tmp;
+  tmp << path << ".tmp" << std::hex << std::random_device()();
+  bool written;
+  {
+    std::ofstream fs(tmp.str(), std::ios::out | std::ios::binary);
+    fs.write(json.data(), json.size());
+    written = fs.good();
+  }
+  if (!written) {
+    LOG(WARNING) << "Cannot write the compile cache entry " << tmp.str();
+    std::remove(tmp.str().c_str());
+    return;
+  }
+  if (std::rename(tmp.str().c_str(), path.c_str()) != 0) {
+    std::remove(tmp.str().c_str());
+  }
+}
+
+}  // namespace relay
+}  // namespace tvm
@@ -0,0 +1,93 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file relay/backend/compile_cache.h
+ * \brief Persistent cache of the functions lowered by the compile engine.
+ */
+#ifndef TVM_RELAY_BACKEND_COMPILE_CACHE_H_
+#define TVM_RELAY_BACKEND_COMPILE_CACHE_H_
+
+#include <string>
+#include <utility>
+
+#include "compile_engine.h"
+
+namespace tvm {
+namespace relay {
+
+/*!
+ * \brief A directory of lowered primitive functions which outlives the process.
+ *
+ *  An entry is keyed by the text of the source function with its meta data,
+ *  the target, the current build config and the TVM version. The file name
+ *  is a hash of the key, the file holds the whole key which is compared on
+ *  load, so colliding hashes only cost a miss.
+ *
+ *  The AutoTVM dispatch context and the registered op strategies are not part
+ *  of the key, use one directory per tuning configuration.
+ */
+class PersistentCompileCache {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param dir The directory of the cache, it must exist.
+   */
+  explicit PersistentCompileCache(std::string dir) : dir_(std::move(dir)) {}
+  /*!
+   * \brief Get the key of the lowered function of a cache key.
+   *  Only functions of the default compiler can be cached.
+   * \param key The key of the compile engine.
+   * \return The text of the key.
+   */
+  std::string KeyText(const CCacheKey& key) const;
+  /*!
+   * \brief Load a lowered function.
+   * \param key_text The text of the key.
+   * \param target The target of the function.
+   * \param base_name Set to the name of the function before it was made unique.
+   * \return The cached function without schedule, nullptr when there is no entry.
+   */
+  ObjectPtr<CachedFuncNode> Load(const std::string& key_text,
+                                 const Target& target,
+                                 std::string* base_name) const;
+  /*!
+   * \brief Store a lowered function. Failing to write only logs a warning.
+   * \param key_text The text of the key.
+   * \param base_name The name of the function before it was made unique.
+   * \param cfunc The lowered function.
+   */
+  void Save(const std::string& key_text,
+            const std::string& base_name,
+            const CachedFuncNode* cfunc) const;
+  /*! \return The directory of the cache. */
+  const std::string& dir() const {
+    return dir_;
+  }
+
+ private:
+  /*! \brief Path of the file holding the entry of a key. */
+  std::string EntryPath(const std::string& key_text) const;
+  /*! \brief The directory of the cache. */
+  std::string dir_;
+};
+
+}  // namespace relay
+}  // namespace tvm
+#endif  // TVM_RELAY_BACKEND_COMPILE_CACHE_H_
@@ -36,12 +36,18 @@
 
 #include <topi/tags.h>
 #include <utility>
+#include <cstdlib>
 #include <limits>
+#include <memory>
 #include <mutex>
+#include <condition_variable>
 #include <functional>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "../../support/parallel_for.h"
+#include "compile_cache.h"
 #include "compile_engine.h"
 
 namespace tvm {
@@ -586,6 +592,12 @@ class MakeShapeFunc : public ExprFunctor<Array<te::Tensor>(const Expr&)> {
 
 class CompileEngineImpl : public CompileEngineNode {
  public:
+  CompileEngineImpl() {
+    if (const char* dir = getenv("TVM_COMPILE_CACHE_DIR")) {
+      SetCacheDir(dir);
+    }
+  }
+
   // Lower the function.
   CachedFunc Lower(const CCacheKey& key)  {
     return LowerInternal(key)->cached_func;
@@ -650,7 +662,73 @@ class CompileEngineImpl : public CompileEngineNode {
     return ret;
   }
 
+  void LowerAll(const Array<CCacheKey>& keys) final {
+    // claim the functions nobody has lowered or is lowering.
+    std::vector<LowerJob> jobs;
+    std::vector<CCacheValue> values;
+    std::shared_ptr<PersistentCompileCache> disk_cache;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      disk_cache = disk_cache_;
+      for (const CCacheKey& key : keys) {
+        if (!key->source_func->UseDefaultCompiler()) continue;
+        CCacheValue value = GetCacheValue(key, &cache_);
+        if (value->cached_func.defined() || lowering_.count(value.get())) continue;
+        lowering_.insert(value.get());
+        jobs.emplace_back(key);
+        values.push_back(value);
+      }
+    }
+    // The workers do not inherit the thread local build config of the caller.
+    BuildConfig build_config = BuildConfig::Current();
+    try {
+      support::parallel_for(jobs.size(), [&](size_t i) {
+        With<BuildConfig> config_scope(build_config);
+        PrepareJob(&jobs[i], disk_cache.get());
+      });
+      // Name the functions in the order of the keys, as sequential calls to Lower would.
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (LowerJob& job : jobs) {
+          NameJob(&job);
+        }
+      }
+      support::parallel_for(jobs.size(), [&](size_t i) {
+        With<BuildConfig> config_scope(build_config);
+        FinishJob(&jobs[i], disk_cache.get());
+      });
+    } catch (...) {
+      Publish(values, {});
+      throw;
+    }
+    std::vector<CachedFunc> cfuncs;
+    for (const LowerJob& job : jobs) {
+      cfuncs.push_back(CachedFunc(job.node));
+    }
+    Publish(values, cfuncs);
+  }
+
+  /*!
+   * \brief Set the directory of the persistent cache.
+   * \param dir The directory, empty disables the persistent cache.
+   */
+  void SetCacheDir(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dir.empty()) {
+      disk_cache_ = nullptr;
+    } else {
+      disk_cache_ = std::make_shared<PersistentCompileCache>(dir);
+    }
+  }
+
+  /*! \return The directory of the persistent cache, empty when it is disabled. */
+  std::string GetCacheDir() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return disk_cache_ != nullptr ? disk_cache_->dir() : "";
+  }
+
   void Clear() final {
+    std::lock_guard<std::mutex> lock(mutex_);
     cache_.clear();
   }
   // List all items in the cache.
@@ -675,20 +753,127 @@ class CompileEngineImpl : public CompileEngineNode {
   }
 
  private:
+  /*! \brief A function lowered by the current thread. */
+  struct LowerJob {
+    explicit LowerJob(CCacheKey key) : key(key) {}
+    /*! \brief The key of the function. */
+    CCacheKey key;
+    /*! \brief The cached function, its funcs are populated by FinishJob. */
+    ObjectPtr<CachedFuncNode> node;
+    /*! \brief The key in the persistent cache, empty when it is not used. */
+    std::string key_text;
+    /*! \brief The name of the function before it is made unique. */
+    std::string base_name;
+    /*! \brief The unique name the function had when it was stored. */
+    std::string stored_name;
+    /*! \brief Whether the function comes from the persistent cache. */
+    bool loaded{false};
+  };
   // implement lowered func
   CCacheValue LowerInternal(const CCacheKey& key)  {
-    std::lock_guard<std::mutex> lock(mutex_);
     CCacheValue value;
-    auto it = cache_.find(key);
-    if (it != cache_.end()) {
+    std::shared_ptr<PersistentCompileCache> disk_cache;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      value = GetCacheValue(key, &cache_);
+      // wait for the other thread lowering the same function.
+      lowered_.wait(lock, [&]() { return lowering_.count(value.get()) == 0; });
+      if (value->cached_func.defined()) return value;
+      lowering_.insert(value.get());
+      disk_cache = disk_cache_;
+    }
+    // Schedule and lower outside of the lock, other functions can be lowered meanwhile.
+    LowerJob job(key);
+    try {
+      PrepareJob(&job, disk_cache.get());
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        NameJob(&job);
+      }
+      FinishJob(&job, disk_cache.get());
+    } catch (...) {
+      Publish({value}, {});
+      throw;
+    }
+    Publish({value}, {CachedFunc(job.node)});
+    return value;
+  }
+  // Whether the function of a key is lowered by the default compiler, under a unique name.
+  static bool NeedLower(const CCacheKey& key) {
+    return key->source_func->UseDefaultCompiler() && !IsDeviceCopy(key->source_func);
+  }
+  // Whether the function of a key goes through the persistent cache. Device
+  // targets split the function into host code calling kernels by name, and
+  // only the host function would be renamed on load, so only CPU targets do.
+  static bool UseDiskCache(const CCacheKey& key, const PersistentCompileCache* disk_cache) {
+    return disk_cache != nullptr && NeedLower(key) && key->target->device_type == kDLCPU;
+  }
+  // Load the function of a job from the persistent cache, or schedule it.
+  void PrepareJob(LowerJob* job, const PersistentCompileCache* disk_cache) {
+    if (UseDiskCache(job->key, disk_cache)) {
+      job->key_text = disk_cache->KeyText(job->key);
+      job->node = disk_cache->Load(job->key_text, job->key->target, &job->base_name);
+      if (job->node != nullptr) {
+        job->loaded = true;
+        job->stored_name = job->node->func_name;
+        return;
+      }
+    }
+    job->node = CreateCachedFunc(job->key);
+    job->base_name = job->node->func_name;
+  }
+  // Give the function of a job its unique name. Requires mutex_.
+  void NameJob(LowerJob* job) {
+    if (NeedLower(job->key)) {
+      job->node->func_name = GetUniqueName(job->base_name);
+    }
+  }
+  // Lower the function of a job and store it, or rename the loaded function.
+  void FinishJob(LowerJob* job, const PersistentCompileCache* disk_cache) {
+    if (!NeedLower(job->key)) return;
+    if (job->loaded) {
+      Array<tir::LoweredFunc> funcs;
+      for (tir::LoweredFunc f : job->node->funcs) {
+        if (f->name == job->stored_name && f->name != job->node->func_name) {
+          auto n = make_object<tir::LoweredFuncNode>(*f.operator->());
+          n->name = job->node->func_name;
+          f = tir::LoweredFunc(n);
+        }
+        funcs.push_back(f);
+      }
+      job->node->funcs = funcs;
+      return;
+    }
+    LowerCachedFunc(job->key, job->node.get());
+    if (UseDiskCache(job->key, disk_cache)) {
+      disk_cache->Save(job->key_text, job->base_name, job->node.get());
+    }
+  }
+  /*!
+   * \brief Find the cache entry of a key, or create it. Requires mutex_.
+   * \param key The key.
+   * \param cache The cache to look up.
+   * \return The entry, its use count is incremented when it exists.
+   */
+  CCacheValue GetCacheValue(const CCacheKey& key,
+                            std::unordered_map<CCacheKey, CCacheValue>* cache) {
+    auto it = cache->find(key);
+    if (it != cache->end()) {
       it->second->use_count += 1;
-      if (it->second->cached_func.defined()) return it->second;
-      value = it->second;
-    } else {
-      value = CCacheValue(make_object<CCacheValueNode>());
-      value->use_count = 0;
-      cache_[key] = value;
+      return it->second;
     }
+    CCacheValue value = CCacheValue(make_object<CCacheValueNode>());
+    value->use_count = 0;
+    (*cache)[key] = value;
+    return value;
+  }
+  /*!
+   * \brief Schedule the function of a key, the part of lowering before naming.
+   * \param key The key.
+   * \return The cached function. Only the functions of the default compiler which
+   *  are not device copies are left to name and lower.
+   */
+  ObjectPtr<CachedFuncNode> CreateCachedFunc(const CCacheKey& key) {
     // No need to lower external functions for now. We will invoke the external
     // codegen tool once and lower all functions together.
     if (!key->source_func->UseDefaultCompiler()) {
@@ -698,27 +883,21 @@ class CompileEngineImpl : public CompileEngineNode {
       CHECK(name_node != nullptr) << "External function has not been attached a name yet.";
       cache_node->func_name = name_node->value;
       cache_node->target = tvm::target::ext_dev();
-      value->cached_func = CachedFunc(cache_node);
-      return value;
+      return cache_node;
     }
     // Enforce use the target.
     With<Target> target_scope(key->target);
-
-    CHECK(!value->cached_func.defined());
     auto cfunc = CreateSchedule(key->source_func, key->target);
-    auto cache_node = make_object<CachedFuncNode>(
-        *(cfunc.operator->()));
-
-    // Skip lowering for device copy node.
-    const Expr body = (key->source_func)->body;
-    if (const CallNode* call_node = body.as<CallNode>()) {
-      if (call_node->attrs.as<DeviceCopyAttrs>()) {
-        value->cached_func = CachedFunc(cache_node);
-        return value;
-      }
-    }
-
-    cache_node->func_name = GetUniqueName(cache_node->func_name);
+    return make_object<CachedFuncNode>(*(cfunc.operator->()));
+  }
+  /*!
+   * \brief Lower a scheduled function which already has its unique name.
+   * \param key The key.
+   * \param cache_node The cached function, its funcs are populated.
+   */
+  void LowerCachedFunc(const CCacheKey& key, CachedFuncNode* cache_node) {
+    // Enforce use the target.
+    With<Target> target_scope(key->target);
     // NOTE: array will copy on write.
     Array<te::Tensor> all_args = cache_node->inputs;
     for (te::Tensor arg : cache_node->outputs) {
@@ -727,30 +906,42 @@ class CompileEngineImpl : public CompileEngineNode {
     // lower the function
     if (const auto* f = runtime::Registry::Get("relay.backend.lower")) {
       cache_node->funcs = (*f)(
-          cfunc->schedule, all_args, cache_node->func_name, key->source_func);
+          cache_node->schedule, all_args, cache_node->func_name, key->source_func);
     } else {
       tvm::BuildConfig bcfg = BuildConfig::Create();
       std::unordered_map<te::Tensor, tir::Buffer> binds;
-      cache_node->funcs = tvm::lower(cfunc->schedule, all_args, cache_node->func_name,
+      cache_node->funcs = tvm::lower(cache_node->schedule, all_args, cache_node->func_name,
                                      binds, bcfg);
     }
-    value->cached_func = CachedFunc(cache_node);
-    return value;
+  }
+  /*!
+   * \brief Publish the results of lowering and wake up the waiting threads.
+   * \param values The entries claimed for lowering.
+   * \param cfuncs Their cached functions, empty when lowering failed.
+   */
+  void Publish(const std::vector<CCacheValue>& values, const std::vector<CachedFunc>& cfuncs) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (size_t i = 0; i < values.size(); ++i) {
+        CCacheValue value = values[i];
+        if (i < cfuncs.size()) value->cached_func = cfuncs[i];
+        lowering_.erase(value.get());
+      }
+    }
+    lowered_.notify_all();
+  }
+  // Skip lowering for device copy node.
+  static bool IsDeviceCopy(const Function& func) {
+    if (const CallNode* call_node = func->body.as<CallNode>()) {
+      return call_node->attrs.as<DeviceCopyAttrs>() != nullptr;
+    }
+    return false;
   }
   // implement lowered shape func
   CCacheValue LowerShapeFuncInternal(const CCacheKey& key) {
     std::lock_guard<std::mutex> lock(mutex_);
-    CCacheValue value;
-    auto it = shape_func_cache_.find(key);
-    if (it != shape_func_cache_.end()) {
-      it->second->use_count += 1;
-      if (it->second->cached_func.defined()) return it->second;
-      value = it->second;
-    } else {
-      value = CCacheValue(make_object<CCacheValueNode>());
-      value->use_count = 0;
-      shape_func_cache_[key] = value;
-    }
+    CCacheValue value = GetCacheValue(key, &shape_func_cache_);
+    if (value->cached_func.defined()) return value;
     // Enforce use the target.
     With<Target> target_scope(key->target);
 
@@ -796,6 +987,12 @@ class CompileEngineImpl : public CompileEngineNode {
   }
   /*! \brief compiler cache lock*/
   std::mutex mutex_;
+  /*! \brief signaled when functions finish lowering */
+  std::condition_variable lowered_;
+  /*! \brief the cache entries being lowered by some thread */
+  std::unordered_set<const Object*> lowering_;
+  /*! \brief persistent cache shared with other processes, nullptr when disabled */
+  std::shared_ptr<PersistentCompileCache> disk_cache_;
   /*! \brief internal name map to get an unique name */
   std::unordered_map<std::string, int> name_map_;
   /*! \brief internal compiler cache */
@@ -837,6 +1034,12 @@ TVM_REGISTER_GLOBAL("relay.backend._CompileEngineLower")
   return self->Lower(key);
 });
 
+TVM_REGISTER_GLOBAL("relay.backend._CompileEngineLowerAll")
+.set_body_typed(
+    [](CompileEngine self, Array<CCacheKey> keys) {
+  self->LowerAll(keys);
+});
+
 TVM_REGISTER_GLOBAL("relay.backend._CompileEngineLowerShapeFunc")
 .set_body_typed(
     [](CompileEngine self, CCacheKey key) {
@@ -854,6 +1057,18 @@ TVM_REGISTER_GLOBAL("relay.backend._CompileEngineJIT")
   return self->JIT(key);
 });
 
+TVM_REGISTER_GLOBAL("relay.backend._CompileEngineSetCacheDir")
+.set_body_typed(
+    [](CompileEngine self, std::string dir) {
+  static_cast<CompileEngineImpl*>(self.operator->())->SetCacheDir(dir);
+});
+
+TVM_REGISTER_GLOBAL("relay.backend._CompileEngineGetCacheDir")
+.set_body_typed(
+    [](CompileEngine self) {
+  return static_cast<CompileEngineImpl*>(self.operator->())->GetCacheDir();
+});
+
 TVM_REGISTER_GLOBAL("relay.backend._CompileEngineListItems")
 .set_body_typed(
     [](CompileEngine self){
@@ -205,6 +205,15 @@ class CompileEngineNode : public Object {
    * \return The result.
    */
   virtual CachedFunc Lower(const CCacheKey& key) = 0;
+  /*!
+   * \brief Lower a batch of functions ahead of their calls to Lower.
+   *
+   *  The functions are scheduled and lowered concurrently on up to
+   *  TVM_NUM_BUILD_THREADS threads. They are named in the order of the keys,
+   *  so the names are the ones calling Lower on the keys in order would give.
+   * \param keys The keys to the functions.
+   */
+  virtual void LowerAll(const tvm::Array<CCacheKey>& keys) = 0;
   /*!
    * \brief Just in time compile to get a PackedFunc.
    * \param key The key to the cached function.
@@ -26,6 +26,12 @@
 #include <tvm/relay/expr.h>
 #include <tvm/relay/expr_functor.h>
 #include <tvm/relay/analysis.h>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "../../support/arena.h"
 
 namespace tvm {
@@ -127,6 +133,36 @@ class StorageAllocaBaseVisitor : public ExprVisitor {
    * \param can_realloc Whether we can re-allocate the memory.
    */
   virtual void CreateToken(const ExprNode* op, bool can_realloc) = 0;
+  /*!
+   * \brief ceil(size/word_size) to get number of words.
+   * \param size The original size.
+   * \param word_size The element size.
+   */
+  static size_t DivRoundUp(size_t size, size_t word_size) {
+    return (size + word_size - 1) / word_size;
+  }
+  /*!
+   * \brief Get the memory requirement.
+   * \param prototype The prototype token.
+   * \return The required memory size.
+   */
+  static size_t GetMemorySize(StorageToken* prototype) {
+    const TensorTypeNode* ttype = prototype->ttype;
+    CHECK(ttype != nullptr);
+    size_t size = 1;
+    for (IndexExpr dim : ttype->shape) {
+      const int64_t* pval = tir::as_const_int(dim);
+      CHECK(pval != nullptr)
+          << "Cannot allocate memory symbolic tensor shape "
+          << ttype->shape;
+      CHECK_GE(*pval, 0)
+          << "Cannot allocate memory for tensor with negative shape"
+          << *pval;
+      size *= static_cast<size_t>(pval[0]);
+    }
+    size *= DivRoundUp(ttype->dtype.bits() * ttype->dtype.lanes(), 8);
+    return size;
+  }
 };
 
 class StorageAllocaInit : protected StorageAllocaBaseVisitor {
@@ -277,36 +313,6 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
       CheckForRelease(tok);
     }
   }
-  /*!
-   * \brief ceil(size/word_size) to get number of words.
-   * \param size The original size.
-   * \param word_size The element size.
-   */
-  static size_t DivRoundUp(size_t size, size_t word_size) {
-    return (size + word_size - 1) / word_size;
-  }
-  /*!
-   * \brief Get the memory requirement.
-   * \param prototype The prototype token.
-   * \return The required memory size.
-   */
-  size_t GetMemorySize(StorageToken* prototype) {
-    const TensorTypeNode* ttype = prototype->ttype;
-    CHECK(ttype != nullptr);
-    size_t size = 1;
-    for (IndexExpr dim : ttype->shape) {
-      const int64_t* pval = tir::as_const_int(dim);
-      CHECK(pval != nullptr)
-          << "Cannot allocate memory symbolic tensor shape "
-          << ttype->shape;
-      CHECK_GE(*pval, 0)
-          << "Cannot allocate memory for tensor with negative shape"
-          << *pval;
-      size *= static_cast<size_t>(pval[0]);
-    }
-    size *= DivRoundUp(ttype->dtype.bits() * ttype->dtype.lanes(), 8);
-    return size;
-  }
   /*!
    * \brief Request a storage token for a given prototype.
    * \param prototype. The prototype storage token.
@@ -386,12 +392,241 @@ class StorageAllocator : public StorageAllocaBaseVisitor {
   std::unordered_map<const ExprNode*, std::vector<StorageToken*> > prototype_;
 };
 
-Map<Expr, Array<IntegerArray> > GraphPlanMemory(const Function& func) {
+/*!
+ * \brief Plan memory by placing every tensor at an offset of one address
+ *  space per device.
+ *
+ *  Each tensor gets its own storage id, live from the call producing it to
+ *  the last call reading it. Tensors are then packed into the address space
+ *  so that two tensors share bytes only when their lifetimes do not overlap:
+ *  the largest tensor first, each at the lowest-waste gap left by the
+ *  tensors already placed. Small graphs also try every placement order and
+ *  keep the smallest peak.
+ */
+class OffsetStorageAllocator : public StorageAllocaBaseVisitor {
+ public:
+  /*! \brief Graphs with at most this many tensors on a device try every placement order. */
+  static constexpr size_t kExhaustiveLimit = 8;
+
+  // Run offset planning for a function.
+  Map<Expr, Array<IntegerArray> > Plan(const Function& func) {
+    prototype_ = StorageAllocaInit(&arena_).GetInitTokenMap(func);
+    this->Run(func);
+    // the outputs are alive until the end.
+    for (StorageToken* tok : GetToken(func->body)) {
+      end_[tok] = kForever;
+    }
+    std::unordered_map<int, std::vector<StorageToken*> > by_device;
+    for (StorageToken* tok : data_) {
+      if (!end_.count(tok)) end_[tok] = kForever;
+      by_device[tok->device_type].push_back(tok);
+    }
+    total_bytes_ = 0;
+    for (auto& kv : by_device) {
+      total_bytes_ += Pack(&kv.second);
+    }
+
+    Map<Expr, Array<IntegerArray> > smap;
+    for (const auto& kv : token_map_) {
+      std::vector<Integer> storage_ids;
+      std::vector<Integer> device_types;
+      std::vector<Integer> offsets;
+      for (StorageToken* tok : kv.second) {
+        storage_ids.push_back(tok->storage_id);
+        device_types.push_back(tok->device_type);
+        offsets.push_back(IntImm(DataType::Int(64), static_cast<int64_t>(offset_.at(tok))));
+      }
+      smap.Set(GetRef<Expr>(kv.first),
+               Array<IntegerArray>({storage_ids, device_types, offsets}));
+    }
+    return smap;
+  }
+
+  /*! \return the bytes of all the address spaces of the last plan */
+  size_t TotalAllocBytes() const {
+    return total_bytes_;
+  }
+
+ protected:
+  using StorageAllocaBaseVisitor::VisitExpr_;
+
+  void CreateToken(const ExprNode* op, bool can_realloc) final {
+    CHECK(!token_map_.count(op));
+    auto it = prototype_.find(op);
+    CHECK(it != prototype_.end());
+    std::vector<StorageToken*> tokens;
+    for (StorageToken* tok : it->second) {
+      tok->max_bytes = GetMemorySize(tok);
+      tok->storage_id = static_cast<int64_t>(data_.size());
+      data_.push_back(tok);
+      begin_[tok] = can_realloc ? step_ : 0;
+      // params and constants live for the whole run.
+      if (!can_realloc) end_[tok] = kForever;
+      tokens.push_back(tok);
+    }
+    token_map_[op] = tokens;
+  }
+
+  void VisitExpr_(const CallNode* op) final {
+    std::vector<StorageToken*> args;
+    for (Expr arg : op->args) {
+      for (StorageToken* tok : GetToken(arg)) {
+        args.push_back(tok);
+      }
+    }
+    ++step_;
+    CreateToken(op, true);
+    // the inputs are alive until this call is done, so they never share with its outputs.
+    for (StorageToken* tok : token_map_.at(op)) {
+      if (tok->ref_counter == 0) end_[tok] = step_;
+    }
+    for (StorageToken* tok : args) {
+      tok->ref_counter -= 1;
+      if (tok->ref_counter == 0 && !end_.count(tok)) end_[tok] = step_;
+    }
+  }
+
+ private:
+  static constexpr size_t kForever = std::numeric_limits<size_t>::max();
+  // offsets are aligned for any data type.
+  static constexpr size_t kAlignment = 64;
+
+  static size_t AlignUp(size_t size) {
+    return (size + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  bool Overlap(StorageToken* a, StorageToken* b) const {
+    return begin_.at(a) <= end_.at(b) && begin_.at(b) <= end_.at(a);
+  }
+
+  // Place the tokens in order, returns the peak bytes.
+  size_t Place(const std::vector<StorageToken*>& order,
+               std::unordered_map<StorageToken*, size_t>* offsets) const {
+    size_t peak = 0;
+    std::vector<StorageToken*> placed;
+    for (StorageToken* tok : order) {
+      size_t size = AlignUp(tok->max_bytes);
+      // the live ranges of the placed tensors overlapping in time, by offset.
+      std::vector<std::pair<size_t, size_t> > busy;
+      for (StorageToken* other : placed) {
+        if (Overlap(tok, other)) {
+          size_t begin = offsets->at(other);
+          busy.emplace_back(begin, begin + AlignUp(other->max_bytes));
+        }
+      }
+      std::sort(busy.begin(), busy.end());
+      // the smallest gap that fits, or the end.
+      size_t best = kForever, best_waste = kForever, cursor = 0;
+      for (const auto& range : busy) {
+        if (range.first > cursor && range.first - cursor >= size &&
+            range.first - cursor - size < best_waste) {
+          best = cursor;
+          best_waste = range.first - cursor - size;
+        }
+        cursor = std::max(cursor, range.second);
+      }
+      if (best == kForever) best = cursor;
+      (*offsets)[tok] = best;
+      peak = std::max(peak, best + size);
+      placed.push_back(tok);
+    }
+    return peak;
+  }
+
+  // Pack the tokens of one device, returns the peak bytes.
+  size_t Pack(std::vector<StorageToken*>* tokens) {
+    std::vector<StorageToken*>& order = *tokens;
+    std::sort(order.begin(), order.end(), [](StorageToken* a, StorageToken* b) {
+      if (a->max_bytes != b->max_bytes) return a->max_bytes > b->max_bytes;
+      return a->storage_id < b->storage_id;
+    });
+    std::unordered_map<StorageToken*, size_t> best;
+    size_t peak = Place(order, &best);
+    if (order.size() <= kExhaustiveLimit) {
+      auto by_id = [](StorageToken* a, StorageToken* b) {
+        return a->storage_id < b->storage_id;
+      };
+      std::vector<StorageToken*> perm = order;
+      std::sort(perm.begin(), perm.end(), by_id);
+      do {
+        std::unordered_map<StorageToken*, size_t> offsets;
+        size_t p = Place(perm, &offsets);
+        if (p < peak) {
+          peak = p;
+          best = std::move(offsets);
+        }
+      } while (std::next_permutation(perm.begin(), perm.end(), by_id));
+    }
+    for (const auto& kv : best) {
+      offset_[kv.first] = kv.second;
+    }
+    return peak;
+  }
+
+  // allocator
+  support::Arena arena_;
+  // the index of the current call
+  size_t step_{0};
+  // the first and last call each token is alive for
+  std::unordered_map<StorageToken*, size_t> begin_, end_;
+  // the planned offset of each token
+  std::unordered_map<StorageToken*, size_t> offset_;
+  // all the tokens
+  std::vector<StorageToken*> data_;
+  size_t total_bytes_{0};
+  /*! \brief internal prototype token map */
+  std::unordered_map<const ExprNode*, std::vector<StorageToken*> > prototype_;
+};
+
+// Whether every expression is on the same device, the offset plan needs one address space.
+bool IsSingleDevice(const Function& func) {
+  return CollectDeviceInfo(func).size() == 0;
+}
+
+/*!
+ * \brief Plan the storage of a function.
+ * \param func The function.
+ * \param memory_plan "token" to reuse whole buffers, "offset" to place all
+ *  the tensors in one address space.
+ */
+Map<Expr, Array<IntegerArray> > GraphPlanMemory(const Function& func,
+                                                const std::string& memory_plan) {
+  CHECK(memory_plan == "token" || memory_plan == "offset")
+      << "Unknown memory plan " << memory_plan << ", expect token or offset";
+  if (memory_plan == "offset") {
+    if (IsSingleDevice(func)) {
+      return OffsetStorageAllocator().Plan(func);
+    }
+    LOG(WARNING) << "The offset memory plan does not support heterogeneous execution, "
+                 << "fall back to the storage token plan";
+  }
   return StorageAllocator().Plan(func);
 }
 
 TVM_REGISTER_GLOBAL("relay.backend.GraphPlanMemory")
-.set_body_typed(GraphPlanMemory);
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    std::string memory_plan = args.num_args > 1 ? args[1].operator std::string() : "token";
+    *rv = GraphPlanMemory(args[0], memory_plan);
+});
+
+TVM_REGISTER_GLOBAL("relay.backend.GraphPlanMemoryOffset")
+.set_body_typed([](Function func) {
+    return OffsetStorageAllocator().Plan(func);
+});
+
+TVM_REGISTER_GLOBAL("relay.backend.GraphMemoryPlanReport")
+.set_body_typed([](Function func) {
+    StorageAllocator token_plan;
+    token_plan.Plan(func);
+    OffsetStorageAllocator offset_plan;
+    offset_plan.Plan(func);
+    Map<std::string, Integer> report;
+    report.Set("token_bytes",
+               IntImm(DataType::Int(64), static_cast<int64_t>(token_plan.TotalAllocBytes())));
+    report.Set("offset_bytes",
+               IntImm(DataType::Int(64), static_cast<int64_t>(offset_plan.TotalAllocBytes())));
+    return report;
+});
 
 }  // namespace relay
 }  // namespace tvm
@@ -29,6 +29,7 @@
 #include <tvm/runtime/device_api.h>
 
 
+#include <functional>
 #include <list>
 #include <string>
 #include <vector>
@@ -189,24 +190,63 @@ class GraphOpNode : public GraphNode {
   const std::string op_type_name_{"tvm_op"};
 };
 
+/*!
+ * \brief Collect the keys of the primitive functions a graph calls, in the
+ *  order the graph runtime codegen lowers them.
+ */
+class PrimitiveCallCollector : public ExprVisitor {
+ public:
+  explicit PrimitiveCallCollector(std::function<Target(const Expr&)> get_target)
+      : get_target_(get_target) {}
+
+  Array<CCacheKey> Collect(const Expr& body) {
+    VisitExpr(body);
+    return keys_;
+  }
+
+  void VisitExpr_(const CallNode* op) final {
+    // The codegen lowers a call before visiting its arguments.
+    if (const auto* func = op->op.as<FunctionNode>()) {
+      if (func->IsPrimitive() && func->UseDefaultCompiler()) {
+        keys_.push_back(CCacheKeyNode::make(GetRef<Function>(func),
+                                            get_target_(GetRef<Expr>(op))));
+      }
+    }
+    for (auto arg : op->args) {
+      VisitExpr(arg);
+    }
+  }
+
+ private:
+  std::function<Target(const Expr&)> get_target_;
+  Array<CCacheKey> keys_;
+};
+
 /*! \brief Code generator for graph runtime */
 class GraphRuntimeCodegen
     : public ::tvm::relay::ExprFunctor<std::vector<GraphNodeRef>(const Expr&)> {
  public:
-  GraphRuntimeCodegen(runtime::Module* mod, const TargetsMap& targets)
-      : mod_(mod) {
+  GraphRuntimeCodegen(runtime::Module* mod, const TargetsMap& targets,
+                      const std::string& memory_plan = "token")
+      : mod_(mod), memory_plan_(memory_plan) {
     compile_engine_ = CompileEngine::Global();
     targets_ = targets;
   }
 
   LoweredOutput Codegen(relay::Function func) {
     auto pf = GetPackedFunc("relay.backend.GraphPlanMemory");
-    storage_device_map_ = (*pf)(func);
+    storage_device_map_ = (*pf)(func, memory_plan_);
     // First we convert all the parameters into input nodes.
     for (auto param : func->params) {
       auto node_ptr = GraphInputNode::make_node_ptr(param->name_hint(), GraphAttrs());
       var_map_[param.get()] = AddNode(node_ptr, param);
     }
+    // Lower all the primitive functions up front, concurrently, the traversal
+    // below then finds them in the cache of the compile engine.
+    PrimitiveCallCollector collector([this](const Expr& call) {
+      return GetCallTarget(call);
+    });
+    compile_engine_->LowerAll(collector.Collect(func->body));
     heads_ = VisitExpr(func->body);
     std::ostringstream os;
     dmlc::JSONWriter writer(&os);
@@ -260,13 +300,21 @@ class GraphRuntimeCodegen
     size_t count = storage_device_map_.count(expr);
     CHECK_GT(count, 0) << "Expr is not existing in storage plan";
     auto storage_device_info = storage_device_map_[expr];
-    CHECK_EQ(storage_device_info.size(), 2);
+    CHECK(storage_device_info.size() == 2 || storage_device_info.size() == 3);
     // storage
     std::vector<int64_t> storage_info;
     for (auto& v : storage_device_info[0]) {
       storage_info.push_back(v->value);
     }
     node->attrs_["storage_id"] = std::move(storage_info);
+    // byte offsets, when the plan places all storage in one address space
+    if (storage_device_info.size() == 3) {
+      std::vector<int64_t> offsets;
+      for (auto& v : storage_device_info[2]) {
+        offsets.push_back(v->value);
+      }
+      node->attrs_["storage_offset"] = std::move(offsets);
+    }
     // type
     std::vector<int64_t> device_types;
     for (auto& v : storage_device_info[1]) {
@@ -402,6 +450,34 @@ class GraphRuntimeCodegen
     return AddNode(node, GetRef<Expr>(op));
   }
 
+  /*!
+   * \brief Get the target of a call to a primitive function.
+   * \param expr The call.
+   * \return The target of the device the call is placed on.
+   */
+  Target GetCallTarget(const Expr& expr) {
+    CHECK_GE(storage_device_map_.count(expr), 0);
+    auto &device_type = storage_device_map_[expr][1];
+    auto call_dev_type = device_type[0]->value;
+    if (targets_.size() == 1) {
+       // homogeneous execution.
+      const auto& it = targets_.begin();
+      return (*it).second;
+    }
+    // heterogeneous execution.
+    std::string call_dev_name;
+    if (call_dev_type == 0) {
+      call_dev_name = "llvm";
+    } else {
+      call_dev_name = runtime::DeviceName(call_dev_type);
+    }
+    if (targets_.count(call_dev_type) == 0) {
+      LOG(FATAL) << "No target is provided for device "
+                 << call_dev_name;
+    }
+    return targets_[call_dev_type];
+  }
+
   std::vector<GraphNodeRef> VisitExpr_(const CallNode* op) override {
     Expr expr = GetRef<Expr>(op);
     Function func;
@@ -432,28 +508,8 @@ class GraphRuntimeCodegen
       return GraphAddCallNode(op, ext_func->func_name, ext_func->func_name);
     }
 
-    CHECK_GE(storage_device_map_.count(expr), 0);
-    auto &device_type = storage_device_map_[expr][1];
-    auto call_dev_type = device_type[0]->value;
     // Normal Relay Function
-    if (targets_.size() == 1) {
-       // homogeneous execution.
-      const auto& it = targets_.begin();
-      target = (*it).second;
-    } else {
-      // heterogeneous execution.
-      std::string call_dev_name;
-      if (call_dev_type == 0) {
-        call_dev_name = "llvm";
-      } else {
-        call_dev_name = runtime::DeviceName(call_dev_type);
-      }
-      if (targets_.count(call_dev_type) == 0) {
-        LOG(FATAL) << "No target is provided for device "
-                   << call_dev_name;
-      }
-      target = targets_[call_dev_type];
-    }
+    target = GetCallTarget(expr);
     CCacheKey key = (*pf0)(func, target);
     CachedFunc lowered_func = (*pf1)(compile_engine_, key);
     if (!lowered_funcs_.count(target->str())) {
@@ -530,6 +586,7 @@ class GraphRuntimeCodegen
     ShapeVector shapes;
     std::vector<size_t> storage_ids;
     std::vector<size_t> device_types;
+    std::vector<size_t> storage_offsets;
     std::vector<std::string> dltypes;
     std::vector<size_t> node_row_ptr{0};
     for (auto node : nodes_) {
@@ -547,6 +604,10 @@ class GraphRuntimeCodegen
         const auto& dev_types = dmlc::get<std::vector<int64_t>>(node->attrs_["device_index"]);
         device_types.insert(device_types.end(), dev_types.begin(), dev_types.end());
       }
+      if (node->attrs_.count("storage_offset")) {
+        const auto& offsets = dmlc::get<std::vector<int64_t>>(node->attrs_["storage_offset"]);
+        storage_offsets.insert(storage_offsets.end(), offsets.begin(), offsets.end());
+      }
       node_row_ptr.push_back(num_entry);
     }
     writer->BeginObject();
@@ -562,6 +623,11 @@ class GraphRuntimeCodegen
       attrs["device_index"].emplace_back(std::string("list_int"));
       attrs["device_index"].emplace_back(device_types);
     }
+    if (storage_offsets.size()) {
+      CHECK_EQ(storage_offsets.size(), storage_ids.size());
+      attrs["storage_offset"].emplace_back(std::string("list_int"));
+      attrs["storage_offset"].emplace_back(storage_offsets);
+    }
     attrs["dltype"].emplace_back(std::string("list_str"));
     attrs["dltype"].emplace_back(dltypes);
     writer->WriteObjectKeyValue("attrs", attrs);
@@ -592,6 +658,8 @@ class GraphRuntimeCodegen
   std::vector<GraphNodeRef> heads_;
   /*! \brief mod */
   runtime::Module* mod_;
+  /*! \brief the memory planner, "token" or "offset" */
+  std::string memory_plan_;
   /*! \brief variable map */
   std::unordered_map<const Object*, std::vector<GraphNodeRef>> var_map_;
   /*! \brief target device */
@@ -616,9 +684,10 @@ class GraphRuntimeCodegenModule : public runtime::ModuleNode {
                                  const ObjectPtr<Object>& sptr_to_self) {
      if (name == "init") {
        return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
-         CHECK_EQ(args.num_args, 2)
+         CHECK(args.num_args == 2 || args.num_args == 3)
              << "The expected of arguments are: "
-             << "runtime::Module mod and Map<int, Target> targets";
+             << "runtime::Module mod, Map<int, Target> targets and optionally "
+             << "the memory plan";
          void* mod = args[0];
          Map<Integer, tvm::Target> tmp = args[1];
          TargetsMap targets;
@@ -627,8 +696,9 @@ class GraphRuntimeCodegenModule : public runtime::ModuleNode {
            CHECK(dev_type);
            targets[dev_type->value] = it.second;
          }
+         std::string memory_plan = args.num_args == 3 ? args[2].operator std::string() : "token";
          codegen_ = std::make_shared<GraphRuntimeCodegen>(
-             reinterpret_cast<runtime::Module*>(mod), targets);
+             reinterpret_cast<runtime::Module*>(mod), targets, memory_plan);
        });
     } else if (name == "codegen") {
       return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
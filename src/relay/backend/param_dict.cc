@@ -71,6 +71,74 @@ TVM_REGISTER_GLOBAL("tvm.relay._save_param_dict")
     *rv = arr;
   });
 
+// Write the index of the mapped parameter file, the tensors follow at the given offsets.
+static void SaveMappedParamIndex(dmlc::Stream* fo,
+                                 const std::vector<std::string>& names,
+                                 const std::vector<DLTensor*>& arrays,
+                                 const std::vector<uint64_t>& offsets) {
+  uint64_t header = kTVMMappedParamsMagic, reserved = 0;
+  fo->Write(header);
+  fo->Write(reserved);
+  fo->Write(names);
+  uint64_t sz = static_cast<uint64_t>(arrays.size());
+  fo->Write(sz);
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    const DLTensor* tensor = arrays[i];
+    fo->Write(tensor->dtype);
+    fo->Write(tensor->ndim);
+    fo->WriteArray(tensor->shape, tensor->ndim);
+    fo->Write(offsets[i]);
+    uint64_t nbytes = GetDataSize(*tensor);
+    fo->Write(nbytes);
+  }
+}
+
+TVM_REGISTER_GLOBAL("tvm.relay._save_mapped_param_dict")
+.set_body([](TVMArgs args, TVMRetValue *rv) {
+    CHECK(DMLC_IO_NO_ENDIAN_SWAP)
+        << "The mapped parameter file is only supported on little endian hosts";
+    CHECK_EQ(args.size() % 2, 0u);
+    size_t num_params = args.size() / 2;
+    std::vector<std::string> names;
+    std::vector<DLTensor*> arrays;
+    for (size_t i = 0; i < num_params * 2; i += 2) {
+      names.emplace_back(args[i].operator std::string());
+      arrays.emplace_back(args[i + 1].operator DLTensor*());
+    }
+    auto align = [](uint64_t offset) {
+      return (offset + kTVMMappedParamsAlignment - 1) /
+          kTVMMappedParamsAlignment * kTVMMappedParamsAlignment;
+    };
+    // The size of the index does not depend on the offsets, measure it first.
+    std::string bytes;
+    std::vector<uint64_t> offsets(arrays.size(), 0);
+    {
+      dmlc::MemoryStringStream strm(&bytes);
+      SaveMappedParamIndex(&strm, names, arrays, offsets);
+    }
+    uint64_t offset = bytes.size();
+    for (size_t i = 0; i < arrays.size(); ++i) {
+      offsets[i] = align(offset);
+      offset = offsets[i] + GetDataSize(*arrays[i]);
+    }
+    bytes.clear();
+    {
+      dmlc::MemoryStringStream strm(&bytes);
+      SaveMappedParamIndex(&strm, names, arrays, offsets);
+    }
+    bytes.resize(offset, 0);
+    for (size_t i = 0; i < arrays.size(); ++i) {
+      size_t nbytes = GetDataSize(*arrays[i]);
+      if (nbytes == 0) continue;
+      CHECK_EQ(TVMArrayCopyToBytes(arrays[i], &bytes[offsets[i]], nbytes), 0)
+          << TVMGetLastError();
+    }
+    TVMByteArray arr;
+    arr.data = bytes.c_str();
+    arr.size = bytes.length();
+    *rv = arr;
+  });
+
 TVM_REGISTER_GLOBAL("tvm.relay._load_param_dict")
 .set_body([](TVMArgs args, TVMRetValue *rv) {
     std::string bytes = args[0];
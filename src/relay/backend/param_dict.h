@@ -36,6 +36,10 @@ namespace relay {
 
 /*! \brief Magic number for NDArray list file  */
 constexpr uint64_t kTVMNDArrayListMagic = 0xF7E58D4F05049CB7;
+/*! \brief Magic number for the mapped parameter file */
+constexpr uint64_t kTVMMappedParamsMagic = 0xF7E58D4F05049CB8;
+/*! \brief Alignment of each tensor in the mapped parameter file */
+constexpr uint64_t kTVMMappedParamsAlignment = 64;
 
 /*!
  * \brief Wrapper node for naming `NDArray`s.
@@ -226,6 +226,88 @@ std::vector<int64_t> ToAllocTensorShape32(NDArray shape) {
   return raw_shape;
 }
 
+/*! \brief Read an integer scalar constant, return false if expr is not one. */
+bool GetConstInt(const Expr& expr, int64_t* value) {
+  const auto* konst = expr.as<ConstantNode>();
+  if (konst == nullptr || !konst->is_scalar()) return false;
+  DataType dtype(konst->data->dtype);
+  if (dtype == DataType::Int(64)) {
+    *value = static_cast<int64_t*>(konst->data->data)[0];
+  } else if (dtype == DataType::Int(32)) {
+    *value = static_cast<int32_t*>(konst->data->data)[0];
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/*! \brief A storage of static size which holds exactly one tensor. */
+struct StaticStorage {
+  int64_t allocation_size;
+  int64_t alignment;
+  DataType dtype;
+};
+
+/*!
+ * \brief Find the storages that can be allocated together with their tensor.
+ *
+ *  The static allocations of ManifestAlloc bind a storage of constant size
+ *  and use it once for a tensor of constant shape. The compiler emits such
+ *  a pair as one AllocStaticTensor instead of AllocStorage + AllocTensor.
+ */
+class StaticStorageFinder : public ExprVisitor {
+ public:
+  std::unordered_map<Var, StaticStorage, ObjectHash, ObjectEqual> Find(const Expr& body) {
+    this->VisitExpr(body);
+    std::unordered_map<Var, StaticStorage, ObjectHash, ObjectEqual> ret;
+    for (const auto& kv : storages_) {
+      // The let binding and the alloc_tensor are the only two references.
+      auto it = visit_counter_.find(kv.first.get());
+      auto use = static_uses_.find(kv.first);
+      if (it != visit_counter_.end() && it->second == 2 &&
+          use != static_uses_.end() && use->second == kv.second.dtype) {
+        ret.insert(kv);
+      }
+    }
+    return ret;
+  }
+
+  void VisitExpr_(const LetNode* let_node) final {
+    static const Op& alloc_storage = Op::Get("memory.alloc_storage");
+    const auto* call = let_node->value.as<CallNode>();
+    if (call && call->op.same_as(alloc_storage)) {
+      CHECK_EQ(call->args.size(), 2U);
+      StaticStorage storage;
+      if (GetConstInt(call->args[0], &storage.allocation_size) &&
+          GetConstInt(call->args[1], &storage.alignment)) {
+        auto alloc_attrs = call->attrs.as<AllocTensorAttrs>();
+        CHECK(alloc_attrs != nullptr) << "must be the alloc tensor attrs";
+        storage.dtype = alloc_attrs->dtype;
+        storages_.insert({let_node->var, storage});
+      }
+    }
+    ExprVisitor::VisitExpr_(let_node);
+  }
+
+  void VisitExpr_(const CallNode* call_node) final {
+    static const Op& alloc_tensor = Op::Get("memory.alloc_tensor");
+    if (call_node->op.same_as(alloc_tensor)) {
+      CHECK_EQ(call_node->args.size(), 2U);
+      const auto* storage = call_node->args[0].as<VarNode>();
+      if (storage && call_node->args[1].as<ConstantNode>()) {
+        auto alloc_attrs = call_node->attrs.as<AllocTensorAttrs>();
+        CHECK(alloc_attrs != nullptr) << "must be the alloc tensor attrs";
+        static_uses_[GetRef<Var>(storage)] = alloc_attrs->dtype;
+      }
+    }
+    ExprVisitor::VisitExpr_(call_node);
+  }
+
+ private:
+  std::unordered_map<Var, StaticStorage, ObjectHash, ObjectEqual> storages_;
+  std::unordered_map<Var, DataType, ObjectHash, ObjectEqual> static_uses_;
+};
+
 class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
  public:
   VMFunctionCompiler(VMCompilerContext* context, TargetsMap targets, Target target_host)
@@ -256,8 +338,10 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
         params_.push_back(param->name_hint());
         ++i;
       }
+      static_storages_ = StaticStorageFinder().Find(inner_func->body);
       this->VisitExpr(inner_func->body);
     } else {
+      static_storages_ = StaticStorageFinder().Find(func->body);
       this->VisitExpr(func->body);
     }
     instructions_.push_back(Instruction::Ret(last_register_));
@@ -281,6 +365,7 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
       case Opcode::Invoke:
       case Opcode::AllocClosure:
       case Opcode::AllocStorage:
+      case Opcode::AllocStaticTensor:
       case Opcode::Move:
       case Opcode::InvokeClosure:
         last_register_ = instr.dst;
@@ -334,6 +419,11 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
 
   void VisitExpr_(const LetNode* let_node) {
     DLOG(INFO) << PrettyPrint(let_node->value);
+    // The storage is allocated together with its tensor.
+    if (static_storages_.count(let_node->var)) {
+      this->VisitExpr(let_node->body);
+      return;
+    }
     this->VisitExpr(let_node->value);
     var_register_map_.insert({let_node->var, this->last_register_});
     this->VisitExpr(let_node->body);
@@ -530,6 +620,28 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
               << "must be the alloc tensor attrs";
           auto dtype = alloc_attrs->dtype;
 
+          auto static_it = args[0].as<VarNode>() ?
+              static_storages_.find(Downcast<Var>(args[0])) : static_storages_.end();
+          if (static_it != static_storages_.end()) {
+            NDArray shape = Downcast<Constant>(args[1])->data;
+            std::vector<int64_t> raw_shape;
+            if (shape->dtype.bits == 64) {
+              raw_shape = ToAllocTensorShape64(shape);
+            } else if (shape->dtype.bits == 32) {
+              raw_shape = ToAllocTensorShape32(shape);
+            } else {
+              LOG(FATAL) << "unsupported bitwidth: " << static_cast<int>(shape->dtype.bits);
+            }
+            const auto& storage = static_it->second;
+            Emit(Instruction::AllocStaticTensor(context_->num_static_slots++,
+                                                storage.allocation_size,
+                                                storage.alignment,
+                                                raw_shape,
+                                                dtype,
+                                                NewRegister()));
+            return;
+          }
+
           // The storage will be passed dynamically.
           this->VisitExpr(args[0]);
           auto storage_register = last_register_;
@@ -735,6 +847,8 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
   std::vector<std::string> params_;
   /*! \brief Map from var to register number. */
   std::unordered_map<Var, RegName, ObjectHash, ObjectEqual> var_register_map_;
+  /*! \brief The storages allocated together with their tensor. */
+  std::unordered_map<Var, StaticStorage, ObjectHash, ObjectEqual> static_storages_;
   /*! \brief Last used register number. */
   size_t last_register_;
   /*! \brief Total number of virtual registers allocated. */
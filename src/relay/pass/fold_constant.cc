@@ -30,7 +30,11 @@
 #include <tvm/runtime/object.h>
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/container.h>
+#include <functional>
+#include <unordered_set>
+#include <vector>
 #include "pattern_util.h"
+#include "../backend/compile_engine.h"
 
 namespace tvm {
 namespace relay {
@@ -78,11 +82,19 @@ TVM_REGISTER_GLOBAL("relay._analysis.check_constant")
 
 // TODO(tvm-team) consider combine dead-code with constant folder.
 // or make a more powerful partial evaluator.
+//
+// The folder does not evaluate a foldable expression when it meets it, it
+// marks it as pending, so the expressions using it can be pending as well.
+// Fold then evaluates the outermost pending expressions of the result
+// together: they are fused and type checked once, their primitive functions
+// are lowered concurrently, and a single run of the interpreter computes them.
+// Identical pending expressions are evaluated once.
 class ConstantFolder : public ExprMutator {
  public:
-  explicit ConstantFolder(FInterpreter executor, IRModule module)
+  explicit ConstantFolder(FInterpreter executor, IRModule module, Target target)
       : executor_(executor),
         module_(module),
+        target_(target),
         shape_of_op_(Op::Get("shape_of")),
         invoke_tvm_op_(Op::Get("memory.invoke_tvm_op")),
         shape_func_op_(Op::Get("memory.shape_func")),
@@ -90,9 +102,35 @@ class ConstantFolder : public ExprMutator {
         alloc_storage_op_(Op::Get("memory.alloc_storage")),
         cast_op_(Op::Get("cast")) {}
 
+  /*!
+   * \brief Fold the constant expressions of an expression.
+   * \param expr The expression.
+   * \return The folded expression.
+   */
+  Expr Fold(const Expr& expr) {
+    Expr res = this->Mutate(expr);
+    if (pending_.empty()) return res;
+
+    // Collect the outermost pending expressions, the identical ones once.
+    std::unordered_map<Expr, size_t, StructuralHash, AlphaEqualFunctor> index;
+    std::unordered_map<Expr, size_t, ObjectHash, ObjectEqual> root_index;
+    Array<Expr> roots;
+    PendingCollector([&](const Expr& e) {
+      auto it = index.find(e);
+      if (it == index.end()) {
+        it = index.emplace(e, roots.size()).first;
+        roots.push_back(e);
+      }
+      root_index[e] = it->second;
+    }, pending_).VisitExpr(res);
+
+    auto values = Downcast<Tuple>(ConstEvaluate(TupleNode::make(roots)));
+    return PendingReplacer(values->fields, root_index).Mutate(res);
+  }
+
   Expr VisitExpr_(const LetNode* op) final {
     Expr value = this->Mutate(op->value);
-    if (value.as<ConstantNode>()) {
+    if (value.as<ConstantNode>() || pending_.count(value)) {
       memo_[op->var] = value;
       return this->Mutate(op->body);
     } else {
@@ -142,22 +180,34 @@ class ConstantFolder : public ExprMutator {
 
     bool all_const_args = true;
     for (Expr arg : call->args) {
-      if (!checker_.Check(arg)) {
+      if (!IsConstant(arg)) {
         all_const_args = false;
       }
     }
     if (all_const_args) {
-      return ConstEvaluate(res);
+      return MarkPending(res);
     } else {
       return res;
     }
   }
 
+  Expr VisitExpr_(const TupleNode* op) final {
+    Expr res = ExprMutator::VisitExpr_(op);
+    bool has_pending = false;
+    for (const auto& field : res.as<TupleNode>()->fields) {
+      if (!IsConstant(field)) return res;
+      has_pending = has_pending || pending_.count(field);
+    }
+    return has_pending ? MarkPending(res) : res;
+  }
+
   Expr VisitExpr_(const TupleGetItemNode* op) final {
     Expr res = ExprMutator::VisitExpr_(op);
     op = res.as<TupleGetItemNode>();
     if (const auto* tuple = op->tuple.as<TupleNode>()) {
       return tuple->fields[op->index];
+    } else if (pending_.count(op->tuple)) {
+      return MarkPending(res);
     } else {
       return res;
     }
@@ -170,6 +220,10 @@ class ConstantFolder : public ExprMutator {
   ConstantChecker checker_;
   // Module
   IRModule module_;
+  // The target to lower the pending expressions for.
+  Target target_;
+  // The expressions to evaluate.
+  std::unordered_set<Expr, ObjectHash, ObjectEqual> pending_;
 
   // Cache the following ops for equivalence checking in this pass.
   const Op& shape_of_op_;
@@ -179,6 +233,78 @@ class ConstantFolder : public ExprMutator {
   const Op& alloc_storage_op_;
   const Op& cast_op_;
 
+  // Equality of the pending expressions to evaluate once.
+  struct AlphaEqualFunctor {
+    bool operator()(const Expr& lhs, const Expr& rhs) const {
+      return AlphaEqual(lhs, rhs);
+    }
+  };
+
+  // Visit the outermost pending expressions.
+  class PendingCollector : public ExprVisitor {
+   public:
+    PendingCollector(std::function<void(const Expr&)> fvisit,
+                     const std::unordered_set<Expr, ObjectHash, ObjectEqual>& pending)
+        : fvisit_(fvisit), pending_(pending) {}
+
+    void VisitExpr(const Expr& expr) final {
+      if (pending_.count(expr)) {
+        fvisit_(expr);
+      } else {
+        ExprVisitor::VisitExpr(expr);
+      }
+    }
+
+   private:
+    std::function<void(const Expr&)> fvisit_;
+    const std::unordered_set<Expr, ObjectHash, ObjectEqual>& pending_;
+  };
+
+  // Replace the outermost pending expressions by their values.
+  class PendingReplacer : public ExprMutator {
+   public:
+    PendingReplacer(const Array<Expr>& values,
+                    const std::unordered_map<Expr, size_t, ObjectHash, ObjectEqual>& index)
+        : values_(values), index_(index) {}
+
+    Expr VisitExpr(const Expr& expr) final {
+      auto it = index_.find(expr);
+      return it != index_.end() ? values_[it->second] : ExprMutator::VisitExpr(expr);
+    }
+
+   private:
+    const Array<Expr>& values_;
+    const std::unordered_map<Expr, size_t, ObjectHash, ObjectEqual>& index_;
+  };
+
+  // Check whether an expression is a constant or pending.
+  bool IsConstant(const Expr& expr) {
+    return pending_.count(expr) || checker_.Check(expr);
+  }
+
+  // Mark an expression to be evaluated by Fold.
+  Expr MarkPending(const Expr& expr) {
+    pending_.insert(expr);
+    return expr;
+  }
+
+  // Lower the primitive functions called by an expression on the build threads.
+  void LowerPrimitives(const Expr& expr) {
+    std::unordered_set<CCacheKey> visited;
+    Array<CCacheKey> keys;
+    PostOrderVisit(expr, [&](const Expr& e) {
+      const auto* call = e.as<CallNode>();
+      const auto* func = call != nullptr ? call->op.as<FunctionNode>() : nullptr;
+      if (func == nullptr || !func->IsPrimitive() || !func->UseDefaultCompiler()) return;
+      CCacheKey key = CCacheKeyNode::make(GetRef<Function>(func), target_);
+      if (visited.insert(key).second) keys.push_back(key);
+    });
+    if (keys.size() > 1) {
+      CompileEngine engine = CompileEngine::Global();
+      engine->LowerAll(keys);
+    }
+  }
+
   // Convert value to expression.
   Expr ObjectToExpr(const ObjectRef& value) {
     if (value->IsInstance<runtime::NDArray::ContainerType>()) {
@@ -221,6 +347,7 @@ class ConstantFolder : public ExprMutator {
     mod = seq(mod);
     auto entry_func = Downcast<Function>(mod->Lookup("main"));
     expr = expr.as<FunctionNode>() == nullptr ? entry_func->body : entry_func;
+    LowerPrimitives(expr);
     return ObjectToExpr(executor_(expr));
   }
 
@@ -274,7 +401,7 @@ class ConstantFolder : public ExprMutator {
     auto cast_attrs = make_object<CastAttrs>();
     cast_attrs->dtype = param->dtype;
     Expr ret = CallNode::make(cast_op_, { shape }, Attrs(cast_attrs), {});
-    return ConstEvaluate(ret);
+    return MarkPending(ret);
   }
 };
 
@@ -288,7 +415,7 @@ Expr FoldConstant(const Expr& expr, const IRModule& mod) {
   // in case we are already in a build context.
   With<BuildConfig> fresh_build_ctx(BuildConfig::Create());
 
-  return ConstantFolder(CreateInterpreter(mod, ctx, target), mod).Mutate(expr);
+  return ConstantFolder(CreateInterpreter(mod, ctx, target), mod, target).Fold(expr);
 }
 
 namespace transform {
@@ -35,6 +35,7 @@
 #include <cstdlib>
 #include <cctype>
 #include "runtime_base.h"
+#include "workspace_pool.h"
 #include "object_internal.h"
 
 namespace tvm {
@@ -421,9 +422,16 @@ void* TVMBackendAllocWorkspace(int device_type,
   type_hint.bits = static_cast<decltype(type_hint.bits)>(dtype_bits_hint);
   type_hint.lanes = 1;
 
-  return DeviceAPIManager::Get(ctx)->AllocWorkspace(ctx,
-                                                    static_cast<size_t>(size),
-                                                    type_hint);
+  WorkspaceArena* arena = WorkspaceArena::Current();
+  if (arena != nullptr) {
+    void* ptr = arena->Alloc(ctx, static_cast<size_t>(size));
+    if (ptr != nullptr) return ptr;
+  }
+  void* ptr = DeviceAPIManager::Get(ctx)->AllocWorkspace(ctx,
+                                                         static_cast<size_t>(size),
+                                                         type_hint);
+  if (arena != nullptr) arena->AddFallback(ptr, static_cast<size_t>(size));
+  return ptr;
 }
 
 int TVMBackendFreeWorkspace(int device_type,
@@ -432,6 +440,8 @@ int TVMBackendFreeWorkspace(int device_type,
   TVMContext ctx;
   ctx.device_type = static_cast<DLDeviceType>(device_type);
   ctx.device_id = device_id;
+  WorkspaceArena* arena = WorkspaceArena::Current();
+  if (arena != nullptr && arena->Free(ptr)) return 0;
   DeviceAPIManager::Get(ctx)->FreeWorkspace(ctx, ptr);
   return 0;
 }
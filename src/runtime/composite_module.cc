@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file composite_module.cc
+ * \brief Module without code of its own that groups its imported modules.
+ */
+#include <dmlc/io.h>
+#include <tvm/runtime/registry.h>
+#include <string>
+
+#include "composite_module.h"
+
+namespace tvm {
+namespace runtime {
+
+class CompositeModuleNode : public ModuleNode {
+ public:
+  const char* type_key() const final {
+    return "composite";
+  }
+
+  PackedFunc GetFunction(const std::string& name,
+                         const ObjectPtr<Object>& sptr_to_self) final {
+    for (Module& m : imports_) {
+      PackedFunc pf = m.GetFunction(name, false);
+      if (pf != nullptr) return pf;
+    }
+    return PackedFunc();
+  }
+
+  void SaveToBinary(dmlc::Stream* stream) final {
+    // The imports are saved by the import tree, there is nothing else.
+  }
+};
+
+Module CompositeModuleCreate() {
+  return Module(make_object<CompositeModuleNode>());
+}
+
+TVM_REGISTER_GLOBAL("runtime.module.loadbinary_composite")
+.set_body_typed([](void* strm) {
+  return CompositeModuleCreate();
+});
+
+TVM_REGISTER_GLOBAL("runtime.CompositeModuleCreate")
+.set_body_typed(CompositeModuleCreate);
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,44 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file composite_module.h
+ * \brief Module without code of its own that groups its imported modules.
+ */
+#ifndef TVM_RUNTIME_COMPOSITE_MODULE_H_
+#define TVM_RUNTIME_COMPOSITE_MODULE_H_
+
+#include <tvm/runtime/module.h>
+
+namespace tvm {
+namespace runtime {
+/*!
+ * \brief Create an empty composite module.
+ *
+ *  The functions of a composite module are the ones of its direct imports,
+ *  so modules built separately can be imported and looked up as one. It is
+ *  serialized with the import tree, so a composite root can be exported
+ *  with export_library.
+ * \return The created module.
+ */
+Module CompositeModuleCreate();
+
+}  // namespace runtime
+}  // namespace tvm
+#endif  // TVM_RUNTIME_COMPOSITE_MODULE_H_
@@ -24,16 +24,181 @@
 #include <dmlc/thread_local.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/device_api.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include "workspace_pool.h"
 
 #ifdef __ANDROID__
 #include <android/api-level.h>
 #endif
 
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define TVM_CPU_LARGE_ALLOC 1
+#endif
+
 namespace tvm {
 namespace runtime {
+
+#if TVM_CPU_LARGE_ALLOC
+/*!
+ * \brief Placement of large CPU arrays.
+ *
+ *  Arrays of at least TVM_CPU_HUGE_PAGE_THRESHOLD bytes (2MB by default) are
+ *  mapped directly instead of going through posix_memalign, so that
+ *  - TVM_CPU_HUGE_PAGES=thp asks for transparent huge pages with madvise,
+ *    =explicit maps from the hugetlbfs pool and falls back to thp;
+ *  - TVM_CPU_NUMA_POLICY=interleave spreads the pages over all nodes,
+ *    =local binds them to the node of the allocating thread, and
+ *    =<node id> binds them to that node.
+ *  Both are off by default.
+ */
+class LargeAllocator {
+ public:
+  LargeAllocator() {
+    const char* val = getenv("TVM_CPU_HUGE_PAGES");
+    std::string huge = val ? val : "";
+    if (huge == "thp") {
+      huge_pages_ = kTransparent;
+    } else if (huge == "explicit") {
+      huge_pages_ = kExplicit;
+    } else {
+      CHECK(huge.empty() || huge == "off") << "Unknown TVM_CPU_HUGE_PAGES " << huge;
+    }
+    val = getenv("TVM_CPU_HUGE_PAGE_THRESHOLD");
+    if (val != nullptr) {
+      threshold_ = std::max(static_cast<size_t>(atoll(val)), static_cast<size_t>(kPageSize));
+    }
+    val = getenv("TVM_CPU_NUMA_POLICY");
+    std::string numa = val ? val : "";
+    if (numa == "interleave") {
+      numa_policy_ = kInterleave;
+    } else if (numa == "local") {
+      numa_policy_ = kLocal;
+    } else if (!numa.empty()) {
+      CHECK(isdigit(numa[0])) << "Unknown TVM_CPU_NUMA_POLICY " << numa;
+      numa_policy_ = kNode;
+      numa_node_ = atoi(numa.c_str());
+    }
+    active_ = huge_pages_ != kOff || numa_policy_ != kNone;
+  }
+
+  bool Enabled(size_t nbytes, size_t alignment) const {
+    return active_ && nbytes >= threshold_ && alignment <= kPageSize;
+  }
+
+  void* Alloc(size_t nbytes) {
+    size_t size = (nbytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    void* ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (huge_pages_ == kExplicit) {
+      ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (ptr == MAP_FAILED) {
+        LOG(WARNING) << "No explicit huge pages left for " << size
+                     << " bytes, fall back to transparent huge pages";
+      }
+    }
+#endif
+    if (ptr == MAP_FAILED) {
+      ptr = MapAligned(size);
+#ifdef MADV_HUGEPAGE
+      if (huge_pages_ != kOff) madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+    }
+    // the pages are placed at first touch, after the policy is set.
+    this->Bind(ptr, size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    mapped_[ptr] = size;
+    return ptr;
+  }
+
+  bool Free(void* ptr) {
+    if (!active_) return false;
+    size_t size;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = mapped_.find(ptr);
+      if (it == mapped_.end()) return false;
+      size = it->second;
+      mapped_.erase(it);
+    }
+    munmap(ptr, size);
+    return true;
+  }
+
+  static LargeAllocator* Global() {
+    static LargeAllocator* inst = new LargeAllocator();
+    return inst;
+  }
+
+ private:
+  enum HugePages { kOff, kTransparent, kExplicit };
+  enum NumaPolicy { kNone, kInterleave, kLocal, kNode };
+  static constexpr size_t kPageSize = 4096;
+  static constexpr size_t kHugePageSize = 2 << 20;
+
+  // Map size bytes aligned to the huge page size, so THP can back all of them.
+  static void* MapAligned(size_t size) {
+    void* base = mmap(nullptr, size + kHugePageSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) throw std::bad_alloc();
+    uintptr_t addr = reinterpret_cast<uintptr_t>(base);
+    uintptr_t aligned = (addr + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    if (aligned != addr) munmap(base, aligned - addr);
+    size_t tail = kHugePageSize - (aligned - addr);
+    if (tail != 0) munmap(reinterpret_cast<void*>(aligned + size), tail);
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  void Bind(void* ptr, size_t size) const {
+#ifdef SYS_mbind
+    // values of linux/mempolicy.h, numaif.h is not always installed.
+    constexpr int kMPolBind = 2;
+    constexpr int kMPolInterleave = 3;
+    constexpr int kMaxNodes = 1024;
+    constexpr int kBits = sizeof(unsigned long) * 8;  // NOLINT(*)
+    if (numa_policy_ == kNone) return;
+    unsigned long mask[kMaxNodes / kBits] = {0};  // NOLINT(*)
+    int mode = kMPolBind;
+    if (numa_policy_ == kInterleave) {
+      mode = kMPolInterleave;
+      for (auto& m : mask) m = ~0UL;
+    } else {
+      int node = numa_node_;
+      if (numa_policy_ == kLocal) {
+        unsigned cpu = 0, cur = 0;
+        if (syscall(SYS_getcpu, &cpu, &cur, nullptr) != 0) return;
+        node = static_cast<int>(cur);
+      }
+      if (node >= kMaxNodes) return;
+      mask[node / kBits] |= 1UL << (node % kBits);
+    }
+    if (syscall(SYS_mbind, ptr, size, mode, mask, kMaxNodes, 0) != 0) {
+      LOG(WARNING) << "mbind failed, the array uses the default NUMA placement";
+    }
+#endif
+  }
+
+  bool active_{false};
+  HugePages huge_pages_{kOff};
+  NumaPolicy numa_policy_{kNone};
+  int numa_node_{0};
+  size_t threshold_{kHugePageSize};
+  std::mutex mutex_;
+  /*! \brief Size of each mapped array. */
+  std::unordered_map<void*, size_t> mapped_;
+};
+#endif  // TVM_CPU_LARGE_ALLOC
+
 class CPUDeviceAPI final : public DeviceAPI {
  public:
   void SetDevice(TVMContext ctx) final {}
@@ -47,6 +212,11 @@ class CPUDeviceAPI final : public DeviceAPI {
                        size_t alignment,
                        DLDataType type_hint) final {
     void* ptr;
+#if TVM_CPU_LARGE_ALLOC
+    if (LargeAllocator::Global()->Enabled(nbytes, alignment)) {
+      return LargeAllocator::Global()->Alloc(nbytes);
+    }
+#endif
 #if _MSC_VER
     ptr = _aligned_malloc(nbytes, alignment);
     if (ptr == nullptr) throw std::bad_alloc();
@@ -62,6 +232,9 @@ class CPUDeviceAPI final : public DeviceAPI {
   }
 
   void FreeDataSpace(TVMContext ctx, void* ptr) final {
+#if TVM_CPU_LARGE_ALLOC
+    if (LargeAllocator::Global()->Free(ptr)) return;
+#endif
 #if _MSC_VER
     _aligned_free(ptr);
 #else
@@ -24,10 +24,19 @@
 #include <dmlc/logging.h>
 #include <tvm/runtime/serializer.h>
 #include <fstream>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 #include "file_util.h"
 
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define TVM_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace tvm {
 namespace runtime {
 
@@ -163,5 +172,64 @@ void RemoveFile(const std::string& file_name) {
   std::remove(file_name.c_str());
 }
 
+#ifdef TVM_USE_MMAP
+MappedFile::MappedFile(const std::string& file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  CHECK_GE(fd, 0) << "Cannot open " << file_name;
+  struct stat st;
+  CHECK_EQ(fstat(fd, &st), 0) << "Cannot stat " << file_name;
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ != 0) {
+    void* ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    CHECK(ptr != MAP_FAILED) << "Cannot map " << file_name;
+    data_ = static_cast<char*>(ptr);
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) munmap(data_, size_);
+}
+#else
+MappedFile::MappedFile(const std::string& file_name) {
+  LoadBinaryFromFile(file_name, &buffer_);
+  data_ = buffer_.empty() ? nullptr : &buffer_[0];
+  size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile() {}
+#endif  // TVM_USE_MMAP
+
+namespace {
+/*! \brief Keeps the mapped file alive for an array in it. */
+struct MappedArray {
+  std::shared_ptr<MappedFile> file;
+  std::vector<int64_t> shape;
+  DLManagedTensor tensor;
+};
+
+void DeleteMappedArray(DLManagedTensor* tensor) {
+  delete static_cast<MappedArray*>(tensor->manager_ctx);
+}
+}  // namespace
+
+NDArray CreateMappedArray(const std::shared_ptr<MappedFile>& file, char* data,
+                          std::vector<int64_t> shape, DLDataType dtype) {
+  MappedArray* array = new MappedArray();
+  array->file = file;
+  array->shape = std::move(shape);
+  DLTensor& t = array->tensor.dl_tensor;
+  t.data = data;
+  t.ctx = DLContext{kDLCPU, 0};
+  t.ndim = static_cast<int>(array->shape.size());
+  t.dtype = dtype;
+  t.shape = array->shape.data();
+  t.strides = nullptr;
+  t.byte_offset = 0;
+  array->tensor.manager_ctx = array;
+  array->tensor.deleter = DeleteMappedArray;
+  return NDArray::FromDLPack(&array->tensor);
+}
+
 }  // namespace runtime
 }  // namespace tvm
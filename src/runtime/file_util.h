@@ -24,8 +24,11 @@
 #ifndef TVM_RUNTIME_FILE_UTIL_H_
 #define TVM_RUNTIME_FILE_UTIL_H_
 
+#include <tvm/runtime/ndarray.h>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "meta_data.h"
 
 namespace tvm {
@@ -96,6 +99,45 @@ void LoadMetaDataFromFile(
  * \param file_name The file name.
  */
 void RemoveFile(const std::string& file_name);
+
+/*!
+ * \brief A file mapped into memory.
+ *
+ *  The pages are shared with the page cache until they are written, writes
+ *  stay private to the process. Platforms without mmap read the file instead.
+ */
+class MappedFile {
+ public:
+  /*!
+   * \brief Map a file.
+   * \param file_name The name of the file.
+   */
+  explicit MappedFile(const std::string& file_name);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  /*! \return The start of the file. */
+  char* data() const { return data_; }
+  /*! \return The size of the file. */
+  size_t size() const { return size_; }
+
+ private:
+  char* data_{nullptr};
+  size_t size_{0};
+  /*! \brief The contents when the file is read instead of mapped. */
+  std::string buffer_;
+};
+
+/*!
+ * \brief Create a CPU array over data in a mapped file, without copying it.
+ * \param file The mapped file, kept alive by the array.
+ * \param data The start of the array in the file.
+ * \param shape The shape of the array.
+ * \param dtype The data type of the array.
+ * \return The array.
+ */
+NDArray CreateMappedArray(const std::shared_ptr<MappedFile>& file, char* data,
+                          std::vector<int64_t> shape, DLDataType dtype);
 }  // namespace runtime
 }  // namespace tvm
 #endif  // TVM_RUNTIME_FILE_UTIL_H_
@@ -0,0 +1,378 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file graph_batcher.cc
+ * \brief Dynamic batching of concurrent requests on one graph runtime.
+ */
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/ndarray.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief Packs concurrent requests into the batch dimension of a graph.
+ *
+ *  The graph is compiled for a fixed batch, the first axis of the given
+ *  inputs and of all the outputs. Each request holds a few rows of it. The
+ *  requests are queued and a worker thread runs the graph once the queued
+ *  rows fill the batch, or once the oldest request has waited for the
+ *  latency window. Missing rows are padded with zeros, and the rows of each
+ *  request are copied back to its outputs.
+ */
+class GraphBatcher : public ModuleNode {
+ public:
+  /*!
+   * \param runtime The graph runtime module, only used by the batcher afterwards.
+   * \param input_names The inputs given by each request, in order.
+   * \param max_latency_us How long the oldest request waits for a full batch.
+   */
+  GraphBatcher(Module runtime, const std::vector<std::string>& input_names,
+               int64_t max_latency_us)
+      : runtime_(runtime), max_latency_(max_latency_us) {
+    PackedFunc get_input = runtime_.GetFunction("get_input");
+    PackedFunc get_output = runtime_.GetFunction("get_output");
+    int num_outputs = runtime_.GetFunction("get_num_outputs")();
+    run_ = runtime_.GetFunction("run");
+    CHECK(!input_names.empty()) << "The batcher needs at least one input";
+    for (const std::string& name : input_names) {
+      NDArray arr = get_input(name);
+      inputs_.push_back(arr);
+    }
+    for (int i = 0; i < num_outputs; ++i) {
+      NDArray arr = get_output(i);
+      outputs_.push_back(arr);
+    }
+    CHECK_GE(inputs_[0]->ndim, 1) << "The inputs need a batch axis";
+    batch_size_ = inputs_[0]->shape[0];
+    CHECK_GT(batch_size_, 0);
+    for (const NDArray& arr : inputs_) {
+      CHECK(arr->ndim >= 1 && arr->shape[0] == batch_size_)
+          << "The inputs do not share the batch axis";
+      // The zero rows for padding, on the host.
+      NDArray zeros = NDArray::Empty(std::vector<int64_t>(arr->shape, arr->shape + arr->ndim),
+                                     arr->dtype, DLContext{kDLCPU, 0});
+      std::fill_n(static_cast<char*>(zeros->data), GetDataSize(*zeros.operator->()), 0);
+      padding_.push_back(zeros);
+    }
+    for (const NDArray& arr : outputs_) {
+      CHECK(arr->ndim >= 1 && arr->shape[0] == batch_size_)
+          << "The outputs do not share the batch axis of the inputs";
+    }
+    start_ = Clock::now();
+    worker_ = std::thread([this]() { this->WorkerLoop(); });
+  }
+
+  ~GraphBatcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    queue_cv_.notify_one();
+    worker_.join();
+  }
+
+  const char* type_key() const final {
+    return "GraphBatcher";
+  }
+
+  PackedFunc GetFunction(const std::string& name,
+                         const ObjectPtr<Object>& sptr_to_self) final {
+    if (name == "run") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          CHECK_EQ(static_cast<size_t>(args.num_args), inputs_.size() + outputs_.size())
+              << "Expect the inputs then the outputs of the request";
+          std::vector<DLTensor*> inputs, outputs;
+          for (size_t i = 0; i < inputs_.size(); ++i) {
+            inputs.push_back(args[i]);
+          }
+          for (size_t i = 0; i < outputs_.size(); ++i) {
+            outputs.push_back(args[inputs_.size() + i]);
+          }
+          this->Run(inputs, outputs);
+        });
+    } else if (name == "get_batch_size") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          *rv = batch_size_;
+        });
+    } else if (name == "get_stats") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          *rv = this->GetStats();
+        });
+    } else if (name == "reset_stats") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          this->ResetStats();
+        });
+    } else {
+      return PackedFunc();
+    }
+  }
+
+  /*!
+   * \brief Run one request, blocks until the batch holding it ran.
+   * \param inputs The inputs, with the rows of the request on the first axis.
+   * \param outputs The outputs to fill, with as many rows as the inputs.
+   */
+  void Run(const std::vector<DLTensor*>& inputs, const std::vector<DLTensor*>& outputs) {
+    auto req = std::make_shared<Request>();
+    req->rows = inputs[0]->ndim >= 1 ? inputs[0]->shape[0] : 0;
+    CHECK(req->rows >= 1 && req->rows <= batch_size_)
+        << "A request holds 1 to " << batch_size_ << " rows, not " << req->rows;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      CheckRows(inputs[i], inputs_[i], req->rows);
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      CheckRows(outputs[i], outputs_[i], req->rows);
+    }
+    req->inputs = inputs;
+    req->outputs = outputs;
+    req->arrival = Clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_.push_back(req);
+    queued_rows_ += req->rows;
+    queue_cv_.notify_one();
+    done_cv_.wait(lock, [&req]() { return req->done; });
+    if (!req->error.empty()) {
+      LOG(FATAL) << req->error;
+    }
+  }
+
+  /*! \return The counters as a JSON string. */
+  std::string GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double seconds = std::chrono::duration<double>(Clock::now() - start_).count();
+    std::ostringstream os;
+    os << "{\"requests\": " << stats_.num_requests
+       << ", \"batches\": " << stats_.num_batches
+       << ", \"rows\": " << stats_.num_rows
+       << ", \"padded_rows\": " << stats_.num_padded_rows
+       << ", \"requests_per_sec\": " << (seconds > 0 ? stats_.num_requests / seconds : 0.0)
+       << ", \"mean_latency_us\": "
+       << (stats_.num_requests == 0 ? 0.0 : stats_.total_latency_us / stats_.num_requests)
+       << ", \"max_latency_us\": " << stats_.max_latency_us
+       << ", \"mean_queue_us\": "
+       << (stats_.num_requests == 0 ? 0.0 : stats_.total_queue_us / stats_.num_requests)
+       << "}";
+    return os.str();
+  }
+
+  void ResetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = Stats();
+    start_ = Clock::now();
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Request {
+    std::vector<DLTensor*> inputs;
+    std::vector<DLTensor*> outputs;
+    int64_t rows{0};
+    Clock::time_point arrival;
+    bool done{false};
+    std::string error;
+  };
+
+  struct Stats {
+    uint64_t num_requests{0};
+    uint64_t num_batches{0};
+    uint64_t num_rows{0};
+    uint64_t num_padded_rows{0};
+    double total_latency_us{0};
+    double total_queue_us{0};
+    double max_latency_us{0};
+  };
+
+  static void CheckRows(const DLTensor* arr, const NDArray& entry, int64_t rows) {
+    CHECK(arr->ndim == entry->ndim && arr->shape[0] == rows &&
+          std::equal(arr->shape + 1, arr->shape + arr->ndim, entry->shape + 1) &&
+          arr->dtype.code == entry->dtype.code && arr->dtype.bits == entry->dtype.bits &&
+          arr->dtype.lanes == entry->dtype.lanes)
+        << "The request does not match the graph apart from the " << rows << " rows";
+    // RowView addresses the rows by their byte size.
+    if (arr->strides != nullptr) {
+      int64_t expected = 1;
+      for (int i = arr->ndim - 1; i >= 0; --i) {
+        CHECK(arr->shape[i] == 1 || arr->strides[i] == expected)
+            << "The arrays of a request must be compact";
+        expected *= arr->shape[i];
+      }
+    }
+  }
+
+  // A view of rows [begin, begin + num) of a compact array.
+  static DLTensor RowView(const DLTensor* arr, int64_t begin, int64_t num,
+                          std::vector<int64_t>* shape) {
+    DLTensor view = *arr;
+    shape->assign(arr->shape, arr->shape + arr->ndim);
+    (*shape)[0] = num;
+    view.shape = shape->data();
+    view.byte_offset += begin * (GetDataSize(*arr) / arr->shape[0]);
+    return view;
+  }
+
+  static void CopyRows(const DLTensor* from, int64_t from_row, const DLTensor* to,
+                       int64_t to_row, int64_t num) {
+    std::vector<int64_t> from_shape, to_shape;
+    DLTensor src = RowView(from, from_row, num, &from_shape);
+    DLTensor dst = RowView(to, to_row, num, &to_shape);
+    NDArray::CopyFromTo(&src, &dst);
+  }
+
+  void RunBatch(const std::vector<std::shared_ptr<Request> >& batch) {
+    int64_t offset = 0;
+    for (const auto& req : batch) {
+      for (size_t i = 0; i < inputs_.size(); ++i) {
+        CopyRows(req->inputs[i], 0, inputs_[i].operator->(), offset, req->rows);
+      }
+      offset += req->rows;
+    }
+    if (offset < batch_size_) {
+      for (size_t i = 0; i < inputs_.size(); ++i) {
+        CopyRows(padding_[i].operator->(), 0, inputs_[i].operator->(), offset,
+                 batch_size_ - offset);
+      }
+    }
+    run_();
+    offset = 0;
+    for (const auto& req : batch) {
+      for (size_t i = 0; i < outputs_.size(); ++i) {
+        CopyRows(outputs_[i].operator->(), offset, req->outputs[i], 0, req->rows);
+      }
+      offset += req->rows;
+    }
+    // The copies to the requests may be asynchronous on the device.
+    if (outputs_[0]->ctx.device_type != kDLCPU) {
+      TVMSynchronize(outputs_[0]->ctx.device_type, outputs_[0]->ctx.device_id, nullptr);
+    }
+  }
+
+  void WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      queue_cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) return;
+      // Wait for a full batch, but not past the window of the oldest request.
+      Clock::time_point deadline = queue_.front()->arrival + max_latency_;
+      queue_cv_.wait_until(lock, deadline, [this]() {
+          return stop_ || queued_rows_ >= batch_size_;
+        });
+      std::vector<std::shared_ptr<Request> > batch;
+      int64_t rows = 0;
+      while (!queue_.empty() && rows + queue_.front()->rows <= batch_size_) {
+        rows += queue_.front()->rows;
+        batch.push_back(queue_.front());
+        queue_.pop_front();
+      }
+      queued_rows_ -= rows;
+      Clock::time_point begin = Clock::now();
+      lock.unlock();
+      std::string error;
+      try {
+        RunBatch(batch);
+      } catch (const std::exception& e) {
+        error = e.what();
+      } catch (...) {
+        error = "The batch failed with an unknown exception";
+      }
+      Clock::time_point end = Clock::now();
+      lock.lock();
+      stats_.num_batches += 1;
+      stats_.num_rows += rows;
+      stats_.num_padded_rows += batch_size_ - rows;
+      for (const auto& req : batch) {
+        double latency = std::chrono::duration<double, std::micro>(end - req->arrival).count();
+        stats_.num_requests += 1;
+        stats_.total_latency_us += latency;
+        stats_.total_queue_us +=
+            std::chrono::duration<double, std::micro>(begin - req->arrival).count();
+        stats_.max_latency_us = std::max(stats_.max_latency_us, latency);
+        req->error = error;
+        req->done = true;
+      }
+      done_cv_.notify_all();
+    }
+  }
+
+  /*! \brief The graph runtime. */
+  Module runtime_;
+  /*! \brief The run function of the graph runtime. */
+  PackedFunc run_;
+  /*! \brief The batched inputs given by the requests. */
+  std::vector<NDArray> inputs_;
+  /*! \brief The batched outputs. */
+  std::vector<NDArray> outputs_;
+  /*! \brief Zero rows for each input, to pad a batch. */
+  std::vector<NDArray> padding_;
+  /*! \brief The batch size the graph was compiled for. */
+  int64_t batch_size_{0};
+  /*! \brief How long the oldest request waits for a full batch. */
+  std::chrono::microseconds max_latency_;
+  /*! \brief Protects the queue and the counters. */
+  std::mutex mutex_;
+  /*! \brief Wakes the worker on a new request. */
+  std::condition_variable queue_cv_;
+  /*! \brief Wakes the requests once their batch ran. */
+  std::condition_variable done_cv_;
+  /*! \brief The requests waiting for a batch. */
+  std::deque<std::shared_ptr<Request> > queue_;
+  /*! \brief The rows of the queued requests. */
+  int64_t queued_rows_{0};
+  /*! \brief Whether the batcher is being destroyed. */
+  bool stop_{false};
+  /*! \brief The counters. */
+  Stats stats_;
+  /*! \brief The start of the counters. */
+  Clock::time_point start_;
+  /*! \brief The thread running the batches. */
+  std::thread worker_;
+};
+
+TVM_REGISTER_GLOBAL("tvm.graph_runtime.create_batcher")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    CHECK_GE(args.num_args, 3)
+        << "Expect the runtime, the latency window in microseconds and the input names";
+    Module runtime = args[0];
+    int64_t max_latency_us = args[1];
+    std::vector<std::string> input_names;
+    for (int i = 2; i < args.num_args; ++i) {
+      input_names.push_back(args[i].operator std::string());
+    }
+    auto batcher = make_object<GraphBatcher>(runtime, input_names, max_latency_us);
+    *rv = Module(batcher);
+  });
+
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,444 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file graph_pipeline.cc
+ * \brief Pipelined execution of a graph split into stages.
+ */
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/threading_backend.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "graph_runtime.h"
+
+namespace tvm {
+namespace runtime {
+
+namespace {
+/*!
+ * \brief Split the costs into consecutive non-empty parts, minimizing the
+ *  cost of the largest part.
+ * \param cost The cost of each item.
+ * \param num_parts The number of parts, at most the number of items.
+ * \return The first item of each part.
+ */
+std::vector<size_t> PartitionByCost(const std::vector<double>& cost, size_t num_parts) {
+  size_t n = cost.size();
+  CHECK(num_parts >= 1 && num_parts <= n);
+  std::vector<double> prefix(n + 1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    prefix[i + 1] = prefix[i] + cost[i];
+  }
+  // best[k][i]: the largest part when the first i items form k + 1 parts.
+  std::vector<std::vector<double> > best(num_parts, std::vector<double>(n + 1));
+  std::vector<std::vector<size_t> > cut(num_parts, std::vector<size_t>(n + 1, 0));
+  for (size_t i = 1; i <= n; ++i) {
+    best[0][i] = prefix[i];
+  }
+  for (size_t k = 1; k < num_parts; ++k) {
+    for (size_t i = k + 1; i <= n; ++i) {
+      best[k][i] = std::numeric_limits<double>::infinity();
+      for (size_t j = k; j < i; ++j) {
+        double largest = std::max(best[k - 1][j], prefix[i] - prefix[j]);
+        if (largest < best[k][i]) {
+          best[k][i] = largest;
+          cut[k][i] = j;
+        }
+      }
+    }
+  }
+  std::vector<size_t> begin(num_parts, 0);
+  size_t end = n;
+  for (size_t k = num_parts - 1; k > 0; --k) {
+    end = cut[k][end];
+    begin[k] = end;
+  }
+  return begin;
+}
+}  // namespace
+
+/*!
+ * \brief Streams micro-batches through a graph split into stages.
+ *
+ *  The nodes are split into consecutive ranges of about the same measured
+ *  cost, and each range is run by its own thread, bound to its own thread
+ *  pool. Every micro-batch in flight holds a slot, an executor of the model
+ *  with its own intermediate storage, which is passed from one stage to the
+ *  next through a queue. While a stage runs a micro-batch the previous
+ *  stage already runs the next one, so the stages overlap like a CPU
+ *  pipeline and the results come out in submission order.
+ */
+class GraphPipeline : public ModuleNode {
+ public:
+  /*!
+   * \param model The model, each slot is an executor created from it.
+   * \param num_stages The number of stages.
+   * \param num_slots The number of micro-batches in flight, 0 for num_stages + 1.
+   * \param profile_repeat The number of runs measuring the cost of the nodes.
+   * \param pool_names The thread pool of each stage, empty for none or an
+   *  empty name to use the own pool of the stage thread.
+   */
+  GraphPipeline(Module model, int num_stages, int num_slots, int profile_repeat,
+                const std::vector<std::string>& pool_names)
+      : model_(model) {
+    CHECK_EQ(std::string(model->type_key()), "GraphModel")
+        << "The pipeline is created from a model, not a " << model->type_key();
+    CHECK_GE(num_stages, 1);
+    CHECK(pool_names.empty() || pool_names.size() == static_cast<size_t>(num_stages))
+        << "Expect a thread pool for each of the " << num_stages << " stages";
+    if (num_slots == 0) num_slots = num_stages + 1;
+    CHECK_GE(num_slots, 1);
+    const GraphModel* graph_model = static_cast<const GraphModel*>(model.operator->());
+    for (int i = 0; i < num_slots; ++i) {
+      Slot slot;
+      slot.module = graph_model->CreateExecutor();
+      slot.runtime = static_cast<GraphRuntime*>(slot.module.operator->());
+      slots_.push_back(slot);
+      free_.push_back(i);
+    }
+    this->SetupStages(num_stages, profile_repeat, pool_names);
+    start_ = Clock::now();
+    for (size_t s = 0; s < stages_.size(); ++s) {
+      stages_[s]->thread = std::thread([this, s]() { this->StageLoop(s); });
+    }
+  }
+
+  ~GraphPipeline() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    for (auto& stage : stages_) {
+      stage->cv.notify_one();
+    }
+    for (auto& stage : stages_) {
+      stage->thread.join();
+    }
+  }
+
+  const char* type_key() const final {
+    return "GraphPipeline";
+  }
+
+  PackedFunc GetFunction(const std::string& name,
+                         const ObjectPtr<Object>& sptr_to_self) final {
+    if (name == "submit") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          CHECK_EQ(args.num_args % 2, 0) << "Expect pairs of input name and value";
+          std::vector<std::pair<std::string, DLTensor*> > inputs;
+          for (int i = 0; i < args.num_args; i += 2) {
+            inputs.emplace_back(args[i].operator std::string(), args[i + 1]);
+          }
+          this->Submit(inputs);
+        });
+    } else if (name == "wait") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          std::vector<DLTensor*> outputs;
+          for (int i = 0; i < args.num_args; ++i) {
+            outputs.push_back(args[i]);
+          }
+          this->Wait(outputs);
+        });
+    } else if (name == "get_num_outputs") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          *rv = slots_[0].runtime->NumOutputs();
+        });
+    } else if (name == "get_output") {
+      // Only meant for the shape and type, the contents belong to a slot.
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          *rv = slots_[0].runtime->GetOutput(args[0]);
+        });
+    } else if (name == "get_num_slots") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          *rv = static_cast<int>(slots_.size());
+        });
+    } else if (name == "get_stats") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          *rv = this->GetStats();
+        });
+    } else if (name == "reset_stats") {
+      return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+          this->ResetStats();
+        });
+    } else {
+      return PackedFunc();
+    }
+  }
+
+  /*!
+   * \brief Set the inputs of a free slot and send it through the stages.
+   * \param inputs The inputs by name, they are copied.
+   */
+  void Submit(const std::vector<std::pair<std::string, DLTensor*> >& inputs) {
+    int id;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      CHECK(!free_.empty())
+          << "All the " << slots_.size() << " slots are in flight, wait for a result first";
+      id = free_.front();
+      free_.pop_front();
+    }
+    GraphRuntime* runtime = slots_[id].runtime;
+    try {
+      for (const auto& input : inputs) {
+        int index = runtime->GetInputIndex(input.first);
+        CHECK_GE(index, 0) << "Cannot find input " << input.first;
+        runtime->SetInput(index, input.second);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_.push_front(id);
+      throw;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_[id].done = false;
+    slots_[id].error.clear();
+    in_flight_.push_back(id);
+    stages_[0]->queue.push_back(id);
+    stages_[0]->cv.notify_one();
+  }
+
+  /*!
+   * \brief Wait for the oldest micro-batch in flight and copy its outputs.
+   * \param outputs The arrays receiving the first outputs of the graph.
+   */
+  void Wait(const std::vector<DLTensor*>& outputs) {
+    GraphRuntime* runtime = slots_[0].runtime;
+    CHECK_LE(outputs.size(), static_cast<size_t>(runtime->NumOutputs()));
+    std::unique_lock<std::mutex> lock(mutex_);
+    CHECK(!in_flight_.empty()) << "No micro-batch is in flight";
+    int id = in_flight_.front();
+    in_flight_.pop_front();
+    done_cv_.wait(lock, [this, id]() { return slots_[id].done; });
+    std::string error = slots_[id].error;
+    lock.unlock();
+    if (error.empty()) {
+      try {
+        for (size_t i = 0; i < outputs.size(); ++i) {
+          slots_[id].runtime->CopyOutputTo(static_cast<int>(i), outputs[i]);
+        }
+      } catch (const std::exception& e) {
+        error = e.what();
+      } catch (...) {
+        error = "Copying the outputs failed with an unknown exception";
+      }
+    }
+    lock.lock();
+    free_.push_back(id);
+    lock.unlock();
+    if (!error.empty()) {
+      LOG(FATAL) << error;
+    }
+  }
+
+  /*! \return The layout and utilization of the stages as a JSON string. */
+  std::string GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double seconds = std::chrono::duration<double>(Clock::now() - start_).count();
+    double wall_us = seconds * 1e6;
+    std::ostringstream os;
+    os << "{\"batches\": " << num_batches_
+       << ", \"batches_per_sec\": " << (seconds > 0 ? num_batches_ / seconds : 0.0)
+       << ", \"stages\": [";
+    for (size_t s = 0; s < stages_.size(); ++s) {
+      const Stage& stage = *stages_[s];
+      if (s != 0) os << ", ";
+      os << "{\"begin\": " << stage.begin
+         << ", \"end\": " << stage.end
+         << ", \"pool\": \"" << stage.pool_name << "\""
+         << ", \"estimated_us\": " << stage.estimated_us
+         << ", \"busy_us\": " << stage.busy_us
+         << ", \"utilization\": " << (wall_us > 0 ? stage.busy_us / wall_us : 0.0)
+         << "}";
+    }
+    os << "]}";
+    return os.str();
+  }
+
+  void ResetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& stage : stages_) {
+      stage->busy_us = 0;
+    }
+    num_batches_ = 0;
+    start_ = Clock::now();
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Slot {
+    /*! \brief The executor holding the storage of the micro-batch. */
+    Module module;
+    GraphRuntime* runtime{nullptr};
+    /*! \brief Whether the last stage ran the micro-batch. */
+    bool done{true};
+    /*! \brief The error of the stage that failed, the later stages skip the slot. */
+    std::string error;
+  };
+
+  struct Stage {
+    /*! \brief The nodes [begin, end) run by the stage. */
+    uint32_t begin{0};
+    uint32_t end{0};
+    std::string pool_name;
+    std::shared_ptr<ThreadPool> pool;
+    double estimated_us{0};
+    double busy_us{0};
+    /*! \brief The slots waiting for the stage. */
+    std::deque<int> queue;
+    std::condition_variable cv;
+    std::thread thread;
+  };
+
+  void SetupStages(int num_stages, int profile_repeat,
+                   const std::vector<std::string>& pool_names) {
+    GraphRuntime* runtime = slots_[0].runtime;
+    std::vector<double> node_cost = runtime->ProfileNodes(profile_repeat);
+    // Only the operator nodes are split, the others cost nothing.
+    std::vector<uint32_t> op_nodes;
+    std::vector<double> op_cost;
+    for (uint32_t nid = 0; nid < node_cost.size(); ++nid) {
+      if (runtime->GetNodeOpType(nid) == "tvm_op") {
+        op_nodes.push_back(nid);
+        op_cost.push_back(node_cost[nid]);
+      }
+    }
+    CHECK_LE(static_cast<size_t>(num_stages), op_nodes.size())
+        << "Cannot split " << op_nodes.size() << " operators into " << num_stages << " stages";
+    std::vector<size_t> first_op = PartitionByCost(op_cost, num_stages);
+    for (int s = 0; s < num_stages; ++s) {
+      std::unique_ptr<Stage> stage(new Stage());
+      size_t op_begin = first_op[s];
+      size_t op_end = s + 1 < num_stages ? first_op[s + 1] : op_nodes.size();
+      stage->begin = s == 0 ? 0 : op_nodes[op_begin];
+      stage->end = s + 1 < num_stages ? op_nodes[op_end] : runtime->GetNumOfNodes();
+      for (size_t i = op_begin; i < op_end; ++i) {
+        stage->estimated_us += op_cost[i];
+      }
+      if (!pool_names.empty()) {
+        stage->pool_name = pool_names[s];
+        stage->pool = threading::GetThreadPool(pool_names[s]);
+      }
+      stages_.push_back(std::move(stage));
+    }
+    // The copies to the next stage may be asynchronous on the device.
+    sync_ctx_ = runtime->GetOutput(0)->ctx;
+  }
+
+  void StageLoop(size_t index) {
+    Stage& stage = *stages_[index];
+    threading::ThreadPoolScope scope(stage.pool);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      stage.cv.wait(lock, [this, &stage]() { return stop_ || !stage.queue.empty(); });
+      if (stage.queue.empty()) return;
+      int id = stage.queue.front();
+      stage.queue.pop_front();
+      Slot& slot = slots_[id];
+      bool failed = !slot.error.empty();
+      lock.unlock();
+      std::string error;
+      Clock::time_point begin = Clock::now();
+      if (!failed) {
+        try {
+          slot.runtime->RunNodes(stage.begin, stage.end);
+          if (sync_ctx_.device_type != kDLCPU) {
+            TVMSynchronize(sync_ctx_.device_type, sync_ctx_.device_id, nullptr);
+          }
+        } catch (const std::exception& e) {
+          error = e.what();
+        } catch (...) {
+          error = "The stage failed with an unknown exception";
+        }
+      }
+      Clock::time_point end = Clock::now();
+      lock.lock();
+      stage.busy_us += std::chrono::duration<double, std::micro>(end - begin).count();
+      if (!error.empty()) slot.error = error;
+      if (index + 1 < stages_.size()) {
+        stages_[index + 1]->queue.push_back(id);
+        stages_[index + 1]->cv.notify_one();
+      } else {
+        num_batches_ += 1;
+        slot.done = true;
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  /*! \brief The model shared by the slots. */
+  Module model_;
+  /*! \brief The storage of each micro-batch in flight. */
+  std::vector<Slot> slots_;
+  /*! \brief The stages, in node order. */
+  std::vector<std::unique_ptr<Stage> > stages_;
+  /*! \brief The device synchronized at the end of each stage. */
+  TVMContext sync_ctx_;
+  /*! \brief Protects the queues, the slots states and the counters. */
+  std::mutex mutex_;
+  /*! \brief Wakes the waiting caller once the last stage ran a slot. */
+  std::condition_variable done_cv_;
+  /*! \brief The slots not in flight. */
+  std::deque<int> free_;
+  /*! \brief The slots in flight, in submission order. */
+  std::deque<int> in_flight_;
+  /*! \brief The micro-batches done since the start of the counters. */
+  uint64_t num_batches_{0};
+  /*! \brief The start of the counters. */
+  Clock::time_point start_;
+  /*! \brief Whether the pipeline is being destroyed. */
+  bool stop_{false};
+};
+
+TVM_REGISTER_GLOBAL("tvm.graph_runtime.create_pipeline")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    CHECK_GE(args.num_args, 4)
+        << "Expect the model, the number of stages and slots, the profile repeat "
+           "and the thread pool names";
+    Module model = args[0];
+    int num_stages = args[1];
+    int num_slots = args[2];
+    int profile_repeat = args[3];
+    std::vector<std::string> pool_names;
+    for (int i = 4; i < args.num_args; ++i) {
+      pool_names.push_back(args[i].operator std::string());
+    }
+    auto pipeline = make_object<GraphPipeline>(
+        model, num_stages, num_slots, profile_repeat, pool_names);
+    *rv = Module(pipeline);
+  });
+
+}  // namespace runtime
+}  // namespace tvm
@@ -20,6 +20,7 @@
 /*!
  * \file graph_runtime.cc
  */
+#include <tvm/runtime/c_backend_api.h>
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/packed_func.h>
@@ -27,8 +28,12 @@
 #include <tvm/runtime/serializer.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <string>
 #include <unordered_set>
@@ -36,6 +41,7 @@
 #include <vector>
 
 #include "graph_runtime.h"
+#include "../file_util.h"
 
 namespace tvm {
 namespace runtime {
@@ -51,11 +57,125 @@ inline size_t GetDataAlignment(const DLTensor& arr) {
  * \brief Run all the operations one by one.
  */
 void GraphRuntime::Run() {
-  // setup the array and requirements.
-  for (size_t i = 0; i < op_execs_.size(); ++i) {
+  {
+    threading::ThreadPoolScope scope(thread_pool_);
+    // concurrent operators request workspaces from several threads, use the pools.
+    WorkspaceArena::Scope arena_scope(
+        inter_op_parallelism_ > 1 ? nullptr : workspace_arena_.get());
+    if (inter_op_parallelism_ > 1) {
+      this->RunInterOpParallel();
+    } else {
+      // setup the array and requirements.
+      for (size_t i = 0; i < op_execs_.size(); ++i) {
+        if (op_execs_[i]) op_execs_[i]();
+      }
+    }
+  }
+}
+
+void GraphRuntime::RunNodes(uint32_t begin, uint32_t end) {
+  CHECK_LE(begin, end);
+  CHECK_LE(end, op_execs_.size());
+  for (uint32_t i = begin; i < end; ++i) {
     if (op_execs_[i]) op_execs_[i]();
   }
 }
+
+std::vector<double> GraphRuntime::ProfileNodes(int repeat) {
+  CHECK_GT(repeat, 0);
+  std::vector<double> time_per_op(op_execs_.size(), 0);
+  threading::ThreadPoolScope scope(thread_pool_);
+  // warmup run
+  this->RunNodes(0, static_cast<uint32_t>(op_execs_.size()));
+  for (int k = 0; k < repeat; ++k) {
+    for (size_t index = 0; index < op_execs_.size(); ++index) {
+      if (!op_execs_[index]) continue;
+      const TVMContext& ctx = data_entry_[entry_id(index, 0)]->ctx;
+      auto tbegin = std::chrono::high_resolution_clock::now();
+      op_execs_[index]();
+      TVMSynchronize(ctx.device_type, ctx.device_id, nullptr);
+      auto tend = std::chrono::high_resolution_clock::now();
+      time_per_op[index] += std::chrono::duration<double, std::micro>(tend - tbegin).count();
+    }
+  }
+  for (double& t : time_per_op) {
+    t /= repeat;
+  }
+  return time_per_op;
+}
+
+namespace {
+/*! \brief Shared state of one inter-op parallel run. */
+struct InterOpState {
+  const std::vector<std::function<void()> >* op_execs;
+  const std::vector<std::vector<uint32_t> >* op_successors;
+  // dependencies left for each node
+  std::unique_ptr<std::atomic<uint32_t>[]> num_deps;
+  // operators ready to run
+  std::vector<uint32_t> ready;
+  std::mutex mutex;
+  // operators not finished yet
+  std::atomic<uint32_t> remaining{0};
+  std::atomic<bool> failed{false};
+
+  bool Pop(uint32_t* nid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ready.empty()) return false;
+    *nid = ready.back();
+    ready.pop_back();
+    return true;
+  }
+};
+
+// Each task keeps taking ready operators until all of them are done.
+int InterOpStream(int task_id, TVMParallelGroupEnv* penv, void* cdata) {
+  InterOpState* state = static_cast<InterOpState*>(cdata);
+  while (state->remaining.load(std::memory_order_acquire) != 0 &&
+         !state->failed.load(std::memory_order_relaxed)) {
+    uint32_t nid;
+    if (!state->Pop(&nid)) {
+      threading::Yield();
+      continue;
+    }
+    try {
+      (*state->op_execs)[nid]();
+    } catch (const std::exception& e) {
+      state->failed.store(true);
+      TVMAPISetLastError(e.what());
+      return -1;
+    }
+    for (uint32_t succ : (*state->op_successors)[nid]) {
+      if (state->num_deps[succ].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->ready.push_back(succ);
+      }
+    }
+    state->remaining.fetch_sub(1, std::memory_order_release);
+  }
+  return 0;
+}
+}  // namespace
+
+void GraphRuntime::RunInterOpParallel() {
+  InterOpState state;
+  state.op_execs = &op_execs_;
+  state.op_successors = &op_successors_;
+  state.num_deps.reset(new std::atomic<uint32_t>[op_num_deps_.size()]);
+  for (size_t i = 0; i < op_num_deps_.size(); ++i) {
+    state.num_deps[i].store(op_num_deps_[i], std::memory_order_relaxed);
+  }
+  state.ready.assign(op_roots_.rbegin(), op_roots_.rend());
+  state.remaining.store(num_op_nodes_);
+  if (num_op_nodes_ == 0) return;
+  // the launch goes to the pool bound by Run, which may be smaller than the machine.
+  int num_streams = std::min(inter_op_parallelism_, threading::CurrentConcurrency());
+  TVM_CCALL(TVMBackendParallelLaunch(InterOpStream, &state, num_streams));
+}
+
+void GraphRuntime::SetInterOpParallelism(int num_streams) {
+  CHECK_GE(num_streams, 1) << "Inter-op parallelism must be positive";
+  inter_op_parallelism_ = num_streams;
+}
 /*!
  * \brief Initialize the graph executor with graph and context.
  * \param graph_json The execution graph.
@@ -67,19 +187,109 @@ void GraphRuntime::Run() {
 void GraphRuntime::Init(const std::string& graph_json,
                         tvm::runtime::Module module,
                         const std::vector<TVMContext>& ctxs) {
+  this->LoadGraph(graph_json, module, ctxs);
+  this->SetupStorage();
+  this->SetupOpExecs();
+}
+
+void GraphRuntime::LoadGraph(const std::string& graph_json,
+                             tvm::runtime::Module module,
+                             const std::vector<TVMContext>& ctxs) {
   std::istringstream is(graph_json);
   dmlc::JSONReader reader(&is);
   this->Load(&reader);
+  graph_json_ = graph_json;
   module_ = module;
   ctxs_ = ctxs;
-  this->SetupStorage();
-  this->SetupOpExecs();
   for (size_t i = 0; i < input_nodes_.size(); i++) {
     const uint32_t nid = input_nodes_[i];
     std::string& name = nodes_[nid].name;
     input_map_[name] = i;
   }
 }
+
+void GraphRuntime::InitShared(const GraphRuntime& graph,
+                              const std::unordered_map<std::string, NDArray>& params) {
+  nodes_ = graph.nodes_;
+  input_nodes_ = graph.input_nodes_;
+  input_map_ = graph.input_map_;
+  node_row_ptr_ = graph.node_row_ptr_;
+  outputs_ = graph.outputs_;
+  attrs_ = graph.attrs_;
+  module_ = graph.module_;
+  graph_json_ = graph.graph_json_;
+  ctxs_ = graph.ctxs_;
+  params_ = params;
+  this->SetupStorage();
+  this->SetupOpExecs();
+}
+/*!
+ * \brief Run the parallel operators of this runtime on a named thread pool.
+ * \param name The name of the pool, empty to use the pool of the calling thread.
+ */
+void GraphRuntime::SetThreadPool(const std::string& name) {
+  thread_pool_ = threading::GetThreadPool(name);
+}
+
+void GraphRuntime::SetMemoryArena(bool enable, int64_t workspace_bytes) {
+  if (!enable && !use_memory_arena_) return;
+  use_memory_arena_ = enable;
+  arena_workspace_bytes_ = enable && workspace_bytes > 0 ? static_cast<size_t>(workspace_bytes) : 0;
+  this->ResetStorage();
+  if (!enable || workspace_bytes >= 0) return;
+  // a warm-up run in node order measures the workspaces requested on this thread.
+  {
+    threading::ThreadPoolScope scope(thread_pool_);
+    WorkspaceArena::Scope arena_scope(workspace_arena_.get());
+    for (size_t i = 0; i < op_execs_.size(); ++i) {
+      if (op_execs_[i]) op_execs_[i]();
+    }
+  }
+  if (workspace_arena_->peak_bytes() > 0) {
+    arena_workspace_bytes_ = workspace_arena_->peak_bytes();
+    this->ResetStorage();
+  }
+}
+
+int64_t GraphRuntime::GetStorageBytes() const {
+  if (memory_arena_.defined()) {
+    int64_t workspace_bytes = workspace_arena_ != nullptr ? arena_workspace_bytes_ : 0;
+    return memory_arena_->shape[0] - workspace_bytes;
+  }
+  int64_t bytes = 0;
+  for (const NDArray& storage : storage_pool_) {
+    bytes += static_cast<int64_t>(GetDataSize(*storage.operator->()));
+  }
+  return bytes;
+}
+
+Module GraphRuntime::Clone() const {
+  auto exec = make_object<GraphRuntime>();
+  exec->use_memory_arena_ = use_memory_arena_;
+  exec->arena_workspace_bytes_ = arena_workspace_bytes_;
+  exec->inter_op_parallelism_ = inter_op_parallelism_;
+  exec->thread_pool_ = thread_pool_;
+  exec->params_ = params_;
+  exec->Init(graph_json_, module_, ctxs_);
+  if (memory_arena_.defined()) {
+    // a single copy, the parameters live in the arena too.
+    exec->memory_arena_.CopyFrom(memory_arena_);
+  } else {
+    for (size_t i = 0; i < storage_pool_.size(); ++i) {
+      exec->storage_pool_[i].CopyFrom(storage_pool_[i]);
+    }
+  }
+  // the shared and mapped parameters stay shared.
+  bool shared = false;
+  for (size_t i = 0; i < data_entry_.size(); ++i) {
+    if (data_entry_[i]->data != storage_pool_[attrs_.storage_id[i]]->data) {
+      exec->data_entry_[i] = data_entry_[i];
+      shared = true;
+    }
+  }
+  if (shared) exec->SetupOpExecs();
+  return Module(exec);
+}
 /*!
  * \brief Get the input index given the name of input.
  * \param name The name of the input.
@@ -93,6 +303,25 @@ int GraphRuntime::GetInputIndex(const std::string& name) {
   LOG(WARNING) << "Warning: cannot find \"" << name << "\" among input";
   return -1;
 }
+
+DLTensor GraphRuntime::GetInputInfo(int index) const {
+  CHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  uint32_t eid = this->entry_id(input_nodes_[index], 0);
+  DLTensor info;
+  info.data = nullptr;
+  info.ctx = ctxs_[0];
+  if (!attrs_.device_index.empty()) {
+    for (const TVMContext& c : ctxs_) {
+      if (static_cast<int>(c.device_type) == attrs_.device_index[eid]) info.ctx = c;
+    }
+  }
+  info.ndim = static_cast<int>(attrs_.shape[eid].size());
+  info.dtype = String2DLDataType(attrs_.dltype[eid]);
+  info.shape = const_cast<int64_t*>(attrs_.shape[eid].data());
+  info.strides = nullptr;
+  info.byte_offset = 0;
+  return info;
+}
 /*!
  * \brief set index-th input to the graph.
  * \param index The input index.
@@ -100,6 +329,8 @@ int GraphRuntime::GetInputIndex(const std::string& name) {
  */
 void GraphRuntime::SetInput(int index, DLTensor* data_in) {
   CHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  const std::string& name = nodes_[input_nodes_[index]].name;
+  CHECK(!params_.count(name)) << "Cannot set " << name << ", it is shared by the model";
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
   data_entry_[eid].CopyFrom(data_in);
 }
@@ -186,7 +417,9 @@ void GraphRuntime::LoadParams(const std::string& param_blob) {
   this->LoadParams(&strm);
 }
 
-void GraphRuntime::LoadParams(dmlc::Stream* strm) {
+namespace {
+// Read the names of the parameters in a parameter blob, the arrays follow.
+std::vector<std::string> ReadParamNames(dmlc::Stream* strm) {
   uint64_t header, reserved;
   CHECK(strm->Read(&header))
       << "Invalid parameters file format";
@@ -203,9 +436,17 @@ void GraphRuntime::LoadParams(dmlc::Stream* strm) {
   size_t size = static_cast<size_t>(sz);
   CHECK(size == names.size())
       << "Invalid parameters file format";
-  for (size_t i = 0; i < size; ++i) {
+  return names;
+}
+}  // namespace
+
+void GraphRuntime::LoadParams(dmlc::Stream* strm) {
+  std::vector<std::string> names = ReadParamNames(strm);
+  for (size_t i = 0; i < names.size(); ++i) {
     int in_idx = GetInputIndex(names[i]);
     CHECK_GE(in_idx, 0) << "Found param for non-existent input: " << names[i];
+    CHECK(!params_.count(names[i]))
+        << "Cannot load " << names[i] << ", it is shared by the model";
     uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
     CHECK_LT(eid, data_entry_.size());
 
@@ -216,6 +457,87 @@ void GraphRuntime::LoadParams(dmlc::Stream* strm) {
   }
 }
 
+namespace {
+/*! \brief A tensor in a mapped parameter file. */
+struct MappedParam {
+  std::string name;
+  DLDataType dtype;
+  char* data;
+  uint64_t nbytes;
+};
+
+// Read the index of a mapped parameter file.
+std::vector<MappedParam> ReadMappedParams(const MappedFile& file) {
+  dmlc::MemoryFixedSizeStream strm(file.data(), file.size());
+  uint64_t header, reserved;
+  CHECK(strm.Read(&header))
+      << "Invalid parameters file format";
+  CHECK(header == kTVMMappedParamsMagic)
+      << "Invalid parameters file format";
+  CHECK(strm.Read(&reserved))
+      << "Invalid parameters file format";
+  std::vector<std::string> names;
+  CHECK(strm.Read(&names))
+      << "Invalid parameters file format";
+  uint64_t sz;
+  CHECK(strm.Read(&sz))
+      << "Invalid parameters file format";
+  size_t size = static_cast<size_t>(sz);
+  CHECK(size == names.size())
+      << "Invalid parameters file format";
+  std::vector<MappedParam> params;
+  for (size_t i = 0; i < size; ++i) {
+    MappedParam param;
+    param.name = std::move(names[i]);
+    int ndim;
+    uint64_t offset;
+    CHECK(strm.Read(&param.dtype) && strm.Read(&ndim))
+        << "Invalid parameters file format";
+    CHECK_GE(ndim, 0) << "Invalid parameters file format";
+    std::vector<int64_t> shape(ndim);
+    CHECK(strm.ReadArray(shape.data(), ndim) && strm.Read(&offset) && strm.Read(&param.nbytes))
+        << "Invalid parameters file format";
+    CHECK_LE(offset + param.nbytes, file.size())
+        << "Invalid parameters file format";
+    param.data = file.data() + offset;
+    params.push_back(std::move(param));
+  }
+  return params;
+}
+
+// Whether the kernels can use the mapped data of a parameter in place.
+bool CanMapInPlace(const MappedParam& param, const DLTensor& entry, size_t alignment) {
+  CHECK(DataType(param.dtype) == DataType(entry.dtype) && GetDataSize(entry) == param.nbytes)
+      << "Type or size mismatch for param " << param.name;
+  return entry.ctx.device_type == kDLCPU &&
+      reinterpret_cast<uintptr_t>(param.data) % alignment == 0;
+}
+}  // namespace
+
+void GraphRuntime::LoadMappedParams(const std::string& file_name) {
+  auto file = std::make_shared<MappedFile>(file_name);
+  bool shared = false;
+  for (const MappedParam& param : ReadMappedParams(*file)) {
+    int in_idx = GetInputIndex(param.name);
+    CHECK_GE(in_idx, 0) << "Found param for non-existent input: " << param.name;
+    CHECK(!params_.count(param.name))
+        << "Cannot load " << param.name << ", it is shared by the model";
+    uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
+    CHECK_LT(eid, data_entry_.size());
+    const DLTensor* entry = data_entry_[eid].operator->();
+    // The kernels assume the arguments are aligned.
+    if (CanMapInPlace(param, *entry, data_alignment_[eid])) {
+      data_entry_[eid] = CreateMappedArray(
+          file, param.data, std::vector<int64_t>(entry->shape, entry->shape + entry->ndim),
+          param.dtype);
+      shared = true;
+    } else {
+      data_entry_[eid].CopyFromBytes(param.data, param.nbytes);
+    }
+  }
+  if (shared) this->SetupOpExecs();
+}
+
 void GraphRuntime::ShareParams(const GraphRuntime& other, dmlc::Stream* strm) {
     uint64_t header, reserved;
     CHECK(strm->Read(&header))
@@ -251,6 +573,14 @@ void GraphRuntime::SetupStorage() {
     vtype.push_back(tvm::runtime::String2DLDataType(s_type));
   }
 
+  // The entries of the parameters shared by the model, they need no storage.
+  std::vector<NDArray> shared_entry(num_node_entries());
+  for (const auto& kv : params_) {
+    int in_idx = GetInputIndex(kv.first);
+    CHECK_GE(in_idx, 0) << "Found param for non-existent input: " << kv.first;
+    shared_entry[this->entry_id(input_nodes_[in_idx], 0)] = kv.second;
+  }
+
   // Size and device type of each storage pool entry.
   std::vector<PoolEntry> pool_entry;
   // Find the maximum space size.
@@ -270,6 +600,12 @@ void GraphRuntime::SetupStorage() {
     size_t bits = t.bits * t.lanes;
     CHECK(bits % 8U ==  0U || bits ==1U);
     size_t bytes = ((bits + 7U) / 8U) * size;
+    if (shared_entry[i].defined()) {
+      CHECK(DataType(shared_entry[i]->dtype) == DataType(t) &&
+            GetDataSize(*shared_entry[i].operator->()) == bytes)
+          << "Type or size mismatch for the shared param of entry " << i;
+      bytes = 0;
+    }
 
     uint32_t sid = static_cast<uint32_t>(storage_id);
     if (sid >= pool_entry.size()) {
@@ -283,8 +619,26 @@ void GraphRuntime::SetupStorage() {
     pool_entry[sid].device_type = device_type;
   }
 
+  // Byte offsets of the storage ids when the graph was built with an offset plan.
+  std::vector<int64_t> sid_offset;
+  if (!attrs_.storage_offset.empty()) {
+    CHECK_EQ(attrs_.storage_offset.size(), attrs_.storage_id.size());
+    sid_offset.resize(pool_entry.size(), -1);
+    for (size_t i = 0; i < attrs_.storage_offset.size(); ++i) {
+      sid_offset[attrs_.storage_id[i]] = attrs_.storage_offset[i];
+    }
+  }
+
+  storage_pool_.clear();
+  if (use_memory_arena_ || !sid_offset.empty()) {
+    this->SetupMemoryArena(pool_entry, sid_offset);
+  } else {
+    memory_arena_ = NDArray();
+    workspace_arena_.reset();
+  }
   // Allocate the space.
-  for (const auto& pit : pool_entry) {
+  for (size_t i = storage_pool_.size(); i < pool_entry.size(); ++i) {
+    const PoolEntry& pit = pool_entry[i];
     std::vector<int64_t> shape;
     // This for loop is very fast since there are usually only a couple of
     // devices available on the same hardware.
@@ -306,15 +660,143 @@ void GraphRuntime::SetupStorage() {
   for (size_t i = 0; i < data_entry_.size(); ++i) {
     int storage_id = attrs_.storage_id[i];
     CHECK_LT(static_cast<size_t>(storage_id), storage_pool_.size());
-    data_entry_[i] =
-        storage_pool_[storage_id].CreateView(attrs_.shape[i], vtype[i]);
+    if (shared_entry[i].defined()) {
+      data_entry_[i] = shared_entry[i];
+    } else {
+      data_entry_[i] =
+          storage_pool_[storage_id].CreateView(attrs_.shape[i], vtype[i]);
+    }
     const DLTensor* tmp = data_entry_[i].operator->();
     data_alignment_[i] = details::GetDataAlignment(*tmp);
   }
 }
 
+namespace {
+/*! \brief Keeps the arena alive for a slice of it. */
+struct ArenaSlice {
+  NDArray arena;
+  int64_t shape;
+  DLManagedTensor tensor;
+};
+
+void DeleteArenaSlice(DLManagedTensor* tensor) {
+  delete static_cast<ArenaSlice*>(tensor->manager_ctx);
+}
+
+// A 1-D float32 array of num_elems at offset bytes into arena.
+NDArray CreateArenaSlice(const NDArray& arena, size_t offset, int64_t num_elems) {
+  ArenaSlice* slice = new ArenaSlice();
+  slice->arena = arena;
+  slice->shape = num_elems;
+  DLTensor& t = slice->tensor.dl_tensor;
+  t.data = static_cast<char*>(arena->data) + offset;
+  t.ctx = arena->ctx;
+  t.ndim = 1;
+  t.dtype = DLDataType{kDLFloat, 32, 1};
+  t.shape = &slice->shape;
+  t.strides = nullptr;
+  t.byte_offset = 0;
+  slice->tensor.manager_ctx = slice;
+  slice->tensor.deleter = DeleteArenaSlice;
+  return NDArray::FromDLPack(&slice->tensor);
+}
+}  // namespace
+
+void GraphRuntime::SetupMemoryArena(const std::vector<PoolEntry>& pool_entry,
+                                    const std::vector<int64_t>& sid_offset) {
+  TVMContext ctx = ctxs_[0];
+  for (const auto& pit : pool_entry) {
+    CHECK(pit.device_type == -1 || pit.device_type == static_cast<int>(ctx.device_type))
+        << "The memory arena only supports graphs placed on a single device";
+  }
+  CHECK(ctx.device_type == kDLCPU || ctx.device_type == kDLGPU ||
+        ctx.device_type == kDLCPUPinned || ctx.device_type == kDLROCM)
+      << "The memory arena needs flat device pointers, not supported on "
+      << DeviceName(ctx.device_type);
+  // Each slice is aligned for any dtype.
+  std::vector<size_t> sizes;
+  for (const auto& pit : pool_entry) {
+    size_t bytes = (pit.size + 3) / 4 * 4;
+    sizes.push_back((bytes + kAllocAlignment - 1) / kAllocAlignment * kAllocAlignment);
+  }
+  // Use the planned offsets if any. The plan leaves holes where the storage
+  // ids now have no bytes, e.g. parameters shared with other executors, so
+  // drop the address ranges no slice covers: the slices overlapping in the
+  // plan still overlap the same way.
+  std::vector<std::pair<size_t, size_t> > ranges;
+  for (size_t i = 0; i < sid_offset.size(); ++i) {
+    if (sid_offset[i] < 0 || sizes[i] == 0) continue;
+    size_t offset = static_cast<size_t>(sid_offset[i]);
+    CHECK_EQ(offset % kAllocAlignment, 0U) << "Misaligned storage offset " << offset;
+    ranges.emplace_back(offset, offset + sizes[i]);
+  }
+  std::sort(ranges.begin(), ranges.end());
+  // The covered ranges, with the bytes dropped below each of them.
+  std::vector<std::pair<size_t, size_t> > covered;
+  std::vector<size_t> dropped;
+  size_t total = 0;
+  for (const auto& r : ranges) {
+    if (!covered.empty() && r.first <= covered.back().second) {
+      covered.back().second = std::max(covered.back().second, r.second);
+    } else {
+      size_t end = covered.empty() ? 0 : covered.back().second;
+      dropped.push_back((dropped.empty() ? 0 : dropped.back()) + r.first - end);
+      covered.push_back(r);
+    }
+  }
+  if (!covered.empty()) total = covered.back().second - dropped.back();
+  // The other pooled entries are laid out one after another.
+  std::vector<size_t> offsets;
+  for (size_t i = 0; i < pool_entry.size(); ++i) {
+    if (i < sid_offset.size() && sid_offset[i] >= 0 && sizes[i] != 0) {
+      size_t offset = static_cast<size_t>(sid_offset[i]);
+      size_t k = std::upper_bound(covered.begin(), covered.end(),
+                                  std::make_pair(offset, std::numeric_limits<size_t>::max())) -
+                 covered.begin() - 1;
+      offsets.push_back(offset - dropped[k]);
+    } else {
+      offsets.push_back(total);
+      total += sizes[i];
+    }
+  }
+  size_t workspace_offset = total;
+  // The workspace region is only reserved when the arena is requested.
+  size_t workspace_bytes = use_memory_arena_ ? arena_workspace_bytes_ : 0;
+  total += workspace_bytes;
+  memory_arena_ = NDArray::Empty({static_cast<int64_t>(std::max(total, size_t(1)))},
+                                 DLDataType{kDLUInt, 8, 1}, ctx);
+  for (size_t i = 0; i < pool_entry.size(); ++i) {
+    storage_pool_.push_back(CreateArenaSlice(
+        memory_arena_, offsets[i], static_cast<int64_t>(pool_entry[i].size + 3) / 4));
+  }
+  if (use_memory_arena_) {
+    workspace_arena_.reset(new WorkspaceArena(
+        ctx, static_cast<char*>(memory_arena_->data) + workspace_offset, workspace_bytes));
+  } else {
+    workspace_arena_.reset();
+  }
+}
+
+void GraphRuntime::ResetStorage() {
+  std::vector<NDArray> old_pool = std::move(storage_pool_);
+  std::vector<NDArray> old_entry = std::move(data_entry_);
+  this->SetupStorage();
+  for (size_t i = 0; i < old_pool.size(); ++i) {
+    storage_pool_[i].CopyFrom(old_pool[i]);
+  }
+  // keep the entries shared from another runtime by ShareParams.
+  for (size_t i = 0; i < old_entry.size(); ++i) {
+    int storage_id = attrs_.storage_id[i];
+    if (old_entry[i]->data != old_pool[storage_id]->data) {
+      data_entry_[i] = old_entry[i];
+    }
+  }
+  this->SetupOpExecs();
+}
+
 void GraphRuntime::SetupOpExecs() {
   op_execs_.resize(this->GetNumOfNodes());
+  input_dltensors_.clear();
   input_dltensors_.resize(num_node_entries());
   std::unordered_set<uint32_t> input_node_eids;
   for (size_t i = 0; i < input_nodes_.size(); i++) {
@@ -350,6 +832,43 @@ void GraphRuntime::SetupOpExecs() {
       }
     }
   }
+  this->SetupOpDeps();
+}
+
+void GraphRuntime::SetupOpDeps() {
+  uint32_t num_nodes = this->GetNumOfNodes();
+  op_num_deps_.assign(num_nodes, 0);
+  op_successors_.assign(num_nodes, {});
+  op_roots_.clear();
+  num_op_nodes_ = 0;
+  // The last operator writing each storage id, and the readers since then.
+  std::unordered_map<int, uint32_t> last_writer;
+  std::unordered_map<int, std::vector<uint32_t> > readers;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    if (!op_execs_[nid]) continue;
+    ++num_op_nodes_;
+    std::unordered_set<uint32_t> deps;
+    for (const auto& e : nodes_[nid].inputs) {
+      int sid = attrs_.storage_id[this->entry_id(e)];
+      auto it = last_writer.find(sid);
+      if (it != last_writer.end()) deps.insert(it->second);
+      readers[sid].push_back(nid);
+    }
+    for (uint32_t index = 0; index < nodes_[nid].param.num_outputs; ++index) {
+      int sid = attrs_.storage_id[this->entry_id(nid, index)];
+      auto it = last_writer.find(sid);
+      if (it != last_writer.end()) deps.insert(it->second);
+      for (uint32_t reader : readers[sid]) deps.insert(reader);
+      readers[sid].clear();
+      last_writer[sid] = nid;
+    }
+    deps.erase(nid);
+    for (uint32_t dep : deps) {
+      op_successors_[dep].push_back(nid);
+    }
+    op_num_deps_[nid] = static_cast<uint32_t>(deps.size());
+    if (deps.empty()) op_roots_.push_back(nid);
+  }
 }
 
 std::pair<std::function<void()>, std::shared_ptr<GraphRuntime::OpArgs> > GraphRuntime::CreateTVMOp(
@@ -453,10 +972,59 @@ PackedFunc GraphRuntime::GetFunction(
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
         this->Run();
       });
+  } else if (name == "run_async") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        PackedFunc callback;
+        if (args.num_args > 0) callback = args[0];
+        // runs of this runtime stay in order, the callback gets the error message if any.
+        threading::RunAsync(this, [sptr_to_self, this, callback]() {
+            std::string error;
+            try {
+              this->Run();
+            } catch (const std::exception& e) {
+              error = e.what();
+            } catch (...) {
+              error = "run_async failed with an unknown exception";
+            }
+            if (callback == nullptr) return;
+            try {
+              callback(error);
+            } catch (const std::exception& e) {
+              LOG(WARNING) << "run_async callback failed: " << e.what();
+            } catch (...) {
+              LOG(WARNING) << "run_async callback failed with an unknown exception";
+            }
+          });
+      });
+  } else if (name == "set_memory_arena") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        int64_t workspace_bytes = args.num_args > 1 ? static_cast<int64_t>(args[1]) : -1;
+        this->SetMemoryArena(args[0], workspace_bytes);
+      });
+  } else if (name == "get_storage_bytes") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = this->GetStorageBytes();
+      });
+  } else if (name == "clone") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = this->Clone();
+      });
+  } else if (name == "set_inter_op_parallelism") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->SetInterOpParallelism(args[0]);
+      });
+  } else if (name == "set_thread_pool") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->SetThreadPool(args[0]);
+      });
   } else if (name == "load_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
         this->LoadParams(args[0].operator std::string());
       });
+  } else if (name == "load_mapped_params") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->LoadMappedParams(args[0].operator std::string());
+      });
   } else if (name == "share_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
         const auto& module = args[0].operator Module();
@@ -470,6 +1038,84 @@ PackedFunc GraphRuntime::GetFunction(
   }
 }
 
+void GraphModel::Init(const std::string& graph_json,
+                      tvm::runtime::Module module,
+                      const std::vector<TVMContext>& ctxs) {
+  graph_ = make_object<GraphRuntime>();
+  graph_->LoadGraph(graph_json, module, ctxs);
+}
+
+void GraphModel::LoadParams(const std::string& param_blob) {
+  dmlc::MemoryStringStream strm(const_cast<std::string*>(&param_blob));
+  std::vector<std::string> names = ReadParamNames(&strm);
+  std::unordered_map<std::string, NDArray> params;
+  for (size_t i = 0; i < names.size(); ++i) {
+    int in_idx = graph_->GetInputIndex(names[i]);
+    CHECK_GE(in_idx, 0) << "Found param for non-existent input: " << names[i];
+    NDArray temp;
+    temp.Load(&strm);
+    DLTensor info = graph_->GetInputInfo(in_idx);
+    std::vector<int64_t> shape(info.shape, info.shape + info.ndim);
+    CHECK(DataType(temp->dtype) == DataType(info.dtype) &&
+          GetDataSize(*temp.operator->()) == GetDataSize(info))
+        << "Type or size mismatch for param " << names[i];
+    if (info.ctx.device_type == kDLCPU) {
+      // NDArray.load always loads the array into CPU, use it as is.
+      params[names[i]] = temp.CreateView(shape, info.dtype);
+    } else {
+      NDArray param = NDArray::Empty(shape, info.dtype, info.ctx);
+      param.CopyFrom(temp);
+      params[names[i]] = param;
+    }
+  }
+  params_ = std::move(params);
+}
+
+void GraphModel::LoadMappedParams(const std::string& file_name) {
+  auto file = std::make_shared<MappedFile>(file_name);
+  std::unordered_map<std::string, NDArray> params;
+  for (const MappedParam& param : ReadMappedParams(*file)) {
+    int in_idx = graph_->GetInputIndex(param.name);
+    CHECK_GE(in_idx, 0) << "Found param for non-existent input: " << param.name;
+    DLTensor info = graph_->GetInputInfo(in_idx);
+    std::vector<int64_t> shape(info.shape, info.shape + info.ndim);
+    if (CanMapInPlace(param, info, details::GetDataAlignment(info))) {
+      params[param.name] = CreateMappedArray(file, param.data, shape, param.dtype);
+    } else {
+      NDArray entry = NDArray::Empty(shape, info.dtype, info.ctx);
+      entry.CopyFromBytes(param.data, param.nbytes);
+      params[param.name] = entry;
+    }
+  }
+  params_ = std::move(params);
+}
+
+Module GraphModel::CreateExecutor() const {
+  auto exec = make_object<GraphRuntime>();
+  exec->InitShared(*graph_, params_);
+  return Module(exec);
+}
+
+PackedFunc GraphModel::GetFunction(
+    const std::string& name,
+    const ObjectPtr<Object>& sptr_to_self) {
+  if (name == "load_params") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->LoadParams(args[0].operator std::string());
+      });
+  } else if (name == "load_mapped_params") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        this->LoadMappedParams(args[0].operator std::string());
+      });
+  } else if (name == "create_executor") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+        *rv = this->CreateExecutor();
+      });
+  } else {
+    return PackedFunc();
+  }
+}
+
 Module GraphRuntimeCreate(const std::string& sym_json,
                           const tvm::runtime::Module& m,
                           const std::vector<TVMContext>& ctxs) {
@@ -506,5 +1152,16 @@ TVM_REGISTER_GLOBAL("tvm.graph_runtime.create")
     const auto& contexts = GetAllContext(args);
     *rv = GraphRuntimeCreate(args[0], args[1], contexts);
   });
+
+TVM_REGISTER_GLOBAL("tvm.graph_runtime.create_model")
+  .set_body([](TVMArgs args, TVMRetValue* rv) {
+    CHECK_GE(args.num_args, 4)
+        << "The expected number of arguments for graph_runtime.create_model is "
+           "at least 4, but it has "
+        << args.num_args;
+    auto model = make_object<GraphModel>();
+    model->Init(args[0], args[1], GetAllContext(args));
+    *rv = Module(model);
+  });
 }  // namespace runtime
 }  // namespace tvm
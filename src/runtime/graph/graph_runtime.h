@@ -30,6 +30,7 @@
 #include <dmlc/json.h>
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/threading_backend.h>
 
 #include <memory>
 #include <unordered_map>
@@ -37,6 +38,8 @@
 #include <vector>
 #include <string>
 
+#include "../workspace_pool.h"
+
 namespace tvm {
 namespace runtime {
 
@@ -50,6 +53,8 @@ namespace runtime {
 
 /*! \brief Magic number for NDArray list file  */
 constexpr uint64_t kTVMNDArrayListMagic = 0xF7E58D4F05049CB7;
+/*! \brief Magic number for the mapped parameter file */
+constexpr uint64_t kTVMMappedParamsMagic = 0xF7E58D4F05049CB8;
 
 /*! \brief operator attributes about tvm op */
 struct TVMOpParam {
@@ -90,6 +95,23 @@ class TVM_DLL GraphRuntime : public ModuleNode {
     return "GraphRuntime";
   }
   void Run();
+  /*!
+   * \brief Run the operators of the nodes in [begin, end), in node order.
+   *
+   *  Running consecutive ranges that cover all the nodes is the same as
+   *  Run in node order, the ranges may be run by different threads one
+   *  after the other. The thread pool of the calling thread is used.
+   * \param begin The first node.
+   * \param end The node after the last one.
+   */
+  void RunNodes(uint32_t begin, uint32_t end);
+  /*!
+   * \brief Measure the operator of each node, running them in node order.
+   * \param repeat The number of runs averaged, after a warmup run.
+   * \return The mean time in microseconds of each node, 0 for the nodes
+   *  without operator.
+   */
+  std::vector<double> ProfileNodes(int repeat);
 
   /*!
    * \brief Initialize the graph executor with graph and context.
@@ -104,6 +126,33 @@ class TVM_DLL GraphRuntime : public ModuleNode {
             tvm::runtime::Module module,
             const std::vector<TVMContext>& ctxs);
 
+  /*!
+   * \brief Parse the graph without allocating its storage.
+   * \param graph_json The execution graph.
+   * \param module The module containing the compiled functions.
+   * \param ctxs The context of the host and devices.
+   */
+  void LoadGraph(const std::string& graph_json,
+                 tvm::runtime::Module module,
+                 const std::vector<TVMContext>& ctxs);
+
+  /*!
+   * \brief Initialize from a parsed graph, using the given parameters in place.
+   *
+   *  No storage is allocated for the parameters, and they cannot be set.
+   * \param graph A graph runtime on which LoadGraph was called.
+   * \param params The parameters shared with other executors, by name.
+   */
+  void InitShared(const GraphRuntime& graph,
+                  const std::unordered_map<std::string, NDArray>& params);
+
+  /*!
+   * \brief Get the shape, type and device of an input without allocating it.
+   * \param index The input index.
+   * \return The tensor without data, its shape refers to the graph attributes.
+   */
+  DLTensor GetInputInfo(int index) const;
+
   /*!
    * \brief Get the input index given the name of input.
    * \param name The name of the input.
@@ -159,6 +208,15 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    * \param param_blob A binary blob of parameter.
    */
   void LoadParams(const std::string& param_blob);
+  /*!
+   * \brief Load parameters from a file saved by save_mapped_param_dict.
+   *
+   *  The file is mapped into memory and the CPU parameters point into its
+   *  pages instead of being copied, so processes loading the same file share
+   *  them. Parameters on other devices are copied from the mapping.
+   * \param file_name The name of the parameter file.
+   */
+  void LoadMappedParams(const std::string& file_name);
 
   /*!
    * \brief Share parameters from pre-existing GraphRuntime instance.
@@ -168,6 +226,56 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    */
   void ShareParams(const GraphRuntime& other, dmlc::Stream* strm);
 
+  /*!
+   * \brief Set the number of operators that may run at the same time.
+   *
+   *  With more than one stream, Run dispatches every operator whose
+   *  dependencies are done onto the thread pool instead of following the
+   *  node order. The intra-op parallel loops of those operators are nested
+   *  launches and use the remaining idle workers.
+   *
+   * \param num_streams The number of concurrent operators, 1 runs in node order.
+   */
+  void SetInterOpParallelism(int num_streams);
+
+  /*!
+   * \brief Place all the storage and workspaces of the graph in one arena.
+   *
+   *  The storage entries become slices of a single allocation, followed by
+   *  a region serving the workspaces the operators request on the thread
+   *  calling Run. The storage is laid out by this call only: storage
+   *  contents are kept, but arrays returned by get_input or get_output
+   *  before it and inputs set with set_input_zero_copy must be set again.
+   *  Workspaces requested by the parallel tasks of an operator on the
+   *  worker threads, or by all the operators when the inter-op parallelism
+   *  is above 1, still come from the workspace pool.
+   *
+   * \param enable Whether to use the arena.
+   * \param workspace_bytes The size of the workspace region. When negative,
+   *  the model runs once with the current inputs to measure it.
+   */
+  void SetMemoryArena(bool enable, int64_t workspace_bytes = -1);
+  /*!
+   * \brief Get the bytes allocated for the storage of the graph entries.
+   *
+   * \return The bytes, without the workspace region of the arena.
+   */
+  int64_t GetStorageBytes() const;
+
+  /*!
+   * \brief Create a runtime with the same graph, module and contexts and
+   *  a copy of the storage, including the parameters.
+   * \return The new runtime module.
+   */
+  Module Clone() const;
+
+  /*!
+   * \brief Run the parallel operators of this runtime on a named thread pool.
+   * \param name The name of the pool created by threading::CreateThreadPool,
+   *  empty to use the thread pool of the calling thread.
+   */
+  void SetThreadPool(const std::string& name);
+
   /*!
    * \brief Get total number of nodes.
    * \return Total number of nodes.
@@ -180,6 +288,10 @@ class TVM_DLL GraphRuntime : public ModuleNode {
     return nodes_[nid].name;
   }
 
+  std::string GetNodeOpType(uint32_t nid) const {
+    return nodes_[nid].op_type;
+  }
+
 
  protected:
   // Memory pool entry.
@@ -273,6 +385,7 @@ class TVM_DLL GraphRuntime : public ModuleNode {
     size_t storage_num_not_alloctaed{0};
     std::vector<int> storage_id;
     std::vector<int> device_index;
+    std::vector<int64_t> storage_offset;
     std::vector<std::string> dltype;
     std::vector<std::vector<int64_t> > shape;
     // The graph attribute fields.
@@ -316,6 +429,14 @@ class TVM_DLL GraphRuntime : public ModuleNode {
           CHECK(reader->NextArrayItem());
           reader->Read(&device_index);
           CHECK(!reader->NextArrayItem());
+        } else if (key == "storage_offset") {
+          reader->BeginArray();
+          CHECK(reader->NextArrayItem());
+          reader->Read(&type);
+          CHECK_EQ(type, "list_int");
+          CHECK(reader->NextArrayItem());
+          reader->Read(&storage_offset);
+          CHECK(!reader->NextArrayItem());
         } else {
           reader->BeginArray();
           CHECK(reader->NextArrayItem());
@@ -368,8 +489,27 @@ class TVM_DLL GraphRuntime : public ModuleNode {
   }
   /*! \brief Setup the temporal storage */
   void SetupStorage();
+  /*!
+   * \brief Allocate the storage entries as slices of memory_arena_.
+   * \param pool_entry The size and device of each storage id.
+   * \param sid_offset The planned byte offset of each storage id, empty if none.
+   */
+  void SetupMemoryArena(const std::vector<PoolEntry>& pool_entry,
+                        const std::vector<int64_t>& sid_offset);
+  /*! \brief Allocate the storage again, keeping its contents. */
+  void ResetStorage();
   /*! \brief Setup the executors. */
   void SetupOpExecs();
+  /*!
+   * \brief Build the dependencies between operators for inter-op parallelism.
+   *
+   *  Besides data dependencies, an operator writing a storage id waits for
+   *  the previous readers and writer of the same storage, so the memory plan,
+   *  made for node order, stays valid when independent operators overlap.
+   */
+  void SetupOpDeps();
+  /*! \brief Run the operators concurrently following op_deps_. */
+  void RunInterOpParallel();
   /*!
    * \brief Create an execution function given input.
    * \param attrs The node attributes.
@@ -408,6 +548,8 @@ class TVM_DLL GraphRuntime : public ModuleNode {
   GraphAttr attrs_;
   /*! \brief The code module that contains both host and device code. */
   tvm::runtime::Module module_;
+  /*! \brief The graph json. */
+  std::string graph_json_;
   /*! \brief Execution context of all devices including the host. */
   std::vector<TVMContext> ctxs_;
   /*! \brief Common storage pool for all devices. */
@@ -418,6 +560,74 @@ class TVM_DLL GraphRuntime : public ModuleNode {
   std::vector<size_t> data_alignment_;
   /*! \brief Operator on each node. */
   std::vector<std::function<void()> > op_execs_;
+  /*! \brief Number of operators that may run concurrently. */
+  int inter_op_parallelism_{1};
+  /*! \brief Number of operators each operator node waits for. */
+  std::vector<uint32_t> op_num_deps_;
+  /*! \brief Operators waiting for each operator node. */
+  std::vector<std::vector<uint32_t> > op_successors_;
+  /*! \brief Operator nodes without dependencies. */
+  std::vector<uint32_t> op_roots_;
+  /*! \brief Number of operator nodes. */
+  uint32_t num_op_nodes_{0};
+  /*! \brief The thread pool bound to this runtime, nullptr for the default one. */
+  std::shared_ptr<ThreadPool> thread_pool_;
+  /*! \brief Whether the storage is placed in memory_arena_. */
+  bool use_memory_arena_{false};
+  /*! \brief The single allocation holding the storage and the workspaces. */
+  NDArray memory_arena_;
+  /*! \brief The size of the workspace region at the end of memory_arena_. */
+  size_t arena_workspace_bytes_{0};
+  /*! \brief The workspace region of memory_arena_. */
+  std::unique_ptr<WorkspaceArena> workspace_arena_;
+  /*! \brief The read-only parameters shared by the model, by name. */
+  std::unordered_map<std::string, NDArray> params_;
+};
+
+/*!
+ * \brief A graph and its parameters, shared by the executors created from it.
+ *
+ *  The graph is parsed and the parameters are loaded once. Each executor
+ *  refers to the same parameter arrays and only allocates the storage of
+ *  the other entries, so creating one is cheap. Loading parameters again
+ *  only affects the executors created afterwards.
+ */
+class TVM_DLL GraphModel : public ModuleNode {
+ public:
+  PackedFunc GetFunction(const std::string& name,
+                         const ObjectPtr<Object>& sptr_to_self) final;
+
+  const char* type_key() const final {
+    return "GraphModel";
+  }
+  /*!
+   * \brief Initialize the model with graph and context.
+   * \param graph_json The execution graph.
+   * \param module The module containing the compiled functions.
+   * \param ctxs The context of the host and devices.
+   */
+  void Init(const std::string& graph_json,
+            tvm::runtime::Module module,
+            const std::vector<TVMContext>& ctxs);
+  /*!
+   * \brief Load the parameters from a parameter blob.
+   * \param param_blob A binary blob of parameter.
+   */
+  void LoadParams(const std::string& param_blob);
+  /*!
+   * \brief Load the parameters from a file saved by save_mapped_param_dict,
+   *  the CPU parameters point into the mapped file.
+   * \param file_name The name of the parameter file.
+   */
+  void LoadMappedParams(const std::string& file_name);
+  /*! \return A new executor using the parameters of the model. */
+  Module CreateExecutor() const;
+
+ private:
+  /*! \brief The parsed graph, without storage. */
+  ObjectPtr<GraphRuntime> graph_;
+  /*! \brief The loaded parameters, by name. */
+  std::unordered_map<std::string, NDArray> params_;
 };
 
 std::vector<TVMContext> GetAllContext(const TVMArgs& args);
@@ -31,13 +31,23 @@
 #if TVM_THREADPOOL_USE_OPENMP
 #include <omp.h>
 #endif
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <chrono>
+#include <climits>
 #include <thread>
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <atomic>
 #include <algorithm>
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include <cstring>
 #include <memory>
 #include <sstream>
@@ -58,11 +68,270 @@ uint32_t GetSpinCount() {
   return atoi(val);
 }
 
+// number of tasks each worker receives when work stealing is enabled
+constexpr int kDefaultStealGrain = 4;
+
+int GetStealGrain() {
+  const char* val = getenv("TVM_THREAD_POOL_STEAL_GRAIN");
+  if (!val) {
+    return kDefaultStealGrain;
+  }
+  return std::max(atoi(val), 1);
+}
+
+/*
+ * TVM_THREAD_POOL_WORK_STEALING=1 splits the loops launched with num_task=0
+ * into TVM_THREAD_POOL_STEAL_GRAIN tasks per worker. Such tasks do not run
+ * concurrently, so kernels using the parallel barrier, e.g. the ones built
+ * with parallel_barrier_when_finish, are not supported unless the grain is 1.
+ */
+bool UseWorkStealing() {
+  const char* val = getenv("TVM_THREAD_POOL_WORK_STEALING");
+  return val != nullptr && atoi(val) != 0;
+}
+
+// upper bound of the adaptive spin, in microseconds
+constexpr int64_t kDefaultMaxSpinUs = 200;
+
+int64_t GetMaxSpinNanos() {
+  const char* val = getenv("TVM_THREAD_POOL_MAX_SPIN_US");
+  if (!val) {
+    return kDefaultMaxSpinUs * 1000;
+  }
+  return std::max(atoll(val), 0LL) * 1000;
+}
+
+// number of threads running the asynchronous calls
+constexpr int kDefaultAsyncThreads = 4;
+
+int GetNumAsyncThreads() {
+  const char* val = getenv("TVM_NUM_ASYNC_THREADS");
+  if (!val) {
+    return kDefaultAsyncThreads;
+  }
+  return std::max(atoi(val), 1);
+}
+
+bool UseAdaptiveWait() {
+  const char* val = getenv("TVM_THREAD_POOL_WAIT_POLICY");
+  return val != nullptr && std::string(val) == "adaptive";
+}
+
+inline int64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// hint the core that we are in a spin loop
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
 }  // namespace
 
+/*!
+ * \brief How an idle worker waits for its next task before it parks.
+ *
+ *  The default policy spins TVM_THREAD_POOL_SPIN_COUNT yields. The adaptive
+ *  policy (TVM_THREAD_POOL_WAIT_POLICY=adaptive) keeps a moving average of
+ *  the idle gap between the launches of the pool and spins for at most twice
+ *  that gap, bounded by TVM_THREAD_POOL_MAX_SPIN_US. Back to back launches
+ *  inside one inference are caught spinning, while the longer gap between
+ *  requests is spent parked instead of burning the core.
+ */
+class WaitPolicy {
+ public:
+  WaitPolicy()
+      : adaptive_(UseAdaptiveWait()),
+        spin_count_(GetSpinCount()),
+        max_spin_ns_(GetMaxSpinNanos()) {}
+
+  // Called by the launching thread before the tasks are pushed.
+  void RecordLaunchBegin() {
+    if (!adaptive_) return;
+    int64_t last_end = last_end_ns_.load(std::memory_order_relaxed);
+    if (last_end == 0) return;
+    int64_t gap = std::min(NowNanos() - last_end, kMaxGapNs);
+    int64_t avg = avg_gap_ns_.load(std::memory_order_relaxed);
+    // exponential moving average with weight 1/8
+    avg_gap_ns_.store(avg + (gap - avg) / 8, std::memory_order_relaxed);
+  }
+
+  // Called by the launching thread once all tasks are finished.
+  void RecordLaunchEnd() {
+    if (!adaptive_) return;
+    last_end_ns_.store(NowNanos(), std::memory_order_relaxed);
+  }
+
+  /*!
+   * \brief Busy wait until ready() or the budget runs out.
+   * \param ready Whether the wait can stop.
+   */
+  template<typename F>
+  void Spin(F ready) const {
+    if (!adaptive_) {
+      for (uint32_t i = 0; i < spin_count_ && !ready(); ++i) {
+        tvm::runtime::threading::Yield();
+      }
+      return;
+    }
+    int64_t budget = std::min(2 * avg_gap_ns_.load(std::memory_order_relaxed), max_spin_ns_);
+    if (budget <= 0) return;
+    int64_t begin = NowNanos();
+    int64_t elapsed = 0;
+    while (!ready() && elapsed < budget) {
+      // pause while the next launch is imminent, then let others use the core
+      for (int i = 0; i < kCheckInterval && !ready(); ++i) {
+        if (elapsed < kPauseNs) {
+          CpuRelax();
+        } else {
+          tvm::runtime::threading::Yield();
+        }
+      }
+      elapsed = NowNanos() - begin;
+    }
+  }
+
+  /*! \return The average idle gap between launches in nanoseconds. */
+  int64_t avg_gap_ns() const {
+    return avg_gap_ns_.load(std::memory_order_relaxed);
+  }
+
+  /*! \return Whether the adaptive policy is used. */
+  bool adaptive() const {
+    return adaptive_;
+  }
+
+ private:
+  // the clock is read once every kCheckInterval spins
+  static constexpr int kCheckInterval = 64;
+  // spin with pause instructions for the first kPauseNs, then yield
+  static constexpr int64_t kPauseNs = 20000;
+  // gaps are clamped so that one long pause does not dominate the average
+  static constexpr int64_t kMaxGapNs = 1000000000;
+
+  bool adaptive_;
+  uint32_t spin_count_;
+  int64_t max_spin_ns_;
+  std::atomic<int64_t> last_end_ns_{0};
+  std::atomic<int64_t> avg_gap_ns_{0};
+};
+
+constexpr int64_t WaitPolicy::kMaxGapNs;
+
+/*! \brief Time counters of one worker, added to by the worker, read and reset by others. */
+struct WorkerStats {
+  std::atomic<uint64_t> spin_ns{0};
+  std::atomic<uint64_t> park_ns{0};
+  std::atomic<uint64_t> work_ns{0};
+  std::atomic<uint64_t> num_tasks{0};
+  std::atomic<uint64_t> num_parks{0};
+  // keep the counters of different workers on different cache lines
+  char pad[kL1CacheBytes];
+
+  void Add(std::atomic<uint64_t>* counter, int64_t value) {
+    counter->fetch_add(static_cast<uint64_t>(value), std::memory_order_relaxed);
+  }
+  void Reset() {
+    spin_ns.store(0, std::memory_order_relaxed);
+    park_ns.store(0, std::memory_order_relaxed);
+    work_ns.store(0, std::memory_order_relaxed);
+    num_tasks.store(0, std::memory_order_relaxed);
+    num_parks.store(0, std::memory_order_relaxed);
+  }
+};
+
 // stride in the page, fit to cache line.
 constexpr int kSyncStride = 64 / sizeof(std::atomic<int>);
 
+/*!
+ * \brief The slice of task ids owned by one worker under work stealing.
+ *
+ *  The generation of the launch and the [begin, end) range of the slice are
+ *  packed into a single word. The owner claims tasks from the front and
+ *  thieves claim tasks from the back, both through CAS, so every task id is
+ *  run exactly once. A worker that wakes up after its launch has finished
+ *  sees a different generation and claims nothing.
+ */
+class StealRange {
+ public:
+  /*! \brief The maximum number of tasks a stealing launch can hold. */
+  static constexpr int32_t kMaxTasks = 1 << 20;
+
+  void Reset(uint32_t generation, int32_t begin, int32_t end) {
+    word_.store(Pack(generation, begin, end), std::memory_order_release);
+  }
+  /*!
+   * \brief Claim the first unclaimed task of the slice.
+   * \param generation The generation of the launch.
+   * \param task_id The claimed task id.
+   * \return Whether a task was claimed.
+   */
+  bool PopFront(uint32_t generation, int32_t* task_id) {
+    uint64_t word = word_.load(std::memory_order_acquire);
+    while (true) {
+      uint32_t gen = Generation(word);
+      int32_t begin = Begin(word), end = End(word);
+      if (gen != generation || begin >= end) return false;
+      if (word_.compare_exchange_weak(word, Pack(gen, begin + 1, end),
+                                      std::memory_order_acq_rel)) {
+        *task_id = begin;
+        return true;
+      }
+    }
+  }
+  /*!
+   * \brief Steal the last unclaimed task of the slice.
+   * \param generation The generation of the launch.
+   * \param task_id The claimed task id.
+   * \return Whether a task was claimed.
+   */
+  bool PopBack(uint32_t generation, int32_t* task_id) {
+    uint64_t word = word_.load(std::memory_order_acquire);
+    while (true) {
+      uint32_t gen = Generation(word);
+      int32_t begin = Begin(word), end = End(word);
+      if (gen != generation || begin >= end) return false;
+      if (word_.compare_exchange_weak(word, Pack(gen, begin, end - 1),
+                                      std::memory_order_acq_rel)) {
+        *task_id = end - 1;
+        return true;
+      }
+    }
+  }
+  /*! \brief Mask applied to generations stored in the slice. */
+  static constexpr uint32_t kGenerationMask = (1U << 24) - 1;
+
+ private:
+  static constexpr int kIndexBits = 20;
+  static constexpr uint64_t kIndexMask = (1ULL << kIndexBits) - 1;
+
+  static uint64_t Pack(uint32_t generation, int32_t begin, int32_t end) {
+    return (static_cast<uint64_t>(generation & kGenerationMask) << (2 * kIndexBits)) |
+        (static_cast<uint64_t>(begin) << kIndexBits) | static_cast<uint64_t>(end);
+  }
+  static uint32_t Generation(uint64_t word) {
+    return static_cast<uint32_t>(word >> (2 * kIndexBits));
+  }
+  static int32_t Begin(uint64_t word) {
+    return static_cast<int32_t>((word >> kIndexBits) & kIndexMask);
+  }
+  static int32_t End(uint64_t word) {
+    return static_cast<int32_t>(word & kIndexMask);
+  }
+
+  std::atomic<uint64_t> word_{0};
+  // keep each slice on its own cache line
+  char pad_[kL1CacheBytes - sizeof(std::atomic<uint64_t>)];
+};
+
+constexpr int32_t StealRange::kMaxTasks;
+constexpr uint32_t StealRange::kGenerationMask;
+
 /*!
  * \brief Thread local master environment.
  */
@@ -81,10 +350,13 @@ class ParallelLauncher {
     // reshape
     if (static_cast<size_t>(num_task) > par_errors_.size()) {
       par_errors_.resize(num_task + 1);
-      if (need_sync) {
-        delete[] sync_counter_;
-        sync_counter_ = new std::atomic<int>[num_task * kSyncStride];
-      }
+    }
+    // work stealing can issue launches without sync before larger synced ones,
+    // so the counter page keeps its own capacity.
+    if (need_sync && num_task > num_sync_counter_) {
+      delete[] sync_counter_;
+      sync_counter_ = new std::atomic<int>[num_task * kSyncStride];
+      num_sync_counter_ = num_task;
     }
     if (need_sync) {
       for (int i = 0; i < num_task; ++i) {
@@ -97,8 +369,73 @@ class ParallelLauncher {
     }
   }
   ~ParallelLauncher() {
+    // stealing tasks that are still queued point to the slices of this launcher
+    while (num_refs_.load() != 0) {
+      tvm::runtime::threading::Yield();
+    }
     delete[] sync_counter_;
   }
+  // A stealing task referring to this launcher has been queued.
+  void AddRef() {
+    num_refs_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // A stealing task referring to this launcher has been consumed.
+  void Release() {
+    num_refs_.fetch_sub(1, std::memory_order_release);
+  }
+  /*!
+   * \brief Split the tasks of the current launch into slices for work stealing.
+   *  Must be called after Init.
+   * \param num_slices The number of slices, one per participating thread.
+   * \return The generation of this launch.
+   */
+  uint32_t InitStealRanges(int num_slices) {
+    if (static_cast<size_t>(num_slices) > num_steal_ranges_) {
+      // Stale workers may still be reading the old slices, keep them alive.
+      steal_ranges_.emplace_back(new StealRange[num_slices]);
+      num_steal_ranges_ = num_slices;
+    }
+    generation_ = (generation_ + 1) & StealRange::kGenerationMask;
+    if (generation_ == 0) generation_ = 1;
+    StealRange* ranges = this->steal_ranges();
+    int num_task = env.num_task;
+    for (int i = 0; i < num_slices; ++i) {
+      int32_t begin = static_cast<int64_t>(num_task) * i / num_slices;
+      int32_t end = static_cast<int64_t>(num_task) * (i + 1) / num_slices;
+      ranges[i].Reset(generation_, begin, end);
+    }
+    return generation_;
+  }
+  /*!
+   * \brief Run tasks of a stealing launch until no task is left to claim.
+   * \param slice The slice owned by the calling thread.
+   * \param num_slices The number of slices of the launch.
+   * \param generation The generation of the launch.
+   * \param ranges The slices of the launch.
+   */
+  void RunStealing(int slice, int num_slices, uint32_t generation, StealRange* ranges) {
+    int32_t task_id;
+    while (true) {
+      if (!ranges[slice].PopFront(generation, &task_id)) {
+        bool stolen = false;
+        for (int i = 1; i < num_slices && !stolen; ++i) {
+          stolen = ranges[(slice + i) % num_slices].PopBack(generation, &task_id);
+        }
+        if (!stolen) return;
+      }
+      // The launch cannot finish before the claimed task is signaled,
+      // so the closure is still valid here.
+      if ((*flambda)(task_id, &env, cdata) == 0) {
+        SignalJobFinish();
+      } else {
+        SignalJobError(task_id);
+      }
+    }
+  }
+  // The slices of the latest stealing launch.
+  StealRange* steal_ranges() const {
+    return steal_ranges_.back().get();
+  }
   // Wait n jobs to finish
   int WaitForJobs() {
     while (num_pending_.load() != 0) {
@@ -135,9 +472,6 @@ class ParallelLauncher {
   void* cdata;
   // Local env
   TVMParallelGroupEnv env;
-  // Whether this thread is worker of the pool.
-  // used to prevent recursive launch.
-  bool is_worker{false};
 
  private:
   // The pending jobs.
@@ -146,8 +480,18 @@ class ParallelLauncher {
   std::atomic<bool> has_error_;
   // The counter page.
   std::atomic<int32_t>* sync_counter_{nullptr};
+  // The number of tasks the counter page can hold.
+  int num_sync_counter_{0};
   // The error message
   std::vector<std::string> par_errors_;
+  // Number of queued stealing tasks referring to this launcher.
+  std::atomic<int32_t> num_refs_{0};
+  // The generation of the latest stealing launch.
+  uint32_t generation_{0};
+  // Capacity of the latest slice buffer.
+  size_t num_steal_ranges_{0};
+  // All slice buffers allocated so far.
+  std::vector<std::unique_ptr<StealRange[]> > steal_ranges_;
 };
 
 /*! \brief Lock-free single-producer-single-consumer queue for each thread */
@@ -157,6 +501,12 @@ class SpscTaskQueue {
   struct Task {
     ParallelLauncher* launcher;
     int32_t task_id;
+    /*! \brief Generation of the launch, only used by work stealing. */
+    uint32_t generation;
+    /*! \brief Number of slices, 0 when the task is statically assigned. */
+    int32_t num_slices;
+    /*! \brief The slices of a stealing launch. */
+    StealRange* ranges;
   };
 
   SpscTaskQueue() :
@@ -169,38 +519,64 @@ class SpscTaskQueue {
     delete[] buffer_;
   }
 
+  /*!
+   * \brief Remove the tasks left in the queue after the consumer has exited.
+   * \param f Called on each remaining task.
+   */
+  template<typename F>
+  void Drain(F f) {
+    uint32_t head = head_.load(std::memory_order_acquire);
+    while (head != tail_.load(std::memory_order_acquire)) {
+      f(buffer_[head]);
+      head = (head + 1) % kRingSize;
+    }
+    head_.store(head, std::memory_order_release);
+  }
+
   /*!
    * \brief Push a task into the queue and notify the comsumer if it is on wait.
    * \param input The task to be dequeued.
+   * \return Whether the task is enqueued, false once the queue is killed.
    */
-  void Push(const Task& input) {
+  bool Push(const Task& input) {
     while (!Enqueue(input)) {
+      if (exit_now_.load(std::memory_order_relaxed)) return false;
       tvm::runtime::threading::Yield();
     }
-    if (pending_.fetch_add(1) == -1) {
-      std::unique_lock<std::mutex> lock(mutex_);
-      cv_.notify_one();
-    }
+    Notify();
+    return true;
   }
 
   /*!
-   * \brief Pop a task out of the queue and condition wait if no tasks.
+   * \brief Push a task into the queue if it is not full.
+   * \param input The task to be enqueued.
+   * \return Whether the task is enqueued.
+   */
+  bool TryPush(const Task& input) {
+    if (!Enqueue(input)) return false;
+    Notify();
+    return true;
+  }
+
+  /*!
+   * \brief Pop a task out of the queue and park if no tasks.
    * \param output The pointer to the task to be dequeued.
-   * \param spin_count The number of iterations to spin before sleep.
+   * \param policy How long to spin before parking.
+   * \param stats The counters of the consumer.
    * \return Whether pop is successful (true) or we need to exit now (false).
    */
-  bool Pop(Task* output, uint32_t spin_count) {
+  bool Pop(Task* output, const WaitPolicy& policy, WorkerStats* stats) {
     // Busy wait a bit when the queue is empty.
     // If a new task comes to the queue quickly, this wait avoid the worker from sleeping.
     // The default spin count is set by following the typical omp convention
-    for (uint32_t i = 0; i < spin_count && pending_.load() == 0; ++i) {
-      tvm::runtime::threading::Yield();
-    }
+    int64_t begin = NowNanos();
+    policy.Spin([this]() { return pending_.load() != 0; });
+    int64_t spun = NowNanos();
+    stats->Add(&stats->spin_ns, spun - begin);
     if (pending_.fetch_sub(1) == 0) {
-      std::unique_lock<std::mutex> lock(mutex_);
-      cv_.wait(lock, [this] {
-          return pending_.load() >= 0 || exit_now_.load();
-        });
+      Park();
+      stats->Add(&stats->park_ns, NowNanos() - spun);
+      stats->Add(&stats->num_parks, 1);
     }
     if (exit_now_.load(std::memory_order_relaxed)) {
       return false;
@@ -218,27 +594,85 @@ class SpscTaskQueue {
    */
   void SignalForKill() {
     std::lock_guard<std::mutex> lock(mutex_);
+    // under the producer lock, so no task is pushed once this returns and
+    // Drain after the consumer exits sees all of them.
+    LockProducers();
     exit_now_.store(true);
-    cv_.notify_all();
+    producer_lock_.clear(std::memory_order_release);
+    Unpark(true);
   }
 
  protected:
+  // notify the consumer after an item has been enqueued
+  void Notify() {
+    if (pending_.fetch_add(1) == -1) {
+#if !defined(__linux__)
+      std::unique_lock<std::mutex> lock(mutex_);
+#endif
+      Unpark(false);
+    }
+  }
+
+  // Sleep until there is a pending task or the queue is killed.
+  void Park() {
+#if defined(__linux__)
+    // futex on a wake sequence number: a wake up that happens between the
+    // check and the wait changes the number and makes the wait return.
+    while (true) {
+      int32_t seq = wake_seq_.load(std::memory_order_acquire);
+      if (pending_.load() >= 0 || exit_now_.load()) return;
+      syscall(SYS_futex, reinterpret_cast<int32_t*>(&wake_seq_),
+              FUTEX_WAIT_PRIVATE, seq, nullptr, nullptr, 0);
+    }
+#else
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] {
+        return pending_.load() >= 0 || exit_now_.load();
+      });
+#endif
+  }
+
+  // Wake the parked consumer, the caller holds mutex_ when futex is not used.
+  void Unpark(bool all) {
+#if defined(__linux__)
+    wake_seq_.fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, reinterpret_cast<int32_t*>(&wake_seq_),
+            FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr, nullptr, 0);
+#else
+    if (all) {
+      cv_.notify_all();
+    } else {
+      cv_.notify_one();
+    }
+#endif
+  }
+
+  // Nested launches make the queue multi-producer, producers take a
+  // short spin lock which is uncontended for the common single master.
+  void LockProducers() {
+    while (producer_lock_.test_and_set(std::memory_order_acquire)) {
+      tvm::runtime::threading::Yield();
+    }
+  }
+
   /*!
    * \brief Lock-free enqueue.
    * \param input The task to be enqueued.
-   * \return Whether the task is enqueued.
+   * \return Whether the task is enqueued, false when the queue is full or killed.
    */
   bool Enqueue(const Task& input) {
-    if (exit_now_.load(std::memory_order_relaxed)) return false;
-
+    LockProducers();
+    bool pushed = false;
     const uint32_t tail = tail_.load(std::memory_order_relaxed);
 
-    if ((tail + 1) % kRingSize != (head_.load(std::memory_order_acquire))) {
+    if (!exit_now_.load(std::memory_order_relaxed) &&
+        (tail + 1) % kRingSize != (head_.load(std::memory_order_acquire))) {
       buffer_[tail] = input;
       tail_.store((tail + 1) % kRingSize, std::memory_order_release);
-      return true;
+      pushed = true;
     }
-    return false;
+    producer_lock_.clear(std::memory_order_release);
+    return pushed;
   }
 
   // the cache line paddings are used for avoid false sharing between atomic variables
@@ -266,6 +700,12 @@ class SpscTaskQueue {
   // signal for exit now
   std::atomic<bool> exit_now_{false};
 
+  cache_line_pad_t pad5_;
+  // futex word, bumped on every wake up
+  std::atomic<int32_t> wake_seq_{0};
+  // lock of the producers
+  std::atomic_flag producer_lock_ = ATOMIC_FLAG_INIT;
+
   // internal mutex
   std::mutex mutex_;
   // cv for consumer
@@ -275,7 +715,15 @@ class SpscTaskQueue {
 // The thread pool
 class ThreadPool {
  public:
-  ThreadPool(): num_workers_(tvm::runtime::threading::MaxConcurrency()) {
+  ThreadPool(): ThreadPool(tvm::runtime::threading::MaxConcurrency(), {}, false) {}
+  /*!
+   * \brief Create a pool.
+   * \param num_workers The number of workers, including the launching thread.
+   * \param cpus The CPUs to bind the workers to, empty for the default policy.
+   * \param shared Whether the pool is launched from several threads.
+   */
+  ThreadPool(int num_workers, const std::vector<unsigned int>& cpus, bool shared)
+      : num_workers_(num_workers), shared_(shared) {
     for (int i = 0; i < num_workers_; ++i) {
       // The SpscTaskQueue only hosts ONE item at a time
       queues_.emplace_back(std::unique_ptr<SpscTaskQueue>(new SpscTaskQueue()));
@@ -284,25 +732,196 @@ class ThreadPool {
     if (exclude_worker0 && atoi(exclude_worker0) == 0) {
       exclude_worker0_ = false;
     }
+    work_stealing_ = UseWorkStealing();
+    steal_grain_ = GetStealGrain();
+    stats_.reset(new WorkerStats[num_workers_]);
     threads_ = std::unique_ptr<tvm::runtime::threading::ThreadGroup>(
         new tvm::runtime::threading::ThreadGroup(
           num_workers_, [this](int worker_id) { this->RunWorker(worker_id); },
           exclude_worker0_ /* include_main_thread */));
-    num_workers_used_ = threads_->Configure(threading::ThreadGroup::kBig, 0, exclude_worker0_);
+    if (cpus.empty()) {
+      num_workers_used_ = threads_->Configure(threading::ThreadGroup::kBig, 0, exclude_worker0_);
+    } else {
+      num_workers_used_ = threads_->Configure(cpus, exclude_worker0_);
+    }
   }
   ~ThreadPool() {
     for (std::unique_ptr<SpscTaskQueue>& q : queues_) {
       q->SignalForKill();
     }
     threads_.reset();
+    for (std::unique_ptr<SpscTaskQueue>& q : queues_) {
+      q->Drain([](const SpscTaskQueue::Task& task) {
+          if (task.num_slices != 0) task.launcher->Release();
+        });
+    }
   }
   int Launch(FTVMParallelLambda flambda,
              void* cdata,
              int num_task,
              int need_sync) {
+    LaunchContext* ctx = Context();
+    if (ctx->depth != 0) {
+      return LaunchNested(ctx, flambda, cdata, num_task);
+    }
     ParallelLauncher* launcher = ParallelLauncher::ThreadLocal();
-    CHECK(!launcher->is_worker)
-        << "Cannot launch parallel job inside worker, consider fuse then parallel";
+    // launches into a shared pool take turns
+    std::unique_lock<std::mutex> lock(launch_mutex_, std::defer_lock);
+    if (shared_) lock.lock();
+    // the master runs task 0, launches from inside it are nested
+    ContextGuard guard(ctx, this, 0);
+    wait_policy_.RecordLaunchBegin();
+    int res;
+    if (work_stealing_) {
+      res = LaunchStealing(launcher, flambda, cdata, num_task, need_sync);
+    } else {
+      res = LaunchStatic(launcher, flambda, cdata, num_task, need_sync);
+    }
+    wait_policy_.RecordLaunchEnd();
+    return res;
+  }
+
+  static ThreadPool* ThreadLocal() {
+    return dmlc::ThreadLocalStore<ThreadPool>::Get();
+  }
+
+  /*! \return The largest number of tasks a synchronized launch can have. */
+  int num_workers_used() const {
+    return num_workers_used_;
+  }
+
+  /*! \brief Thread local scheduling state. */
+  struct LaunchContext {
+    // The named pool bound by ThreadPoolScope.
+    ThreadPool* bound{nullptr};
+    // The pool whose task the thread is running.
+    ThreadPool* active{nullptr};
+    // The slot of the thread in the active pool.
+    int slot{0};
+    // Number of launches the thread is running a task of.
+    int depth{0};
+    // Launchers of nested launches, indexed by depth - 1.
+    std::vector<std::unique_ptr<ParallelLauncher> > nested;
+  };
+  static LaunchContext* Context() {
+    return dmlc::ThreadLocalStore<LaunchContext>::Get();
+  }
+
+  // The pool parallel launches of the current thread go to.
+  static ThreadPool* Current() {
+    LaunchContext* ctx = Context();
+    if (ctx->depth != 0) return ctx->active;
+    return ctx->bound != nullptr ? ctx->bound : ThreadLocal();
+  }
+
+  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads) {
+    // this will also reset the affinity of the ThreadGroup
+    // may use less than the MaxConcurrency number of workers
+    num_workers_used_ = threads_->Configure(mode, nthreads,
+                                            exclude_worker0_);
+    // if MaxConcurrency restricted the number of workers (e.g., due to
+    // hyperthreading), respect the restriction
+    num_workers_used_ = std::min(num_workers_, num_workers_used_);
+  }
+
+  /*!
+   * \brief Dump the wait counters of the workers as JSON.
+   *  The counters are read without stopping the workers.
+   */
+  std::string GetStats() const {
+    std::ostringstream os;
+    os << "{\"wait_policy\": \"" << (wait_policy_.adaptive() ? "adaptive" : "spin") << "\", "
+       << "\"avg_launch_gap_us\": " << wait_policy_.avg_gap_ns() / 1000 << ", "
+       << "\"workers\": [";
+    for (int i = exclude_worker0_; i < num_workers_; ++i) {
+      const WorkerStats& st = stats_[i];
+      if (i != exclude_worker0_) os << ", ";
+      os << "{\"id\": " << i
+         << ", \"spin_us\": " << st.spin_ns.load(std::memory_order_relaxed) / 1000
+         << ", \"park_us\": " << st.park_ns.load(std::memory_order_relaxed) / 1000
+         << ", \"work_us\": " << st.work_ns.load(std::memory_order_relaxed) / 1000
+         << ", \"tasks\": " << st.num_tasks.load(std::memory_order_relaxed)
+         << ", \"parks\": " << st.num_parks.load(std::memory_order_relaxed) << "}";
+    }
+    os << "]}";
+    return os.str();
+  }
+
+  void ResetStats() {
+    for (int i = 0; i < num_workers_; ++i) {
+      stats_[i].Reset();
+    }
+  }
+
+ private:
+  // Enter a task of a pool for the scope of the guard.
+  class ContextGuard {
+   public:
+    ContextGuard(LaunchContext* ctx, ThreadPool* pool, int slot)
+        : ctx_(ctx), active_(ctx->active), slot_(ctx->slot) {
+      ctx_->active = pool;
+      ctx_->slot = slot;
+      ++ctx_->depth;
+    }
+    ~ContextGuard() {
+      --ctx_->depth;
+      ctx_->active = active_;
+      ctx_->slot = slot_;
+    }
+
+   private:
+    LaunchContext* ctx_;
+    ThreadPool* active_;
+    int slot_;
+  };
+
+  /*!
+   * \brief Launch from inside a task of this pool.
+   *
+   *  The loop is split as for work stealing and offered to every other
+   *  worker; workers that are busy pick it up once their current task is
+   *  done, while the launching thread and idle workers steal the rest. The
+   *  launch never waits for a task that has not started, so the parallel
+   *  barrier is not available.
+   */
+  int LaunchNested(LaunchContext* ctx,
+                   FTVMParallelLambda flambda,
+                   void* cdata,
+                   int num_task) {
+    if (ctx->nested.size() < static_cast<size_t>(ctx->depth)) {
+      ctx->nested.emplace_back(new ParallelLauncher());
+    }
+    ParallelLauncher* launcher = ctx->nested[ctx->depth - 1].get();
+    if (num_task == 0) {
+      num_task = num_workers_used_ * steal_grain_;
+    }
+    num_task = std::min(num_task, StealRange::kMaxTasks);
+    int slot = ctx->slot;
+    int num_slices = std::max(num_workers_used_, slot + 1);
+    launcher->Init(flambda, cdata, num_task, false);
+    SpscTaskQueue::Task tsk;
+    tsk.launcher = launcher;
+    tsk.num_slices = num_slices;
+    tsk.generation = launcher->InitStealRanges(num_slices);
+    tsk.ranges = launcher->steal_ranges();
+    for (int i = exclude_worker0_; i < num_slices; ++i) {
+      if (i == slot) continue;
+      tsk.task_id = i;
+      launcher->AddRef();
+      if (!queues_[i]->TryPush(tsk)) launcher->Release();
+    }
+    {
+      ContextGuard guard(ctx, this, slot);
+      launcher->RunStealing(slot, num_slices, tsk.generation, tsk.ranges);
+    }
+    return launcher->WaitForJobs();
+  }
+
+  int LaunchStatic(ParallelLauncher* launcher,
+                   FTVMParallelLambda flambda,
+                   void* cdata,
+                   int num_task,
+                   int need_sync) {
     if (num_task == 0) {
       num_task = num_workers_used_;
     }
@@ -314,10 +933,11 @@ class ThreadPool {
     launcher->Init(flambda, cdata, num_task, need_sync != 0);
     SpscTaskQueue::Task tsk;
     tsk.launcher = launcher;
+    tsk.num_slices = 0;
     // if worker0 is taken by the master, queues_[0] is abandoned
     for (int i = exclude_worker0_; i < num_task; ++i) {
       tsk.task_id = i;
-      queues_[i]->Push(tsk);
+      CHECK(queues_[i]->Push(tsk)) << "Launch into a thread pool being destroyed";
     }
     // use the master thread to run task 0
     if (exclude_worker0_) {
@@ -332,46 +952,105 @@ class ThreadPool {
     return res;
   }
 
-  static ThreadPool* ThreadLocal() {
-    return dmlc::ThreadLocalStore<ThreadPool>::Get();
-  }
-
-  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads) {
-    // this will also reset the affinity of the ThreadGroup
-    // may use less than the MaxConcurrency number of workers
-    num_workers_used_ = threads_->Configure(mode, nthreads,
-                                            exclude_worker0_);
-    // if MaxConcurrency restricted the number of workers (e.g., due to
-    // hyperthreading), respect the restriction
-    num_workers_used_ = std::min(num_workers_, num_workers_used_);
+  /*!
+   * \brief Launch with work stealing.
+   *
+   *  When the number of tasks is left to the pool, the loop is split into
+   *  steal_grain_ tasks per worker so that idle workers can take over the
+   *  remaining work of a slow one. Such launches cannot use the parallel
+   *  barrier, since the tasks are not guaranteed to run concurrently.
+   */
+  int LaunchStealing(ParallelLauncher* launcher,
+                     FTVMParallelLambda flambda,
+                     void* cdata,
+                     int num_task,
+                     int need_sync) {
+    int num_slices = num_workers_used_;
+    if (num_task == 0) {
+      num_task = std::min(num_workers_used_ * steal_grain_, StealRange::kMaxTasks);
+      need_sync = need_sync && num_task <= num_workers_used_;
+    } else {
+      CHECK_LE(num_task, num_workers_used_)
+          << "Request parallel sync task larger than number of threads used "
+          << " workers=" << num_workers_used_ << " request=" << num_task;
+      num_slices = num_task;
+    }
+    launcher->Init(flambda, cdata, num_task, need_sync != 0);
+    SpscTaskQueue::Task tsk;
+    tsk.launcher = launcher;
+    tsk.num_slices = num_slices;
+    tsk.generation = launcher->InitStealRanges(num_slices);
+    tsk.ranges = launcher->steal_ranges();
+    for (int i = exclude_worker0_; i < num_slices; ++i) {
+      tsk.task_id = i;
+      launcher->AddRef();
+      if (need_sync) {
+        // barrier needs every task to be running at the same time
+        if (!queues_[i]->Push(tsk)) {
+          launcher->Release();
+          LOG(FATAL) << "Launch into a thread pool being destroyed";
+        }
+      } else if (!queues_[i]->TryPush(tsk)) {
+        // A worker that is still busy with a previous launch is skipped,
+        // its slice will be stolen by the others.
+        launcher->Release();
+      }
+    }
+    if (exclude_worker0_) {
+      launcher->RunStealing(0, num_slices, tsk.generation, tsk.ranges);
+    }
+    return launcher->WaitForJobs();
   }
 
- private:
   // Internal worker function.
   void RunWorker(int worker_id) {
     SpscTaskQueue* queue = queues_[worker_id].get();
     SpscTaskQueue::Task task;
-    ParallelLauncher::ThreadLocal()->is_worker = true;
-    // Initialize the spin count (from envvar TVM_THREAD_POOL_SPIN_COUNT) on
-    // the global first use of the ThreadPool.
-    // TODO(tulloch): should we make this configurable via standard APIs?
-    static size_t spin_count = GetSpinCount();
-    while (queue->Pop(&task, spin_count)) {
+    WorkerStats* stats = &stats_[worker_id];
+    // launches from the tasks of this worker are nested into the pool
+    ContextGuard guard(Context(), this, worker_id);
+    while (queue->Pop(&task, wait_policy_, stats)) {
       CHECK(task.launcher != nullptr);
-      TVMParallelGroupEnv* penv = &(task.launcher->env);
-      void* cdata = task.launcher->cdata;
-      if ((*task.launcher->flambda)(task.task_id, penv, cdata) == 0) {
-        task.launcher->SignalJobFinish();
+      int64_t begin = NowNanos();
+      if (task.num_slices != 0) {
+        task.launcher->RunStealing(task.task_id, task.num_slices,
+                                   task.generation, task.ranges);
+        task.launcher->Release();
       } else {
-        task.launcher->SignalJobError(task.task_id);
+        TVMParallelGroupEnv* penv = &(task.launcher->env);
+        void* cdata = task.launcher->cdata;
+        if ((*task.launcher->flambda)(task.task_id, penv, cdata) == 0) {
+          task.launcher->SignalJobFinish();
+        } else {
+          task.launcher->SignalJobError(task.task_id);
+        }
       }
+      stats->Add(&stats->work_ns, NowNanos() - begin);
+      stats->Add(&stats->num_tasks, 1);
     }
+    // release the launchers of stealing tasks nobody will run, the nested
+    // launchers of other workers wait for them before they are destroyed
+    queue->Drain([](const SpscTaskQueue::Task& task) {
+        if (task.num_slices != 0) task.launcher->Release();
+      });
   }
   int num_workers_;
   // number of workers used (can be restricted with affinity pref)
   int num_workers_used_;
   // if or not to exclude worker 0 and use master to run task 0
   bool exclude_worker0_{true};
+  // whether several threads launch into this pool
+  bool shared_{false};
+  // serializes the launches of a shared pool
+  std::mutex launch_mutex_;
+  // how idle workers wait, the spin count is read once per pool
+  WaitPolicy wait_policy_;
+  // wait counters of each worker
+  std::unique_ptr<WorkerStats[]> stats_;
+  // whether to schedule parallel loops with work stealing
+  bool work_stealing_{false};
+  // number of tasks per worker when work stealing splits a loop
+  int steal_grain_{kDefaultStealGrain};
   std::vector<std::unique_ptr<SpscTaskQueue> > queues_;
   std::unique_ptr<tvm::runtime::threading::ThreadGroup> threads_;
 };
@@ -385,6 +1064,185 @@ TVM_REGISTER_GLOBAL("runtime.config_threadpool")
     ThreadPool::ThreadLocal()->UpdateWorkerConfiguration(mode, nthreads);
 });
 
+namespace threading {
+
+/*! \brief Registry of the named thread pools. */
+class ThreadPoolRegistry {
+ public:
+  void Create(const std::string& name, int num_threads, const std::vector<unsigned int>& cpus) {
+    CHECK(!name.empty()) << "The name of a thread pool cannot be empty";
+    if (num_threads == 0) {
+      num_threads = cpus.empty() ? MaxConcurrency() : static_cast<int>(cpus.size());
+    }
+    CHECK_GT(num_threads, 0) << "Requested a non-positive number of threads";
+    std::lock_guard<std::mutex> lock(mutex_);
+    CHECK(!pools_.count(name)) << "Thread pool " << name << " already exists";
+    pools_[name] = std::make_shared<ThreadPool>(num_threads, cpus, true);
+  }
+
+  void Remove(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pools_.erase(name);
+  }
+
+  std::shared_ptr<ThreadPool> Get(const std::string& name) {
+    if (name.empty()) return nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pools_.find(name);
+    CHECK(it != pools_.end()) << "Cannot find thread pool " << name;
+    return it->second;
+  }
+
+  static ThreadPoolRegistry* Global() {
+    static ThreadPoolRegistry inst;
+    return &inst;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<ThreadPool> > pools_;
+};
+
+void CreateThreadPool(const std::string& name,
+                      int num_threads,
+                      const std::vector<unsigned int>& cpus) {
+  ThreadPoolRegistry::Global()->Create(name, num_threads, cpus);
+}
+
+void RemoveThreadPool(const std::string& name) {
+  ThreadPoolRegistry::Global()->Remove(name);
+}
+
+std::shared_ptr<ThreadPool> GetThreadPool(const std::string& name) {
+  return ThreadPoolRegistry::Global()->Get(name);
+}
+
+int CurrentConcurrency() {
+#if TVM_THREADPOOL_USE_OPENMP
+  return MaxConcurrency();
+#else
+  return ThreadPool::Current()->num_workers_used();
+#endif
+}
+
+ThreadPoolScope::ThreadPoolScope(const std::shared_ptr<ThreadPool>& pool)
+    : prev_(ThreadPool::Context()->bound) {
+  if (pool != nullptr) {
+    ThreadPool::Context()->bound = pool.get();
+  }
+}
+
+ThreadPoolScope::~ThreadPoolScope() {
+  ThreadPool::Context()->bound = prev_;
+}
+
+/*! \brief The threads running the asynchronous calls. */
+class AsyncExecutor {
+ public:
+  explicit AsyncExecutor(int num_threads) {
+    for (int i = 0; i < num_threads; ++i) {
+      threads_.emplace_back([this]() { this->Loop(); });
+    }
+  }
+
+  void Submit(const void* key, std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Strand& strand = strands_[key];
+    strand.tasks.push_back(std::move(task));
+    if (!strand.scheduled) {
+      strand.scheduled = true;
+      ready_.push_back(key);
+      cv_.notify_one();
+    }
+  }
+
+  static AsyncExecutor* Global() {
+    // leaked on purpose, the threads may still be waiting at exit.
+    static AsyncExecutor* inst = new AsyncExecutor(GetNumAsyncThreads());
+    return inst;
+  }
+
+ private:
+  /*! \brief The queued tasks of one key. */
+  struct Strand {
+    std::deque<std::function<void()> > tasks;
+    /*! \brief Whether the key is in ready_ or run by a thread. */
+    bool scheduled{false};
+  };
+
+  void Loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait(lock, [this]() { return !ready_.empty(); });
+      const void* key = ready_.front();
+      ready_.pop_front();
+      Strand& strand = strands_.at(key);
+      std::function<void()> task = std::move(strand.tasks.front());
+      strand.tasks.pop_front();
+      lock.unlock();
+      task();
+      lock.lock();
+      // only this thread touches the strand until it is scheduled again.
+      if (strand.tasks.empty()) {
+        strands_.erase(key);
+      } else {
+        ready_.push_back(key);
+        cv_.notify_one();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unordered_map<const void*, Strand> strands_;
+  /*! \brief The keys with a task to run, in order. */
+  std::deque<const void*> ready_;
+  std::vector<std::thread> threads_;
+};
+
+void RunAsync(const void* key, std::function<void()> task) {
+  AsyncExecutor::Global()->Submit(key, std::move(task));
+}
+
+}  // namespace threading
+
+TVM_REGISTER_GLOBAL("runtime.GetThreadPoolStats")
+.set_body_typed([]() {
+    return ThreadPool::Current()->GetStats();
+});
+
+TVM_REGISTER_GLOBAL("runtime.ResetThreadPoolStats")
+.set_body_typed([]() {
+    ThreadPool::Current()->ResetStats();
+});
+
+TVM_REGISTER_GLOBAL("runtime.CreateThreadPool")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    std::string name = args[0];
+    int num_threads = args[1];
+    std::vector<unsigned int> cpus;
+    for (int i = 2; i < args.num_args; ++i) {
+      int cpu = args[i];
+      cpus.push_back(static_cast<unsigned int>(cpu));
+    }
+    threading::CreateThreadPool(name, num_threads, cpus);
+});
+
+TVM_REGISTER_GLOBAL("runtime.CreateNumaThreadPools")
+.set_body_typed([](std::string prefix) {
+    // one pool per node on its physical cores, named prefix + node index.
+    std::vector<std::vector<unsigned int> > nodes = threading::NumaNodeCpus(true);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      threading::CreateThreadPool(prefix + std::to_string(i), 0, nodes[i]);
+    }
+    return static_cast<int>(nodes.size());
+});
+
+TVM_REGISTER_GLOBAL("runtime.RemoveThreadPool")
+.set_body_typed([](std::string name) {
+    threading::RemoveThreadPool(name);
+});
+
 
 }  // namespace runtime
 }  // namespace tvm
@@ -395,7 +1253,7 @@ int TVMBackendParallelLaunch(
     void* cdata,
     int num_task) {
 #if !TVM_THREADPOOL_USE_OPENMP
-  int res = tvm::runtime::ThreadPool::ThreadLocal()->Launch(
+  int res = tvm::runtime::ThreadPool::Current()->Launch(
       flambda, cdata, num_task, 1);
   return res;
 #else
@@ -418,6 +1276,10 @@ int TVMBackendParallelBarrier(int task_id, TVMParallelGroupEnv* penv) {
 #else
   using tvm::runtime::kSyncStride;
   int num_task = penv->num_task;
+  CHECK(penv->sync_handle != nullptr)
+      << "Parallel barrier is not available in nested parallel launches, or when "
+      << "work stealing splits the loop into more tasks than workers, "
+      << "set TVM_THREAD_POOL_STEAL_GRAIN=1 or unset TVM_THREAD_POOL_WORK_STEALING";
   std::atomic<int>* sync_counter =
       reinterpret_cast<std::atomic<int>*>(penv->sync_handle);
   int old_counter = sync_counter[task_id * kSyncStride].fetch_add(
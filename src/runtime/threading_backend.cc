@@ -25,6 +25,8 @@
 #include <dmlc/logging.h>
 #include <thread>
 #include <algorithm>
+#include <string>
+#include <vector>
 #if defined(__linux__) || defined(__ANDROID__)
 #include <fstream>
 #include <sstream>
@@ -38,6 +40,83 @@ namespace tvm {
 namespace runtime {
 namespace threading {
 
+/*!
+ * \brief The thread binding policy from TVM_BIND_THREADS.
+ *
+ *  - unset or 1: bind workers to cores in order of frequency.
+ *  - 0: do not bind.
+ *  - numa: bind to the cores of the NUMA node the master thread runs on,
+ *    and use no more workers than that node has, so parallel loops do
+ *    not span sockets.
+ *  - compact: bind in NUMA node order, filling one node before the next.
+ */
+enum class BindPolicy { kNone, kDefault, kNuma, kCompact };
+
+static BindPolicy GetBindPolicy() {
+  const char* val = getenv("TVM_BIND_THREADS");
+  if (val == nullptr) return BindPolicy::kDefault;
+  std::string policy = val;
+  if (policy == "numa") return BindPolicy::kNuma;
+  if (policy == "compact") return BindPolicy::kCompact;
+  return atoi(val) == 1 ? BindPolicy::kDefault : BindPolicy::kNone;
+}
+
+#if defined(__linux__) || defined(__ANDROID__)
+// Parse a sysfs cpu list such as "0-3,8,10-11".
+static std::vector<unsigned int> ParseCpuList(const std::string& path) {
+  std::vector<unsigned int> cpus;
+  std::ifstream ifs(path);
+  std::string list;
+  if (ifs.fail() || !(ifs >> list)) return cpus;
+  std::istringstream is(list);
+  std::string range;
+  while (std::getline(is, range, ',')) {
+    if (range.empty()) continue;
+    size_t dash = range.find('-');
+    unsigned int begin = std::stoul(range.substr(0, dash));
+    unsigned int end = dash == std::string::npos ? begin : std::stoul(range.substr(dash + 1));
+    for (unsigned int i = begin; i <= end; ++i) {
+      cpus.push_back(i);
+    }
+  }
+  return cpus;
+}
+#endif
+
+std::vector<std::vector<unsigned int> > NumaNodeCpus(bool physical_only) {
+  std::vector<std::vector<unsigned int> > nodes;
+  unsigned int num_cpus = std::thread::hardware_concurrency();
+#if defined(__linux__) || defined(__ANDROID__)
+  for (unsigned int node : ParseCpuList("/sys/devices/system/node/online")) {
+    std::ostringstream path;
+    path << "/sys/devices/system/node/node" << node << "/cpulist";
+    std::vector<unsigned int> primary, siblings;
+    for (unsigned int cpu : ParseCpuList(path.str())) {
+      if (cpu >= num_cpus) continue;
+      std::ostringstream sibling_path;
+      sibling_path << "/sys/devices/system/cpu/cpu" << cpu << "/topology/thread_siblings_list";
+      std::vector<unsigned int> core = ParseCpuList(sibling_path.str());
+      if (core.empty() || core[0] == cpu) {
+        primary.push_back(cpu);
+      } else {
+        siblings.push_back(cpu);
+      }
+    }
+    if (!physical_only) {
+      primary.insert(primary.end(), siblings.begin(), siblings.end());
+    }
+    if (!primary.empty()) nodes.push_back(primary);
+  }
+#endif
+  if (nodes.empty()) {
+    nodes.emplace_back();
+    for (unsigned int i = 0; i < num_cpus; ++i) {
+      nodes.back().push_back(i);
+    }
+  }
+  return nodes;
+}
+
 class ThreadGroup::Impl {
  public:
   Impl(int num_workers,
@@ -79,8 +158,17 @@ class ThreadGroup::Impl {
     // ones.
     num_workers_used = std::min(num_workers_, num_workers_used);
 
-    const char *val = getenv("TVM_BIND_THREADS");
-    if (val == nullptr || atoi(val) == 1) {
+    BindPolicy policy = GetBindPolicy();
+    if ((policy == BindPolicy::kNuma || policy == BindPolicy::kCompact) && mode != kLittle) {
+      std::vector<unsigned int> cpus = NumaOrder(policy == BindPolicy::kNuma);
+      if (policy == BindPolicy::kNuma) {
+        num_workers_used = std::min(num_workers_used, static_cast<int>(cpus.size()));
+      }
+      SetAffinity(cpus, exclude_worker0);
+      if (exclude_worker0) SetMasterThreadAffinity(cpus);
+      return num_workers_used;
+    }
+    if (policy != BindPolicy::kNone) {
       // Do not set affinity if there are more workers than found cores
       if (sorted_order_.size() >= static_cast<unsigned int>(num_workers_)) {
           SetAffinity(exclude_worker0, mode == kLittle);
@@ -93,6 +181,14 @@ class ThreadGroup::Impl {
     return num_workers_used;
   }
 
+  int Configure(const std::vector<unsigned int>& cpus, bool exclude_worker0) {
+    CHECK(!cpus.empty()) << "Requested an empty list of cpus.";
+    if (GetBindPolicy() != BindPolicy::kNone) {
+      SetAffinity(cpus, exclude_worker0);
+    }
+    return num_workers_;
+  }
+
  private:
   // bind worker threads to disjoint cores
   // if worker 0 is offloaded to master, i.e. exclude_worker0 is true,
@@ -122,15 +218,7 @@ class ThreadGroup::Impl {
       } else {
         core_id = sorted_order_[i + exclude_worker0];
       }
-      cpu_set_t cpuset;
-      CPU_ZERO(&cpuset);
-      CPU_SET(core_id, &cpuset);
-#if defined(__ANDROID__)
-      sched_setaffinity(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
-#else
-      pthread_setaffinity_np(threads_[i].native_handle(),
-          sizeof(cpu_set_t), &cpuset);
-#endif
+      BindThread(i, core_id);
     }
     if (exclude_worker0) {  // master thread run task
       // Master thread will have free migration on needed cores.
@@ -142,6 +230,69 @@ class ThreadGroup::Impl {
 #endif
   }
 
+  // bind worker threads to the given cores in order,
+  // the master thread keeps its affinity.
+  void SetAffinity(const std::vector<unsigned int>& cpus, bool exclude_worker0) {
+#if defined(__linux__) || defined(__ANDROID__)
+    for (unsigned i = 0; i < threads_.size(); ++i) {
+      BindThread(i, cpus[(i + exclude_worker0) % cpus.size()]);
+    }
+#endif
+  }
+
+  // bind the i-th thread of the group to one core
+  void BindThread(unsigned i, unsigned core_id) {
+#if defined(__linux__) || defined(__ANDROID__)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core_id, &cpuset);
+#if defined(__ANDROID__)
+    sched_setaffinity(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
+#else
+    pthread_setaffinity_np(threads_[i].native_handle(),
+        sizeof(cpu_set_t), &cpuset);
+#endif
+#endif
+  }
+
+  // The cores in NUMA node order, starting with the node of the calling
+  // thread. With single_node, only the cores of that node.
+  static std::vector<unsigned int> NumaOrder(bool single_node) {
+    std::vector<std::vector<unsigned int> > nodes = NumaNodeCpus();
+    size_t first = 0;
+#if defined(__linux__) && !defined(__ANDROID__)
+    int cur = sched_getcpu();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (std::find(nodes[i].begin(), nodes[i].end(), static_cast<unsigned int>(cur)) !=
+          nodes[i].end()) {
+        first = i;
+      }
+    }
+#endif
+    std::vector<unsigned int> cpus;
+    for (size_t k = 0; k < (single_node ? 1 : nodes.size()); ++k) {
+      const auto& node = nodes[(first + k) % nodes.size()];
+      cpus.insert(cpus.end(), node.begin(), node.end());
+    }
+    return cpus;
+  }
+
+  // let the master thread migrate within the given cores.
+  void SetMasterThreadAffinity(const std::vector<unsigned int>& cpus) {
+#if defined(__linux__) || defined(__ANDROID__)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (unsigned int cpu : cpus) {
+      CPU_SET(cpu, &cpuset);
+    }
+#if defined(__ANDROID__)
+    sched_setaffinity(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#else
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#endif
+#endif
+  }
+
   void SetMasterThreadFullCpuAffinity(bool reverse) {
 #if defined(__linux__) || defined(__ANDROID__)
     cpu_set_t cpuset;
@@ -239,6 +390,10 @@ int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0
   return impl_->Configure(mode, nthreads, exclude_worker0);
 }
 
+int ThreadGroup::Configure(const std::vector<unsigned int>& cpus, bool exclude_worker0) {
+  return impl_->Configure(cpus, exclude_worker0);
+}
+
 void Yield() {
   std::this_thread::yield();
 }
@@ -0,0 +1,277 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file runtime/best_fit_allocator.h
+ */
+#ifndef TVM_RUNTIME_VM_BEST_FIT_ALLOCATOR_H_
+#define TVM_RUNTIME_VM_BEST_FIT_ALLOCATOR_H_
+
+#include <tvm/runtime/device_api.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "memory_manager.h"
+
+namespace tvm {
+namespace runtime {
+namespace vm {
+
+/*!
+ * \brief An allocator carving buffers out of large device arenas.
+ *
+ *  A request takes the smallest free block that fits, the remainder is split
+ *  off as a new free block, and a freed block is merged with its free
+ *  neighbours. Unlike PooledAllocator, buffers of slightly different sizes
+ *  reuse the same memory, which matters for dynamic shape models.
+ *
+ *  Buffers are addressed as an offset into the arena, so the allocator only
+ *  works for devices with flat pointers such as CPU, CUDA and ROCm.
+ */
+class BestFitAllocator final : public Allocator {
+ public:
+  /*! \brief When fully free arenas are given back to the device. */
+  enum ReleasePolicy {
+    /*! \brief Keep every arena until the allocator is destroyed. */
+    kKeep = 0,
+    /*! \brief Release free arenas while the reserved memory is above the high-water mark. */
+    kHighWater = 1,
+    /*! \brief Release an arena as soon as it is fully free. */
+    kEager = 2,
+  };
+
+  static constexpr size_t kPageSize = 4096;
+  static constexpr size_t kDefaultArenaSize = 2 << 20;
+
+  /*!
+   * \brief Create the allocator.
+   * \param ctx The context of the allocations.
+   * \param arena_size The minimum size of the arenas requested from the device.
+   * \param high_water The reserved bytes above which free arenas are released, 0 means no limit.
+   * \param policy The release policy.
+   */
+  explicit BestFitAllocator(TVMContext ctx,
+                            size_t arena_size = kDefaultArenaSize,
+                            size_t high_water = 0,
+                            ReleasePolicy policy = kHighWater)
+      : Allocator(), ctx_(ctx), arena_size_(RoundUp(std::max(arena_size, static_cast<size_t>(kPageSize)))),
+        high_water_(high_water), policy_(policy) {}
+
+  ~BestFitAllocator() {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (auto& arena : arenas_) {
+      FreeArena(arena.get());
+    }
+    arenas_.clear();
+  }
+
+  Buffer Alloc(size_t nbytes, size_t alignment, DLDataType type_hint) override {
+    CHECK_LE(alignment, static_cast<size_t>(kPageSize))
+        << "BestFitAllocator supports alignment up to " << static_cast<size_t>(kPageSize);
+    std::lock_guard<std::mutex> lock(mu_);
+    size_t size = RoundUp(std::max(nbytes, static_cast<size_t>(1)));
+    auto it = free_blocks_.lower_bound(size);
+    if (it == free_blocks_.end()) {
+      it = NewArena(size, type_hint)->free_it;
+    }
+    Block* block = it->second;
+    free_blocks_.erase(it);
+    block->free = false;
+    if (block->size - size >= kPageSize) {
+      // split the remainder into a new free block.
+      Block* rest = new Block();
+      rest->arena = block->arena;
+      rest->offset = block->offset + size;
+      rest->size = block->size - size;
+      rest->prev = block;
+      rest->next = block->next;
+      if (block->next != nullptr) block->next->prev = rest;
+      block->next = rest;
+      block->size = size;
+      InsertFree(rest);
+    }
+    used_memory_ += block->size;
+    Buffer buf;
+    buf.ctx = ctx_;
+    buf.size = nbytes;
+    buf.data = static_cast<char*>(block->arena->data) + block->offset;
+    allocated_[buf.data] = block;
+    DLOG(INFO) << "allocate " << block->size << " B, used memory " << used_memory_
+               << " B, reserved " << reserved_memory_ << " B";
+    return buf;
+  }
+
+  void Free(const Buffer& buffer) override {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = allocated_.find(buffer.data);
+    CHECK(it != allocated_.end()) << "trying to free a buffer not allocated by this allocator";
+    Block* block = it->second;
+    allocated_.erase(it);
+    used_memory_ -= block->size;
+    block->free = true;
+    // coalesce with the free neighbours.
+    if (block->next != nullptr && block->next->free) {
+      free_blocks_.erase(block->next->free_it);
+      Merge(block, block->next);
+    }
+    if (block->prev != nullptr && block->prev->free) {
+      Block* prev = block->prev;
+      free_blocks_.erase(prev->free_it);
+      Merge(prev, block);
+      block = prev;
+    }
+    InsertFree(block);
+    Arena* arena = block->arena;
+    if (block->prev == nullptr && block->next == nullptr) {
+      if (policy_ == kEager) {
+        ReleaseArena(arena);
+      } else if (policy_ == kHighWater && high_water_ != 0 && reserved_memory_ > high_water_) {
+        ReleaseFreeArenas(high_water_);
+      }
+    }
+    DLOG(INFO) << "reclaim buffer " << buffer.size << ", used memory " << used_memory_ << " B";
+  }
+
+  size_t UsedMemory() const override {
+    std::lock_guard<std::mutex> lock(mu_);
+    return used_memory_;
+  }
+
+  /*! \brief The amount of memory held from the device, including free blocks. */
+  size_t ReservedMemory() const override {
+    std::lock_guard<std::mutex> lock(mu_);
+    return reserved_memory_;
+  }
+
+ private:
+  struct Arena;
+  /*! \brief A contiguous range of an arena, free or handed out. */
+  struct Block {
+    Arena* arena{nullptr};
+    size_t offset{0};
+    size_t size{0};
+    bool free{true};
+    /*! \brief The neighbours in address order. */
+    Block* prev{nullptr};
+    Block* next{nullptr};
+    /*! \brief Position in free_blocks_ when free. */
+    std::multimap<size_t, Block*>::iterator free_it;
+  };
+  /*! \brief A device allocation split into blocks. */
+  struct Arena {
+    void* data{nullptr};
+    size_t size{0};
+    /*! \brief The block at offset 0. */
+    Block* head{nullptr};
+  };
+
+  static size_t RoundUp(size_t nbytes) {
+    return (nbytes + kPageSize - 1) / kPageSize * kPageSize;
+  }
+
+  void InsertFree(Block* block) {
+    block->free_it = free_blocks_.emplace(block->size, block);
+  }
+
+  // Absorb next into block, neither of them is in free_blocks_.
+  void Merge(Block* block, Block* next) {
+    block->size += next->size;
+    block->next = next->next;
+    if (next->next != nullptr) next->next->prev = block;
+    delete next;
+  }
+
+  Block* NewArena(size_t size, DLDataType type_hint) {
+    size_t arena_bytes = std::max(arena_size_, size);
+    if (high_water_ != 0 && reserved_memory_ + arena_bytes > high_water_) {
+      ReleaseFreeArenas(high_water_ > arena_bytes ? high_water_ - arena_bytes : 0);
+    }
+    std::unique_ptr<Arena> arena(new Arena());
+    arena->size = arena_bytes;
+    arena->data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, arena_bytes, kPageSize, type_hint);
+    reserved_memory_ += arena_bytes;
+    Block* block = new Block();
+    block->arena = arena.get();
+    block->size = arena_bytes;
+    arena->head = block;
+    InsertFree(block);
+    arenas_.push_back(std::move(arena));
+    DLOG(INFO) << "new arena " << arena_bytes << " B, reserved " << reserved_memory_ << " B";
+    return block;
+  }
+
+  // Give a fully free arena back to the device.
+  void ReleaseArena(Arena* arena) {
+    free_blocks_.erase(arena->head->free_it);
+    FreeArena(arena);
+    for (auto it = arenas_.begin(); it != arenas_.end(); ++it) {
+      if (it->get() == arena) {
+        arenas_.erase(it);
+        break;
+      }
+    }
+  }
+
+  // Release fully free arenas, largest first, until at most target bytes are reserved.
+  void ReleaseFreeArenas(size_t target) {
+    std::vector<Arena*> empty;
+    for (auto& arena : arenas_) {
+      if (arena->head->free && arena->head->next == nullptr) empty.push_back(arena.get());
+    }
+    std::sort(empty.begin(), empty.end(), [](Arena* a, Arena* b) { return a->size > b->size; });
+    for (Arena* arena : empty) {
+      if (reserved_memory_ <= target) break;
+      ReleaseArena(arena);
+    }
+  }
+
+  void FreeArena(Arena* arena) {
+    for (Block* block = arena->head; block != nullptr;) {
+      Block* next = block->next;
+      delete block;
+      block = next;
+    }
+    arena->head = nullptr;
+    DeviceAPI::Get(ctx_)->FreeDataSpace(ctx_, arena->data);
+    reserved_memory_ -= arena->size;
+  }
+
+  TVMContext ctx_;
+  size_t arena_size_;
+  size_t high_water_;
+  ReleasePolicy policy_;
+  size_t used_memory_{0};
+  size_t reserved_memory_{0};
+  /*! \brief Free blocks ordered by size. */
+  std::multimap<size_t, Block*> free_blocks_;
+  /*! \brief The block behind each buffer handed out. */
+  std::unordered_map<void*, Block*> allocated_;
+  std::vector<std::unique_ptr<Arena> > arenas_;
+  mutable std::mutex mu_;
+};
+
+}  // namespace vm
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_VM_BEST_FIT_ALLOCATOR_H_
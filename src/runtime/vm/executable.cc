@@ -24,7 +24,9 @@
 
 #include <dmlc/memory_io.h>
 #include <tvm/runtime/c_runtime_api.h>
+#include <tvm/runtime/device_api.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/runtime/serializer.h>
 #include <tvm/runtime/vm.h>
 
 #include <algorithm>
@@ -36,6 +38,7 @@
 #include <vector>
 
 #include "serialize_util.h"
+#include "../file_util.h"
 
 namespace tvm {
 namespace runtime {
@@ -68,6 +71,10 @@ PackedFunc Executable::GetFunction(const std::string& name,
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       *rv = this->Save();
     });
+  } else if (name == "save_mapped") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      *rv = this->SaveMapped();
+    });
   } else if (name == "get_function_arity") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       std::string func_name = args[0];
@@ -148,9 +155,9 @@ std::string Executable::Stats() const {
   oss << "Relay VM executable statistics:" << std::endl;
 
   // Get the number of constants and the shape of each of them.
-  oss << "  Constant shapes (# " << constants.size() << "): [";
-  for (const auto& it : constants) {
-    const auto constant = Downcast<NDArray>(it);
+  oss << "  Constant shapes (# " << NumConstants() << "): [";
+  for (size_t i = 0; i < NumConstants(); ++i) {
+    const auto constant = Downcast<NDArray>(GetConstant(i));
     const auto& shape = constant.Shape();
 
     // Scalar
@@ -166,7 +173,7 @@ std::string Executable::Stats() const {
     oss.seekp(-2, oss.cur);
     oss << "], " << std::endl;
   }
-  if (!constants.empty()) oss.seekp(-2, oss.cur);
+  if (NumConstants() != 0) oss.seekp(-2, oss.cur);
   oss << "]" << std::endl;
 
   // Get the number of globals and the name of each of them.
@@ -246,14 +253,10 @@ void Executable::SaveGlobalSection(dmlc::Stream* strm) {
 }
 
 void Executable::SaveConstantSection(dmlc::Stream* strm) {
-  std::vector<DLTensor*> arrays;
-  for (const auto& obj : this->constants) {
-    const auto cell = Downcast<runtime::NDArray>(obj);
-    arrays.push_back(const_cast<DLTensor*>(cell.operator->()));
-  }
-  strm->Write(static_cast<uint64_t>(this->constants.size()));
-  for (const auto& it : arrays) {
-    runtime::SaveDLTensor(strm, it);
+  strm->Write(static_cast<uint64_t>(NumConstants()));
+  for (size_t i = 0; i < NumConstants(); ++i) {
+    const auto cell = Downcast<runtime::NDArray>(GetConstant(i));
+    runtime::SaveDLTensor(strm, const_cast<DLTensor*>(cell.operator->()));
   }
 }
 
@@ -359,6 +362,23 @@ VMInstructionSerializer SerializeInstruction(const Instruction& instr) {
       fields.push_back(instr.dst);
       break;
     }
+    case Opcode::AllocStaticTensor: {
+      // Number of fields = 8 + instr.alloc_static_tensor.ndim
+      fields.push_back(instr.alloc_static_tensor.slot);
+      fields.push_back(instr.alloc_static_tensor.allocation_size);
+      fields.push_back(instr.alloc_static_tensor.alignment);
+      // Save `DLDataType` and the dst register.
+      const auto& dtype = instr.alloc_static_tensor.dtype;
+      fields.push_back(dtype.code);
+      fields.push_back(dtype.bits);
+      fields.push_back(dtype.lanes);
+      fields.push_back(instr.alloc_static_tensor.ndim);
+      fields.push_back(instr.dst);
+      // Save the shape of the tensor.
+      fields.insert(fields.end(), instr.alloc_static_tensor.shape,
+                    instr.alloc_static_tensor.shape + instr.alloc_static_tensor.ndim);
+      break;
+    }
     case Opcode::AllocADT: {
       // Number of fields = 3 + instr.num_fields
       fields.assign({instr.constructor_tag, instr.num_fields, instr.dst});
@@ -521,118 +541,145 @@ void Executable::LoadPrimitiveOpNames(dmlc::Stream* strm) {
   }
 }
 
-// Extract the `cnt` number of fields started at `start` from the list
-// `instr_fields`.
-inline std::vector<Index> ExtractFields(const std::vector<Index>& instr_fields,
-                                        Index start,
-                                        Index cnt) {
-  CHECK_LE(static_cast<size_t>(start + cnt), instr_fields.size());
-  std::vector<Index> ret;
-  for (auto i = start; i < start + cnt; i++) {
-    ret.push_back(instr_fields[i]);
-  }
-  return ret;
+// Extract the `cnt` number of fields started at `start` from the
+// `num_operands` fields of an instruction into `scratch`, which is reused
+// across instructions.
+inline const std::vector<Index>& ExtractFields(const Index* operands,
+                                               size_t num_operands,
+                                               Index start,
+                                               Index cnt,
+                                               std::vector<Index>* scratch) {
+  CHECK_LE(static_cast<size_t>(start + cnt), num_operands);
+  scratch->assign(operands + start, operands + start + cnt);
+  return *scratch;
 }
 
-Instruction DeserializeInstruction(const VMInstructionSerializer& instr) {
-  Opcode opcode = static_cast<Opcode>(instr.opcode);
+Instruction DecodeInstruction(Index op, const Index* operands, size_t num_operands,
+                              std::vector<Index>* scratch) {
+  Opcode opcode = static_cast<Opcode>(op);
   switch (opcode) {
     case Opcode::Move: {
       // Number of fields = 2
-      DCHECK_EQ(instr.fields.size(), 2U);
-      return Instruction::Move(instr.fields[0], instr.fields[1]);
+      DCHECK_EQ(num_operands, 2U);
+      return Instruction::Move(operands[0], operands[1]);
     }
     case Opcode::Ret: {
       // Number of fields = 1
-      DCHECK_EQ(instr.fields.size(), 1U);
-      return Instruction::Ret(instr.fields[0]);
+      DCHECK_EQ(num_operands, 1U);
+      return Instruction::Ret(operands[0]);
     }
     case Opcode::Fatal: {
       // Number of fields = 0
-      DCHECK(instr.fields.empty());
+      DCHECK(num_operands == 0);
       return Instruction::Fatal();
     }
     case Opcode::InvokePacked: {
       // Number of fields = 3 + instr.arity
-      DCHECK_GE(instr.fields.size(), 3U);
-      DCHECK_EQ(instr.fields.size(), 3U + static_cast<size_t>(instr.fields[1]));
-
-      Index packed_index = instr.fields[0];
-      Index arity = instr.fields[1];
-      Index output_size = instr.fields[2];
-      std::vector<RegName> args = ExtractFields(instr.fields, 3, arity);
+      DCHECK_GE(num_operands, 3U);
+      DCHECK_EQ(num_operands, 3U + static_cast<size_t>(operands[1]));
+
+      Index packed_index = operands[0];
+      Index arity = operands[1];
+      Index output_size = operands[2];
+      const std::vector<RegName>& args =
+          ExtractFields(operands, num_operands, 3, arity, scratch);
       return Instruction::InvokePacked(packed_index, arity, output_size, args);
     }
     case Opcode::AllocTensor: {
       // Number of fields = 6 + instr.alloc_tensor.ndim
-      DCHECK_GE(instr.fields.size(), 6U);
-      DCHECK_EQ(instr.fields.size(), 6U + static_cast<size_t>(instr.fields[4]));
+      DCHECK_GE(num_operands, 6U);
+      DCHECK_EQ(num_operands, 6U + static_cast<size_t>(operands[4]));
 
-      RegName storage_reg = instr.fields[0];
+      RegName storage_reg = operands[0];
 
       DLDataType dtype;
-      dtype.code = instr.fields[1];
-      dtype.bits = instr.fields[2];
-      dtype.lanes = instr.fields[3];
+      dtype.code = operands[1];
+      dtype.bits = operands[2];
+      dtype.lanes = operands[3];
 
-      Index ndim = instr.fields[4];
-      RegName dst = instr.fields[5];
+      Index ndim = operands[4];
+      RegName dst = operands[5];
 
-      std::vector<Index> shape = ExtractFields(instr.fields, 6, ndim);
+      const std::vector<Index>& shape =
+          ExtractFields(operands, num_operands, 6, ndim, scratch);
 
       return Instruction::AllocTensor(storage_reg, shape, dtype, dst);
     }
     case Opcode::AllocTensorReg: {
       // Number of fields = 5
-      DCHECK_EQ(instr.fields.size(), 6U);
+      DCHECK_EQ(num_operands, 6U);
 
-      RegName storage_reg = instr.fields[0];
-      Index shape_register = instr.fields[1];
+      RegName storage_reg = operands[0];
+      Index shape_register = operands[1];
 
       DLDataType dtype;
-      dtype.code = instr.fields[2];
-      dtype.bits = instr.fields[3];
-      dtype.lanes = instr.fields[4];
+      dtype.code = operands[2];
+      dtype.bits = operands[3];
+      dtype.lanes = operands[4];
 
-      RegName dst = instr.fields[5];
+      RegName dst = operands[5];
 
       return Instruction::AllocTensorReg(storage_reg, shape_register, dtype, dst);
     }
     case Opcode::AllocADT: {
       // Number of fields = 3 + instr.num_fields
-      DCHECK_GE(instr.fields.size(), 3U);
-      DCHECK_EQ(instr.fields.size(), 3U + static_cast<size_t>(instr.fields[1]));
+      DCHECK_GE(num_operands, 3U);
+      DCHECK_EQ(num_operands, 3U + static_cast<size_t>(operands[1]));
 
-      Index constructor_tag = instr.fields[0];
-      Index num_fields = instr.fields[1];
-      RegName dst = instr.fields[2];
-      std::vector<Index> fields = ExtractFields(instr.fields, 3, num_fields);
+      Index constructor_tag = operands[0];
+      Index num_fields = operands[1];
+      RegName dst = operands[2];
+      const std::vector<Index>& fields =
+          ExtractFields(operands, num_operands, 3, num_fields, scratch);
 
       return Instruction::AllocADT(constructor_tag, num_fields, fields, dst);
     }
     case Opcode::AllocClosure: {
       // Number of fields = 3 + instr.num_freevar
-      DCHECK_GE(instr.fields.size(), 3U);
-      DCHECK_EQ(instr.fields.size(), 3U + static_cast<size_t>(instr.fields[1]));
+      DCHECK_GE(num_operands, 3U);
+      DCHECK_EQ(num_operands, 3U + static_cast<size_t>(operands[1]));
 
-      Index clo_index = instr.fields[0];
-      Index num_freevar = instr.fields[1];
-      RegName dst = instr.fields[2];
-      std::vector<Index> free_vars = ExtractFields(instr.fields, 3, num_freevar);
+      Index clo_index = operands[0];
+      Index num_freevar = operands[1];
+      RegName dst = operands[2];
+      const std::vector<Index>& free_vars =
+          ExtractFields(operands, num_operands, 3, num_freevar, scratch);
 
       return Instruction::AllocClosure(clo_index, num_freevar, free_vars, dst);
     }
+    case Opcode::AllocStaticTensor: {
+      // Number of fields = 8 + instr.alloc_static_tensor.ndim
+      DCHECK_GE(num_operands, 8U);
+      DCHECK_EQ(num_operands, 8U + static_cast<size_t>(operands[6]));
+
+      Index slot = operands[0];
+      Index allocation_size = operands[1];
+      Index alignment = operands[2];
+
+      DLDataType dtype;
+      dtype.code = operands[3];
+      dtype.bits = operands[4];
+      dtype.lanes = operands[5];
+
+      Index ndim = operands[6];
+      RegName dst = operands[7];
+
+      const std::vector<Index>& shape =
+          ExtractFields(operands, num_operands, 8, ndim, scratch);
+
+      return Instruction::AllocStaticTensor(slot, allocation_size, alignment, shape, dtype, dst);
+    }
     case Opcode::AllocStorage: {
-      DCHECK_GE(instr.fields.size(), 6U);
-      Index allocation_size = instr.fields[0];
-      Index alignment = instr.fields[1];
+      DCHECK_GE(num_operands, 6U);
+      Index allocation_size = operands[0];
+      Index alignment = operands[1];
 
       DLDataType dtype;
-      dtype.code = instr.fields[2];
-      dtype.bits = instr.fields[3];
-      dtype.lanes = instr.fields[4];
+      dtype.code = operands[2];
+      dtype.bits = operands[3];
+      dtype.lanes = operands[4];
 
-      RegName dst = instr.fields[5];
+      RegName dst = operands[5];
 
       return Instruction::AllocStorage(
         allocation_size,
@@ -642,69 +689,76 @@ Instruction DeserializeInstruction(const VMInstructionSerializer& instr) {
     }
     case Opcode::If: {
       // Number of fields = 4
-      DCHECK_EQ(instr.fields.size(), 4U);
-      Index test = instr.fields[0];
-      Index target = instr.fields[1];
-      Index true_offset = instr.fields[2];
-      Index false_offset = instr.fields[3];
+      DCHECK_EQ(num_operands, 4U);
+      Index test = operands[0];
+      Index target = operands[1];
+      Index true_offset = operands[2];
+      Index false_offset = operands[3];
 
       return Instruction::If(test, target, true_offset, false_offset);
     }
     case Opcode::Invoke: {
       // Number of fields = 3 + instr.num_args
-      DCHECK_GE(instr.fields.size(), 3U);
-      DCHECK_EQ(instr.fields.size(), 3U + static_cast<size_t>(instr.fields[1]));
+      DCHECK_GE(num_operands, 3U);
+      DCHECK_EQ(num_operands, 3U + static_cast<size_t>(operands[1]));
 
-      Index func_index = instr.fields[0];
-      Index num_args = instr.fields[1];
-      RegName dst = instr.fields[2];
-      std::vector<Index> args = ExtractFields(instr.fields, 3, num_args);
+      Index func_index = operands[0];
+      Index num_args = operands[1];
+      RegName dst = operands[2];
+      const std::vector<Index>& args =
+          ExtractFields(operands, num_operands, 3, num_args, scratch);
 
       return Instruction::Invoke(func_index, args, dst);
     }
     case Opcode::InvokeClosure: {
       // Number of fields = 3 + instr.num_closure_args
-      DCHECK_GE(instr.fields.size(), 3U);
-      DCHECK_EQ(instr.fields.size(), 3U + static_cast<size_t>(instr.fields[1]));
+      DCHECK_GE(num_operands, 3U);
+      DCHECK_EQ(num_operands, 3U + static_cast<size_t>(operands[1]));
 
-      Index closure = instr.fields[0];
-      Index num_closure_args = instr.fields[1];
-      RegName dst = instr.fields[2];
-      std::vector<Index> args = ExtractFields(instr.fields, 3, num_closure_args);
+      Index closure = operands[0];
+      Index num_closure_args = operands[1];
+      RegName dst = operands[2];
+      const std::vector<Index>& args =
+          ExtractFields(operands, num_operands, 3, num_closure_args, scratch);
 
       return Instruction::InvokeClosure(closure, args, dst);
     }
     case Opcode::LoadConst: {
       // Number of fields = 2
-      DCHECK_EQ(instr.fields.size(), 2U);
-      return Instruction::LoadConst(instr.fields[0], instr.fields[1]);
+      DCHECK_EQ(num_operands, 2U);
+      return Instruction::LoadConst(operands[0], operands[1]);
     }
     case Opcode::LoadConsti: {
       // Number of fields = 2
-      DCHECK_EQ(instr.fields.size(), 2U);
-      return Instruction::LoadConsti(instr.fields[0], instr.fields[1]);
+      DCHECK_EQ(num_operands, 2U);
+      return Instruction::LoadConsti(operands[0], operands[1]);
     }
     case Opcode::GetField: {
       // Number of fields = 3
-      DCHECK_EQ(instr.fields.size(), 3U);
-      return Instruction::GetField(instr.fields[0], instr.fields[1], instr.fields[2]);
+      DCHECK_EQ(num_operands, 3U);
+      return Instruction::GetField(operands[0], operands[1], operands[2]);
     }
     case Opcode::GetTag: {
       // Number of fields = 2
-      DCHECK_EQ(instr.fields.size(), 2U);
-      return Instruction::GetTag(instr.fields[0], instr.fields[1]);
+      DCHECK_EQ(num_operands, 2U);
+      return Instruction::GetTag(operands[0], operands[1]);
     }
     case Opcode::Goto: {
       // Number of fields = 1
-      DCHECK_EQ(instr.fields.size(), 1U);
-      return Instruction::Goto(instr.fields[0]);
+      DCHECK_EQ(num_operands, 1U);
+      return Instruction::Goto(operands[0]);
     }
     default:
-      LOG(FATAL) << "Invalid opcode" << instr.opcode;
+      LOG(FATAL) << "Invalid opcode" << op;
       return Instruction();
   }
 }
 
+Instruction DeserializeInstruction(const VMInstructionSerializer& instr) {
+  std::vector<Index> scratch;
+  return DecodeInstruction(instr.opcode, instr.fields.data(), instr.fields.size(), &scratch);
+}
+
 void Executable::LoadCodeSection(dmlc::Stream* strm) {
   // Load the number of functions.
   uint64_t sz;
@@ -738,6 +792,218 @@ void Executable::LoadCodeSection(dmlc::Stream* strm) {
   }
 }
 
+ObjectRef Executable::GetConstant(Index index) const {
+  if (mapped_file_ == nullptr) {
+    CHECK_LT(static_cast<size_t>(index), constants.size());
+    return constants[index];
+  }
+  CHECK_LT(static_cast<size_t>(index), mapped_constants_.size());
+  const auto& constant = mapped_constants_[index];
+  // The kernels assume the arguments are aligned.
+  if (reinterpret_cast<uintptr_t>(constant.data) % kAllocAlignment == 0) {
+    return CreateMappedArray(mapped_file_, constant.data, constant.shape, constant.dtype);
+  }
+  NDArray arr = NDArray::Empty(constant.shape, constant.dtype, DLContext{kDLCPU, 0});
+  arr.CopyFromBytes(constant.data, constant.nbytes);
+  return arr;
+}
+
+size_t Executable::NumConstants() const {
+  return mapped_file_ == nullptr ? constants.size() : mapped_constants_.size();
+}
+
+TVMByteArray Executable::SaveMapped() {
+  CHECK(DMLC_IO_NO_ENDIAN_SWAP)
+      << "The mapped VM executable is only supported on little endian hosts";
+  std::vector<std::string> sections(kVMMappedNumSections);
+  {
+    dmlc::MemoryStringStream strm(&sections[kVMMappedGlobal]);
+    SaveGlobalSection(&strm);
+  }
+  {
+    dmlc::MemoryStringStream strm(&sections[kVMMappedPrimitive]);
+    SavePrimitiveOpNames(&strm);
+  }
+  {
+    // Each function is followed by its instructions as one array of
+    // opcode, number of operands, operands.
+    dmlc::MemoryStringStream strm(&sections[kVMMappedCode]);
+    strm.Write(static_cast<uint64_t>(functions.size()));
+    std::vector<Index> words;
+    for (const auto& func : functions) {
+      words.clear();
+      for (const auto& instr : func.instructions) {
+        const auto& serialized_instr = SerializeInstruction(instr);
+        words.push_back(serialized_instr.opcode);
+        words.push_back(static_cast<Index>(serialized_instr.fields.size()));
+        words.insert(words.end(), serialized_instr.fields.begin(),
+                     serialized_instr.fields.end());
+      }
+      strm.Write(func.name);
+      strm.Write(func.params);
+      strm.Write(func.register_file_size);
+      strm.Write(static_cast<uint64_t>(func.instructions.size()));
+      strm.Write(static_cast<uint64_t>(words.size()));
+      strm.Write(words.data(), words.size() * sizeof(Index));
+    }
+  }
+  {
+    // The index of the constants, their data is aligned in the next section.
+    dmlc::MemoryStringStream index(&sections[kVMMappedConstantIndex]);
+    std::string& data = sections[kVMMappedConstantData];
+    index.Write(static_cast<uint64_t>(NumConstants()));
+    for (size_t i = 0; i < NumConstants(); ++i) {
+      const auto arr = Downcast<NDArray>(GetConstant(i));
+      const DLTensor* tensor = arr.operator->();
+      uint64_t offset = (data.size() + kTVMVMMappedAlignment - 1) /
+          kTVMVMMappedAlignment * kTVMVMMappedAlignment;
+      uint64_t nbytes = GetDataSize(*tensor);
+      index.Write(tensor->dtype);
+      index.Write(tensor->ndim);
+      index.WriteArray(tensor->shape, tensor->ndim);
+      index.Write(offset);
+      index.Write(nbytes);
+      data.resize(offset + nbytes, 0);
+      if (nbytes != 0) {
+        CHECK_EQ(TVMArrayCopyToBytes(const_cast<DLTensor*>(tensor), &data[offset], nbytes), 0)
+            << TVMGetLastError();
+      }
+    }
+  }
+
+  // The header does not depend on the offsets, measure it first.
+  auto save_header = [](dmlc::Stream* strm, const std::vector<uint64_t>& table) {
+    strm->Write(kTVMVMMappedBytecodeMagic);
+    strm->Write(kTVMVMMappedFormatVersion);
+    strm->Write(std::string(TVM_VERSION));
+    strm->Write(table);
+  };
+  auto align = [](uint64_t offset) {
+    return (offset + kTVMVMMappedAlignment - 1) / kTVMVMMappedAlignment * kTVMVMMappedAlignment;
+  };
+  std::vector<uint64_t> table(kVMMappedNumSections * 2, 0);
+  code_.clear();
+  {
+    dmlc::MemoryStringStream strm(&code_);
+    save_header(&strm, table);
+  }
+  uint64_t offset = code_.size();
+  for (size_t i = 0; i < sections.size(); ++i) {
+    table[i * 2] = align(offset);
+    table[i * 2 + 1] = sections[i].size();
+    offset = table[i * 2] + sections[i].size();
+  }
+  code_.clear();
+  {
+    dmlc::MemoryStringStream strm(&code_);
+    save_header(&strm, table);
+  }
+  code_.resize(offset, 0);
+  for (size_t i = 0; i < sections.size(); ++i) {
+    std::copy(sections[i].begin(), sections[i].end(), code_.begin() + table[i * 2]);
+  }
+
+  TVMByteArray arr;
+  arr.data = code_.c_str();
+  arr.size = code_.length();
+  return arr;
+}
+
+runtime::Module Executable::LoadMapped(const std::string& file_name, const runtime::Module lib) {
+  auto exec = make_object<Executable>();
+  exec->lib = lib;
+  auto file = std::make_shared<MappedFile>(file_name);
+  exec->mapped_file_ = file;
+
+  dmlc::MemoryFixedSizeStream header(file->data(), file->size());
+  uint64_t magic, format_version;
+  STREAM_CHECK(header.Read(&magic), "header");
+  STREAM_CHECK(magic == kTVMVMMappedBytecodeMagic, "header");
+  STREAM_CHECK(header.Read(&format_version), "header");
+  CHECK_EQ(format_version, kTVMVMMappedFormatVersion)
+      << "Unsupported mapped VM file format version " << format_version;
+  std::string version;
+  STREAM_CHECK(header.Read(&version), "version");
+  STREAM_CHECK(version == TVM_VERSION, "version");
+  std::vector<uint64_t> table;
+  STREAM_CHECK(header.Read(&table), "header");
+  STREAM_CHECK(table.size() == kVMMappedNumSections * 2, "header");
+  for (size_t i = 0; i < kVMMappedNumSections; ++i) {
+    STREAM_CHECK(table[i * 2] + table[i * 2 + 1] <= file->size(), "header");
+  }
+  auto section_data = [&file, &table](VMMappedSection kind) {
+    return file->data() + table[kind * 2];
+  };
+  auto section_size = [&table](VMMappedSection kind) {
+    return static_cast<size_t>(table[kind * 2 + 1]);
+  };
+
+  {
+    dmlc::MemoryFixedSizeStream strm(section_data(kVMMappedGlobal),
+                                     section_size(kVMMappedGlobal));
+    exec->LoadGlobalSection(&strm);
+  }
+  {
+    dmlc::MemoryFixedSizeStream strm(section_data(kVMMappedPrimitive),
+                                     section_size(kVMMappedPrimitive));
+    exec->LoadPrimitiveOpNames(&strm);
+  }
+  {
+    dmlc::MemoryFixedSizeStream strm(section_data(kVMMappedCode),
+                                     section_size(kVMMappedCode));
+    uint64_t num_funcs;
+    STREAM_CHECK(strm.Read(&num_funcs), "code");
+    exec->functions.resize(num_funcs);
+    // The buffers are reused across functions and instructions.
+    std::vector<Index> words;
+    std::vector<Index> scratch;
+    for (auto& func : exec->functions) {
+      uint64_t num_instructions, num_words;
+      STREAM_CHECK(strm.Read(&func.name), "code/function");
+      STREAM_CHECK(strm.Read(&func.params), "code/function");
+      STREAM_CHECK(strm.Read(&func.register_file_size), "code/function");
+      STREAM_CHECK(strm.Read(&num_instructions), "code/function");
+      STREAM_CHECK(strm.Read(&num_words), "code/function");
+      words.resize(num_words);
+      STREAM_CHECK(strm.Read(words.data(), num_words * sizeof(Index)) ==
+                   num_words * sizeof(Index), "code/instruction");
+      func.instructions.reserve(num_instructions);
+      size_t pos = 0;
+      for (uint64_t i = 0; i < num_instructions; ++i) {
+        STREAM_CHECK(pos + 2 <= words.size(), "code/instruction");
+        Index opcode = words[pos];
+        size_t num_operands = static_cast<size_t>(words[pos + 1]);
+        STREAM_CHECK(pos + 2 + num_operands <= words.size(), "code/instruction");
+        func.instructions.emplace_back(
+            DecodeInstruction(opcode, &words[pos + 2], num_operands, &scratch));
+        pos += 2 + num_operands;
+      }
+      STREAM_CHECK(pos == words.size(), "code/instruction");
+    }
+  }
+  {
+    dmlc::MemoryFixedSizeStream strm(section_data(kVMMappedConstantIndex),
+                                     section_size(kVMMappedConstantIndex));
+    char* data = section_data(kVMMappedConstantData);
+    uint64_t data_size = section_size(kVMMappedConstantData);
+    uint64_t num_constants;
+    STREAM_CHECK(strm.Read(&num_constants), "constant");
+    exec->mapped_constants_.resize(num_constants);
+    for (auto& constant : exec->mapped_constants_) {
+      int ndim;
+      uint64_t offset;
+      STREAM_CHECK(strm.Read(&constant.dtype) && strm.Read(&ndim), "constant");
+      STREAM_CHECK(ndim >= 0, "constant");
+      constant.shape.resize(ndim);
+      STREAM_CHECK(strm.ReadArray(constant.shape.data(), ndim), "constant");
+      STREAM_CHECK(strm.Read(&offset) && strm.Read(&constant.nbytes), "constant");
+      STREAM_CHECK(offset + constant.nbytes <= data_size, "constant");
+      constant.data = data + offset;
+    }
+  }
+  return runtime::Module(exec);
+}
+
 TVM_REGISTER_GLOBAL("runtime.GetNumOfGlobals")
 .set_body([](TVMArgs args, TVMRetValue* rv) {
   runtime::Module mod = args[0];
@@ -796,6 +1062,13 @@ TVM_REGISTER_GLOBAL("runtime.Load_Executable")
   return Executable::Load(code, lib);
 });
 
+TVM_REGISTER_GLOBAL("runtime.Load_MappedExecutable")
+.set_body_typed([](
+    std::string file_name,
+    runtime::Module lib) {
+  return Executable::LoadMapped(file_name, lib);
+});
+
 }  // namespace vm
 }  // namespace runtime
 }  // namespace tvm
@@ -21,9 +21,12 @@
  * \file tvm/runtime/vm/memory_manager.cc
  * \brief Allocate and manage memory for the runtime.
  */
+#include <tvm/runtime/registry.h>
 #include <utility>
 #include <memory>
+#include <string>
 #include "memory_manager.h"
+#include "best_fit_allocator.h"
 #include "naive_allocator.h"
 #include "pooled_allocator.h"
 
@@ -114,6 +117,19 @@ Allocator* MemoryManager::GetAllocator(TVMContext ctx) {
   return allocators_.at(ctx).get();
 }
 
+void MemoryManager::SetAllocator(TVMContext ctx, std::unique_ptr<Allocator> alloc) {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto it = allocators_.find(ctx);
+  if (it == allocators_.end()) {
+    allocators_.emplace(ctx, std::move(alloc));
+    return;
+  }
+  CHECK_EQ(it->second->UsedMemory(), 0U)
+      << "The allocator of " << DeviceName(ctx.device_type) << "(" << ctx.device_id
+      << ") still has live buffers";
+  it->second = std::move(alloc);
+}
+
 NDArray Allocator::Empty(std::vector<int64_t> shape, DLDataType dtype, DLContext ctx) {
   VerifyDataType(dtype);
   NDArray::Container* container = new NDArray::Container(nullptr, shape, dtype, ctx);
@@ -127,6 +143,61 @@ NDArray Allocator::Empty(std::vector<int64_t> shape, DLDataType dtype, DLContext
   return NDArray(GetObjectPtr<Object>(container));
 }
 
+std::unique_ptr<Allocator> MakeAllocator(TVMContext ctx,
+                                         const std::string& kind,
+                                         size_t arena_size,
+                                         size_t high_water,
+                                         const std::string& release) {
+  std::unique_ptr<Allocator> alloc;
+  if (kind == "naive") {
+    alloc.reset(new NaiveAllocator(ctx));
+  } else if (kind == "pooled") {
+    alloc.reset(new PooledAllocator(ctx));
+  } else if (kind == "best_fit") {
+    CHECK(ctx.device_type == kDLCPU || ctx.device_type == kDLGPU ||
+          ctx.device_type == kDLCPUPinned || ctx.device_type == kDLROCM)
+        << "best_fit allocator needs flat device pointers, not supported on "
+        << DeviceName(ctx.device_type);
+    BestFitAllocator::ReleasePolicy policy = BestFitAllocator::kHighWater;
+    if (release == "keep") {
+      policy = BestFitAllocator::kKeep;
+    } else if (release == "high_water") {
+      policy = BestFitAllocator::kHighWater;
+    } else if (release == "eager") {
+      policy = BestFitAllocator::kEager;
+    } else {
+      LOG(FATAL) << "Unknown release policy " << release;
+    }
+    alloc.reset(new BestFitAllocator(ctx, arena_size, high_water, policy));
+  } else {
+    LOG(FATAL) << "Unknown allocator " << kind;
+  }
+  return alloc;
+}
+
+TVM_REGISTER_GLOBAL("runtime.SetVMAllocator")
+.set_body([](TVMArgs args, TVMRetValue* rv) {
+    TVMContext ctx;
+    ctx.device_type = static_cast<DLDeviceType>(args[0].operator int());
+    ctx.device_id = args[1];
+    std::string kind = args[2];
+    int64_t arena_size = args[3];
+    int64_t high_water = args[4];
+    std::string release = args[5];
+    MemoryManager::Global()->SetAllocator(
+        ctx, MakeAllocator(ctx, kind, static_cast<size_t>(arena_size),
+                           static_cast<size_t>(high_water), release));
+});
+
+TVM_REGISTER_GLOBAL("runtime.GetVMAllocatorMemory")
+.set_body_typed([](int device_type, int device_id, bool reserved) {
+    TVMContext ctx;
+    ctx.device_type = static_cast<DLDeviceType>(device_type);
+    ctx.device_id = device_id;
+    Allocator* alloc = MemoryManager::Global()->GetAllocator(ctx);
+    return static_cast<int64_t>(reserved ? alloc->ReservedMemory() : alloc->UsedMemory());
+});
+
 }  // namespace vm
 }  // namespace runtime
 }  // namespace tvm
@@ -30,6 +30,7 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -91,6 +92,10 @@ class Allocator {
    *  \return The amount of memory currently allocated.
    */
   virtual size_t UsedMemory() const = 0;
+  /*! \brief The amount of memory held from the device, including cached blocks.
+   *  \return The amount of memory held from the device.
+   */
+  virtual size_t ReservedMemory() const { return UsedMemory(); }
   virtual ~Allocator() = default;
 };
 
@@ -98,7 +103,19 @@ class MemoryManager {
  public:
   static MemoryManager* Global();
 
+  /*! \brief Get the allocator of a context, a NaiveAllocator unless one was set.
+   *  \param ctx The context of the allocations.
+   *  \return The allocator.
+   */
   Allocator* GetAllocator(TVMContext ctx);
+  /*! \brief Select the allocator of a context.
+   *
+   *  Buffers are returned to the allocator of their context, so the current
+   *  allocator, if any, must not have live buffers.
+   *  \param ctx The context of the allocations.
+   *  \param alloc The allocator.
+   */
+  void SetAllocator(TVMContext ctx, std::unique_ptr<Allocator> alloc);
 
  private:
   MemoryManager() {}
@@ -108,11 +125,31 @@ class MemoryManager {
   std::unordered_map<TVMContext, std::unique_ptr<Allocator> > allocators_;
 };
 
+/*!
+ * \brief Create an allocator.
+ * \param ctx The context of the allocations.
+ * \param kind "naive", "pooled" or "best_fit".
+ * \param arena_size The minimum size of the arenas, for best_fit.
+ * \param high_water The reserved bytes above which free arenas are released, for best_fit.
+ * \param release When free arenas are released, for best_fit: "keep", "high_water" or "eager".
+ * \return The allocator.
+ */
+std::unique_ptr<Allocator> MakeAllocator(TVMContext ctx,
+                                         const std::string& kind,
+                                         size_t arena_size = 0,
+                                         size_t high_water = 0,
+                                         const std::string& release = "high_water");
+
 /*! \brief An object representing a storage allocation. */
 class StorageObj : public Object {
  public:
   /*! \brief The index into the VM function table. */
   Buffer buffer;
+  /*!
+   * \brief The allocator the buffer is returned to, the global allocator
+   *  of the context if not set. It is kept alive by its storages.
+   */
+  std::shared_ptr<Allocator> allocator;
 
   /*! \brief Allocate an NDArray from a given piece of storage. */
   NDArray AllocNDArray(size_t offset,
@@ -123,8 +160,11 @@ class StorageObj : public Object {
   static void Deleter(Object* ptr);
 
   ~StorageObj() {
-    auto alloc = MemoryManager::Global()->GetAllocator(buffer.ctx);
-    alloc->Free(buffer);
+    if (allocator) {
+      allocator->Free(buffer);
+    } else {
+      MemoryManager::Global()->GetAllocator(buffer.ctx)->Free(buffer);
+    }
   }
 
   static constexpr const uint32_t _type_index = TypeIndex::kDynamic;
@@ -39,6 +39,25 @@ namespace vm {
 /*! \brief The magic number for the serialized VM bytecode file  */
 constexpr uint64_t kTVMVMBytecodeMagic = 0xD225DE2F4214151D;
 
+/*! \brief The magic number for the mapped VM bytecode file  */
+constexpr uint64_t kTVMVMMappedBytecodeMagic = 0xD225DE2F4214151E;
+
+/*! \brief The version of the mapped VM bytecode format */
+constexpr uint64_t kTVMVMMappedFormatVersion = 1;
+
+/*! \brief The alignment of the sections and constants of the mapped file */
+constexpr uint64_t kTVMVMMappedAlignment = 64;
+
+/*! \brief The sections of the mapped VM bytecode file, in order. */
+enum VMMappedSection : uint64_t {
+  kVMMappedGlobal = 0,
+  kVMMappedPrimitive = 1,
+  kVMMappedCode = 2,
+  kVMMappedConstantIndex = 3,
+  kVMMappedConstantData = 4,
+  kVMMappedNumSections = 5,
+};
+
 template <typename T>
 static inline size_t VectorHash(size_t key, const std::vector<T>& values) {
   for (const auto& it : values) {
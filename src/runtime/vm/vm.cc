@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -52,9 +53,17 @@ VMClosure::VMClosure(size_t func_index, std::vector<ObjectRef> free_vars) {
   data_ = std::move(ptr);
 }
 
-inline Storage make_storage(size_t size, size_t alignment, DLDataType dtype_hint, TVMContext ctx) {
-  // We could put cache in here, from ctx to storage allocator.
+/*! \brief The storages kept by the VM for each static storage slot. */
+constexpr size_t kMaxStaticStoragePerSlot = 4;
+
+inline Storage make_storage(size_t size, size_t alignment, DLDataType dtype_hint, TVMContext ctx,
+                            const std::shared_ptr<Allocator>& allocator) {
   auto storage_obj = SimpleObjAllocator().make_object<StorageObj>();
+  if (allocator) {
+    storage_obj->buffer = allocator->Alloc(size, alignment, dtype_hint);
+    storage_obj->allocator = allocator;
+    return Storage(storage_obj);
+  }
   auto alloc = MemoryManager::Global()->GetAllocator(ctx);
   DCHECK(alloc != nullptr)
     << "allocator must not null";
@@ -71,6 +80,12 @@ static T* Duplicate(T* src, Index size) {
   return dst;
 }
 
+Instruction::Instruction(Instruction&& instr) noexcept {
+  // The operands are plain data, the arrays they point to change owner.
+  std::memcpy(static_cast<void*>(this), static_cast<const void*>(&instr), sizeof(Instruction));
+  instr.op = Opcode::Fatal;
+}
+
 Instruction::Instruction(const Instruction& instr) {
   this->op = instr.op;
   this->dst = instr.dst;
@@ -144,6 +159,11 @@ Instruction::Instruction(const Instruction& instr) {
     case Opcode::AllocStorage:
       this->alloc_storage = instr.alloc_storage;
       return;
+    case Opcode::AllocStaticTensor:
+      this->alloc_static_tensor = instr.alloc_static_tensor;
+      this->alloc_static_tensor.shape = Duplicate<int64_t>(instr.alloc_static_tensor.shape,
+                                                           instr.alloc_static_tensor.ndim);
+      return;
     default:
       std::ostringstream out;
       out << "Invalid instruction " << static_cast<int>(instr.op);
@@ -236,6 +256,11 @@ Instruction& Instruction::operator=(const Instruction& instr) {
     case Opcode::AllocStorage:
       this->alloc_storage = instr.alloc_storage;
       return *this;
+    case Opcode::AllocStaticTensor:
+      this->alloc_static_tensor = instr.alloc_static_tensor;
+      this->alloc_static_tensor.shape = Duplicate<int64_t>(instr.alloc_static_tensor.shape,
+                                                           instr.alloc_static_tensor.ndim);
+      return *this;
     default:
       std::ostringstream out;
       out << "Invalid instruction " << static_cast<int>(instr.op);
@@ -260,6 +285,9 @@ Instruction::~Instruction() {
     case Opcode::AllocTensor:
       delete this->alloc_tensor.shape;
       return;
+    case Opcode::AllocStaticTensor:
+      delete this->alloc_static_tensor.shape;
+      return;
     case Opcode::AllocADT:
       delete this->datatype_fields;
       return;
@@ -353,6 +381,27 @@ Instruction Instruction::AllocStorage(RegName size,
   return instr;
 }
 
+Instruction Instruction::AllocStaticTensor(Index slot,
+                                           Index allocation_size,
+                                           Index alignment,
+                                           const std::vector<int64_t>& shape,
+                                           DLDataType dtype,
+                                           Index dst) {
+  Instruction instr;
+  instr.op = Opcode::AllocStaticTensor;
+  instr.dst = dst;
+  instr.alloc_static_tensor.slot = slot;
+  instr.alloc_static_tensor.allocation_size = allocation_size;
+  instr.alloc_static_tensor.alignment = alignment;
+  instr.alloc_static_tensor.ndim = shape.size();
+  instr.alloc_static_tensor.shape = new int64_t[shape.size()];
+  for (size_t i = 0; i < shape.size(); ++i) {
+    instr.alloc_static_tensor.shape[i] = shape[i];
+  }
+  instr.alloc_static_tensor.dtype = dtype;
+  return instr;
+}
+
 Instruction Instruction::AllocADT(Index tag, Index num_fields,
                                        const std::vector<RegName>& datatype_fields, Index dst) {
   Instruction instr;
@@ -596,6 +645,17 @@ void InstructionPrint(std::ostream& os, const Instruction& instr) {
         DLDataType2String(instr.alloc_storage.dtype_hint);
       break;
     }
+    case Opcode::AllocStaticTensor: {
+      os << "alloc_static_tensor $" << instr.dst
+         << " slot(" << instr.alloc_static_tensor.slot << ") "
+         << instr.alloc_static_tensor.allocation_size << " "
+         << instr.alloc_static_tensor.alignment << " ["
+         << StrJoin<int64_t>(instr.alloc_static_tensor.shape, 0,
+                             instr.alloc_static_tensor.ndim)
+         << "] ";
+      DLDatatypePrint(os, instr.alloc_static_tensor.dtype);
+      break;
+    }
     default:
       LOG(FATAL) << "should never hit this case" << static_cast<int>(instr.op);
       break;
@@ -648,6 +708,41 @@ PackedFunc VirtualMachine::GetFunction(const std::string& name,
         *rv = Invoke(func, func_args);
       }
     });
+  } else if (name == "invoke_async") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      CHECK(exec_) << "The executable is not created yet.";
+      std::string func_name = args[0];
+      PackedFunc callback = args[1];
+      auto git = exec_->global_map.find(func_name);
+      CHECK(git != exec_->global_map.end())
+        << "Cannot find function " << func_name << " in the executable";
+      Index func_index = git->second;
+      // the inputs are taken now, they can be set again for the next call.
+      std::vector<ObjectRef> func_args;
+      if (!exec_->functions[func_index].params.empty()) {
+        auto it = inputs_.find(func_name);
+        CHECK(it != inputs_.end()) << "Input has not been set for function " << func_name;
+        func_args = it->second;
+      }
+      threading::RunAsync(this, [sptr_to_self, this, func_index, func_args, callback]() {
+        ObjectRef result;
+        std::string error;
+        try {
+          result = Invoke(exec_->functions[func_index], func_args);
+        } catch (const std::exception& e) {
+          error = e.what();
+        } catch (...) {
+          error = "invoke_async failed with an unknown exception";
+        }
+        try {
+          callback(result, error);
+        } catch (const std::exception& e) {
+          LOG(WARNING) << "invoke_async callback failed: " << e.what();
+        } catch (...) {
+          LOG(WARNING) << "invoke_async callback failed with an unknown exception";
+        }
+      });
+    });
   } else if (name == "init") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       CHECK_EQ(args.size() % 2, 0);
@@ -661,6 +756,36 @@ PackedFunc VirtualMachine::GetFunction(const std::string& name,
       }
       this->Init(contexts);
     });
+  } else if (name == "get_num_executed") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      *rv = static_cast<int64_t>(num_executed_);
+    });
+  } else if (name == "set_thread_pool") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::string pool_name = args[0];
+      thread_pool_ = threading::GetThreadPool(pool_name);
+    });
+  } else if (name == "set_allocator") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      CHECK(!ctxs_.empty()) << "The VM must be initialized before setting its allocator.";
+      std::string kind = args[0];
+      // the storages of the previous allocator return to it once released.
+      static_storage_.clear();
+      if (kind == "global") {
+        allocator_.reset();
+        return;
+      }
+      int64_t arena_size = args[1];
+      int64_t high_water = args[2];
+      std::string release = args[3];
+      allocator_ = MakeAllocator(ctxs_[0], kind, static_cast<size_t>(arena_size),
+                                 static_cast<size_t>(high_water), release);
+    });
+  } else if (name == "get_allocator_memory") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      CHECK(allocator_) << "The VM uses the global allocator of its context.";
+      *rv = static_cast<int64_t>(allocator_->UsedMemory());
+    });
   } else if (name == "set_input") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       CHECK(exec_) << "The executable is not created yet.";
@@ -703,8 +828,13 @@ TVMContext VirtualMachine::GetParamsContext() const {
 }
 
 void VirtualMachine::PushFrame(Index arg_count, Index ret_pc, const VMFunction& vm_func) {
-  auto frame = VMFrame(ret_pc, func_index_, arg_count, code_, vm_func.register_file_size);
-  frames_.push_back(frame);
+  Index base = frames_.empty() ? 0 :
+      frames_.back().register_base + frames_.back().register_file_size;
+  if (registers_.size() < static_cast<size_t>(base + vm_func.register_file_size)) {
+    registers_.resize(base + vm_func.register_file_size);
+  }
+  frames_.emplace_back(ret_pc, func_index_, arg_count, code_, base, vm_func.register_file_size);
+  frame_registers_ = registers_.data() + base;
 }
 
 Index VirtualMachine::PopFrame() {
@@ -713,8 +843,14 @@ Index VirtualMachine::PopFrame() {
   func_index_ = fr.func_index;
   code_ = fr.code;
   pc_ = fr.pc;
+  // release the objects, the registers are kept for the next calls.
+  for (Index i = 0; i < fr.register_file_size; ++i) {
+    frame_registers_[i] = ObjectRef();
+  }
   auto call_stack_size = frames_.size();
   frames_.pop_back();
+  frame_registers_ = frames_.empty() ? nullptr :
+      registers_.data() + frames_.back().register_base;
   return call_stack_size;
 }
 
@@ -734,11 +870,23 @@ void VirtualMachine::InvokeGlobal(const VMFunction& func, const std::vector<Obje
 ObjectRef VirtualMachine::Invoke(const VMFunction& func, const std::vector<ObjectRef>& args) {
   DLOG(INFO) << "Executing Function: " << std::endl << func;
 
+  threading::ThreadPoolScope scope(thread_pool_);
+  size_t num_frames = frames_.size();
   InvokeGlobal(func, args);
-  RunLoop();
+  try {
+    RunLoop();
+  } catch (...) {
+    // unwind the frames of the failed call so the VM can be invoked again.
+    while (frames_.size() > num_frames) {
+      PopFrame();
+    }
+    throw;
+  }
   // TODO(wweic) ctx could be obtained from the ctxs list.
-  auto alloc = MemoryManager::Global()->GetAllocator(ctxs_[0]);
-  DLOG(INFO) << "Memory used: " << alloc->UsedMemory() << " B";
+  DLOG(INFO) << "Memory used: "
+             << (allocator_ ? allocator_.get() : MemoryManager::Global()->GetAllocator(ctxs_[0]))
+                ->UsedMemory()
+             << " B";
   return return_register_;
 }
 
@@ -764,36 +912,38 @@ void VirtualMachine::InvokePacked(Index packed_index, const PackedFunc& func,
     }
   }
 
-  std::vector<TVMValue> values(arity);
-  std::vector<int> codes(arity);
-  runtime::TVMArgsSetter setter(values.data(), codes.data());
+  // The scratch buffers only grow, InvokePacked does not reenter the VM.
+  if (packed_values_.size() < arity) {
+    packed_values_.resize(arity);
+    packed_codes_.resize(arity);
+  }
+  runtime::TVMArgsSetter setter(packed_values_.data(), packed_codes_.data());
   int idx = 0;
   for (Index i = 0; i < arg_count; i++) {
     if (const auto* dt_cell = args[i].as<ADTObj>()) {
       for (size_t fi = 0; fi < dt_cell->size; ++fi) {
-        auto obj = (*dt_cell)[fi];
-        auto nd_array = Downcast<NDArray>(obj);
-        setter(idx++, nd_array);
+        setter(idx++, Downcast<NDArray>((*dt_cell)[fi]));
       }
     } else {
-      auto nd_array = Downcast<NDArray>(args[i]);
-      setter(idx++, nd_array);
+      setter(idx++, Downcast<NDArray>(args[i]));
     }
   }
 
   TVMRetValue rv;
-  func.CallPacked(TVMArgs(values.data(), codes.data(), arity), &rv);
+  func.CallPacked(TVMArgs(packed_values_.data(), packed_codes_.data(), arity), &rv);
 }
 
 void VirtualMachine::LoadExecutable(const Executable* exec) {
   CHECK(exec) << "The executable is not created yet.";
   exec_ = exec;
+  static_storage_.clear();
 
   runtime::Module lib = exec_->lib;
   // Get the list of packed functions.
   CHECK(exec->primitive_map.empty() || lib.operator->())
       << "runtime module should have been built for primitive functions"
       << "\n";
+  std::lock_guard<std::mutex> lock(exec_->lib_mutex);
   for (const auto& it : exec_->primitive_map) {
     const auto& packed_name = it.first;
     auto packed_index = static_cast<size_t>(it.second);
@@ -809,21 +959,30 @@ void VirtualMachine::LoadExecutable(const Executable* exec) {
 
 void VirtualMachine::Init(const std::vector<TVMContext>& ctxs) {
   ctxs_ = ctxs;
+  static_storage_.clear();
+  // the allocator is bound to the previous context.
+  allocator_.reset();
 }
 
 inline void VirtualMachine::WriteRegister(Index r, const ObjectRef& val) {
-  frames_.back().register_file[r] = val;
+  frame_registers_[r] = val;
+}
+
+inline void VirtualMachine::WriteRegister(Index r, ObjectRef&& val) {
+  frame_registers_[r] = std::move(val);
 }
 
-inline ObjectRef VirtualMachine::ReadRegister(Index r) const {
-  return frames_.back().register_file[r];
+inline const ObjectRef& VirtualMachine::ReadRegister(Index r) const {
+  return frame_registers_[r];
 }
 
 inline int32_t VirtualMachine::LoadScalarInt(Index r) const {
   int32_t result;
-  const auto& obj = ReadRegister(r);
-  auto nd_array = Downcast<NDArray>(obj);
-  NDArray array = nd_array.CopyTo({kDLCPU, 0});
+  NDArray array = Downcast<NDArray>(ReadRegister(r));
+  // the conditions usually live on the host already.
+  if (array->ctx.device_type != kDLCPU) {
+    array = array.CopyTo({kDLCPU, 0});
+  }
 
   if (array->dtype.bits <= 8) {
     result = reinterpret_cast<int8_t*>(array->data)[0];
@@ -843,6 +1002,7 @@ void VirtualMachine::RunLoop() {
   while (true) {
   main_loop:
     auto const& instr = code_[this->pc_];
+    ++num_executed_;
     DLOG(INFO) << "Executing(" << pc_ << "): " << instr;
 #if USE_RELAY_DEBUG
     InstructionPrint(std::cout, instr);
@@ -850,9 +1010,7 @@ void VirtualMachine::RunLoop() {
 
     switch (instr.op) {
       case Opcode::Move: {
-        ObjectRef from_obj;
-        from_obj = ReadRegister(instr.from);
-        WriteRegister(instr.dst, from_obj);
+        WriteRegister(instr.dst, ReadRegister(instr.from));
         pc_++;
         goto main_loop;
       }
@@ -860,7 +1018,6 @@ void VirtualMachine::RunLoop() {
         throw std::runtime_error("VM encountered fatal error");
       }
       case Opcode::LoadConst: {
-        auto constant_obj = exec_->constants[instr.const_index];
         // We cache the allocated object in the constant pool. To measure, the
         // first iteration will set the pool up. The other iterations will
         // directly reuse the allocated objects.
@@ -870,7 +1027,8 @@ void VirtualMachine::RunLoop() {
 
         if (!const_pool_[instr.const_index].defined()) {
           // TODO(wweic) ctx could be obtained from the ctxs list.
-          const_pool_[instr.const_index] = CopyTo(constant_obj, ctxs_[0]);
+          const_pool_[instr.const_index] =
+              CopyTo(exec_->GetConstant(instr.const_index), ctxs_[0]);
         }
         WriteRegister(instr.dst, const_pool_[instr.const_index]);
         pc_++;
@@ -884,59 +1042,68 @@ void VirtualMachine::RunLoop() {
         goto main_loop;
       }
       case Opcode::Invoke: {
-        std::vector<ObjectRef> args;
+        const VMFunction& func = exec_->functions[instr.func_index];
+        // The arguments are copied from the caller frame to the new one,
+        // which may move the register stack.
+        Index caller_base = frames_.back().register_base;
+        PushFrame(func.params.size(), pc_ + 1, func);
         for (Index i = 0; i < instr.num_args; ++i) {
-          args.push_back(ReadRegister(instr.invoke_args_registers[i]));
+          frame_registers_[i] = registers_[caller_base + instr.invoke_args_registers[i]];
         }
-        InvokeGlobal(exec_->functions[instr.func_index], args);
         frames_.back().caller_return_register = instr.dst;
+        code_ = func.instructions.data();
+        pc_ = 0;
         goto main_loop;
       }
       case Opcode::InvokePacked: {
         DLOG(INFO) << "InvokedPacked " << "arity=" << instr.arity;
         const auto& func = packed_funcs_[instr.packed_index];
         const auto& arity = instr.arity;
-        std::vector<ObjectRef> args;
+        packed_args_.clear();
         for (Index i = 0; i < arity; ++i) {
           DLOG(INFO) <<
             "arg" << i << " $" << instr.packed_args[i];
-          auto arg = ReadRegister(instr.packed_args[i]);
-          args.push_back(arg);
+          packed_args_.push_back(ReadRegister(instr.packed_args[i]));
         }
 
         // We no longer need to write the registers back, we write directly
         // through the registers mutably.
-        InvokePacked(instr.packed_index, func, arity, instr.output_size, args);
+        InvokePacked(instr.packed_index, func, arity, instr.output_size, packed_args_);
+        packed_args_.clear();
         pc_++;
         goto main_loop;
       }
       case Opcode::InvokeClosure: {
-        auto object = ReadRegister(instr.closure);
+        // Keep the closure alive, pushing the frame may move the register stack.
+        ObjectRef object = ReadRegister(instr.closure);
         const auto* closure = object.as<VMClosureObj>();
-
-        std::vector<ObjectRef> args;
-        for (auto free_var : closure->free_vars) {
-          args.push_back(free_var);
+        CHECK(closure) << "Expect a closure";
+        const VMFunction& func = exec_->functions[closure->func_index];
+        Index caller_base = frames_.back().register_base;
+        PushFrame(func.params.size(), pc_ + 1, func);
+        Index num_free_vars = closure->free_vars.size();
+        for (Index i = 0; i < num_free_vars; ++i) {
+          frame_registers_[i] = closure->free_vars[i];
         }
         for (Index i = 0; i < instr.num_closure_args; ++i) {
-          args.push_back(ReadRegister(instr.closure_args[i]));
+          frame_registers_[num_free_vars + i] = registers_[caller_base + instr.closure_args[i]];
         }
-        InvokeGlobal(exec_->functions[closure->func_index], args);
         frames_.back().caller_return_register = instr.dst;
+        code_ = func.instructions.data();
+        pc_ = 0;
         goto main_loop;
       }
       case Opcode::GetField: {
-        auto object = ReadRegister(instr.object);
-        const auto& tuple = Downcast<ADT>(object);
-        auto field = tuple[instr.field_index];
-        WriteRegister(instr.dst, field);
+        const auto* tuple = ReadRegister(instr.object).as<ADTObj>();
+        CHECK(tuple) << "Expect an ADT";
+        WriteRegister(instr.dst, (*tuple)[instr.field_index]);
         pc_++;
         goto main_loop;
       }
       case Opcode::GetTag: {
-        auto object = ReadRegister(instr.get_tag.object);
-        const auto& adt = Downcast<ADT>(object);
-        auto tag = adt.tag();
+        const auto* adt = ReadRegister(instr.get_tag.object).as<ADTObj>();
+        CHECK(adt) << "Expect an ADT";
+        auto tag = adt->tag;
         auto tag_tensor = NDArray::Empty({1}, {kDLInt, 32, 1}, {kDLCPU, 0});
         reinterpret_cast<int32_t*>(tag_tensor->data)[0] = tag;
         WriteRegister(instr.dst, tag_tensor);
@@ -968,11 +1135,8 @@ void VirtualMachine::RunLoop() {
           shape[i] = instr.alloc_tensor.shape[i];
         }
 
-        auto storage_obj = ReadRegister(instr.alloc_tensor.storage);
-        auto storage = Downcast<Storage>(storage_obj);
-        auto obj = storage->AllocNDArray(0, shape, instr.alloc_tensor.dtype);
-
-        WriteRegister(instr.dst, obj);
+        auto storage = Downcast<Storage>(ReadRegister(instr.alloc_tensor.storage));
+        WriteRegister(instr.dst, storage->AllocNDArray(0, shape, instr.alloc_tensor.dtype));
         pc_++;
         goto main_loop;
       }
@@ -980,9 +1144,11 @@ void VirtualMachine::RunLoop() {
         DLContext cpu_ctx;
         cpu_ctx.device_type = kDLCPU;
         cpu_ctx.device_id = 0;
-        auto shape_tensor_obj = ReadRegister(instr.alloc_tensor_reg.shape_register);
-        const auto shape_arr = Downcast<NDArray>(shape_tensor_obj);
-        NDArray shape_tensor = shape_arr.CopyTo(cpu_ctx);
+        NDArray shape_tensor = Downcast<NDArray>(
+            ReadRegister(instr.alloc_tensor_reg.shape_register));
+        if (shape_tensor->ctx.device_type != kDLCPU) {
+          shape_tensor = shape_tensor.CopyTo(cpu_ctx);
+        }
         const DLTensor* dl_tensor = shape_tensor.operator->();
         CHECK_EQ(dl_tensor->dtype.code, 0u);
         CHECK_LE(dl_tensor->dtype.bits, 64);
@@ -991,11 +1157,8 @@ void VirtualMachine::RunLoop() {
         auto shape = std::vector<int64_t>(num_dims);
         shape.assign(dims, dims + num_dims);
 
-        auto storage_obj = ReadRegister(instr.alloc_tensor_reg.storage);
-        auto storage = Downcast<Storage>(storage_obj);
-        auto obj = storage->AllocNDArray(0, shape, instr.alloc_tensor_reg.dtype);
-
-        WriteRegister(instr.dst, obj);
+        auto storage = Downcast<Storage>(ReadRegister(instr.alloc_tensor_reg.storage));
+        WriteRegister(instr.dst, storage->AllocNDArray(0, shape, instr.alloc_tensor_reg.dtype));
         pc_++;
         goto main_loop;
       }
@@ -1027,11 +1190,40 @@ void VirtualMachine::RunLoop() {
           "alignment=" << alignment <<
           "dtype_hint=" << DLDataType2String(instr.alloc_storage.dtype_hint);
 
-        auto storage = make_storage(size, alignment, instr.alloc_storage.dtype_hint, ctxs_[0]);
+        auto storage = make_storage(size, alignment, instr.alloc_storage.dtype_hint, ctxs_[0],
+                                    allocator_);
         WriteRegister(instr.dst, storage);
         pc_++;
         goto main_loop;
       }
+      case Opcode::AllocStaticTensor: {
+        const auto& op = instr.alloc_static_tensor;
+        if (static_storage_.size() <= static_cast<size_t>(op.slot)) {
+          static_storage_.resize(op.slot + 1);
+        }
+        // A storage only referred to by the slot has no live tensor.
+        auto& storages = static_storage_[op.slot];
+        ObjectRef storage_obj;
+        for (const auto& cached : storages) {
+          if (cached.unique()) {
+            storage_obj = cached;
+            break;
+          }
+        }
+        if (!storage_obj.defined()) {
+          storage_obj = make_storage(op.allocation_size, op.alignment, op.dtype, ctxs_[0],
+                                     allocator_);
+          // recursive calls hold one storage per frame, only keep a few.
+          if (storages.size() < kMaxStaticStoragePerSlot) {
+            storages.push_back(storage_obj);
+          }
+        }
+        auto storage = Downcast<Storage>(storage_obj);
+        std::vector<int64_t> shape(op.shape, op.shape + op.ndim);
+        WriteRegister(instr.dst, storage->AllocNDArray(0, shape, op.dtype));
+        pc_++;
+        goto main_loop;
+      }
       case Opcode::Ret: {
         // If we have hit the point from which we started
         // running, we should return to the caller breaking
@@ -18,10 +18,19 @@
  */
 
 /*!
- * \file workspace_pool.h
+ * \file workspace_pool.cc
  * \brief Workspace pool utility.
  */
+#include <dmlc/thread_local.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
 #include "workspace_pool.h"
 
 namespace tvm {
@@ -29,106 +38,204 @@ namespace runtime {
 
 // page size.
 constexpr size_t kWorkspacePageSize = 4 << 10;
+// number of size classes, covers every size_t.
+constexpr int kNumSizeClasses = 256;
+// a free block of a larger class is reused if it is at most this many classes up.
+constexpr int kMaxClassDistance = 4;
+
+/*! \brief Allocation counters of all the pools of one device type. */
+struct WorkspacePoolCounters {
+  std::atomic<uint64_t> num_allocs{0};
+  std::atomic<uint64_t> num_hits{0};
+  std::atomic<uint64_t> num_device_allocs{0};
+  std::atomic<uint64_t> num_reallocs{0};
+  std::atomic<int64_t> in_use_bytes{0};
+  std::atomic<int64_t> peak_in_use_bytes{0};
+  std::atomic<int64_t> reserved_bytes{0};
+  std::atomic<int64_t> peak_reserved_bytes{0};
+
+  static void UpdatePeak(std::atomic<int64_t>* peak, int64_t value) {
+    int64_t prev = peak->load(std::memory_order_relaxed);
+    while (prev < value &&
+           !peak->compare_exchange_weak(prev, value, std::memory_order_relaxed)) {}
+  }
+
+  void AddInUse(int64_t nbytes) {
+    int64_t value = in_use_bytes.fetch_add(nbytes, std::memory_order_relaxed) + nbytes;
+    if (nbytes > 0) UpdatePeak(&peak_in_use_bytes, value);
+  }
+
+  void AddReserved(int64_t nbytes) {
+    int64_t value = reserved_bytes.fetch_add(nbytes, std::memory_order_relaxed) + nbytes;
+    if (nbytes > 0) UpdatePeak(&peak_reserved_bytes, value);
+  }
+
+  std::string ToJSON() const {
+    uint64_t allocs = num_allocs.load(std::memory_order_relaxed);
+    uint64_t hits = num_hits.load(std::memory_order_relaxed);
+    std::ostringstream os;
+    os << "{\"allocs\": " << allocs
+       << ", \"hits\": " << hits
+       << ", \"hit_rate\": " << (allocs == 0 ? 0.0 : static_cast<double>(hits) / allocs)
+       << ", \"device_allocs\": " << num_device_allocs.load(std::memory_order_relaxed)
+       << ", \"reallocs\": " << num_reallocs.load(std::memory_order_relaxed)
+       << ", \"in_use_bytes\": " << in_use_bytes.load(std::memory_order_relaxed)
+       << ", \"peak_in_use_bytes\": " << peak_in_use_bytes.load(std::memory_order_relaxed)
+       << ", \"reserved_bytes\": " << reserved_bytes.load(std::memory_order_relaxed)
+       << ", \"peak_reserved_bytes\": " << peak_reserved_bytes.load(std::memory_order_relaxed)
+       << "}";
+    return os.str();
+  }
+
+  // The bytes in use and reserved are current state, only the history is reset.
+  void Reset() {
+    num_allocs.store(0, std::memory_order_relaxed);
+    num_hits.store(0, std::memory_order_relaxed);
+    num_device_allocs.store(0, std::memory_order_relaxed);
+    num_reallocs.store(0, std::memory_order_relaxed);
+    peak_in_use_bytes.store(in_use_bytes.load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+    peak_reserved_bytes.store(reserved_bytes.load(std::memory_order_relaxed),
+                              std::memory_order_relaxed);
+  }
+
+  static WorkspacePoolCounters* Get(int device_type) {
+    // Never destroyed, thread local pools may release memory after static destruction.
+    static std::mutex* mutex = new std::mutex();
+    static auto* counters =
+        new std::unordered_map<int, std::unique_ptr<WorkspacePoolCounters> >();
+    std::lock_guard<std::mutex> lock(*mutex);
+    std::unique_ptr<WorkspacePoolCounters>& ptr = (*counters)[device_type];
+    if (ptr == nullptr) ptr.reset(new WorkspacePoolCounters());
+    return ptr.get();
+  }
+};
 
 class WorkspacePool::Pool {
  public:
   // constructor
-  Pool() {
-    // safe guard header on each list.
-    Entry e;
-    e.data = nullptr;
-    e.size = 0;
-    free_list_.push_back(e);
-    allocated_.push_back(e);
-  }
+  explicit Pool(DLDeviceType device_type)
+      : counters_(WorkspacePoolCounters::Get(device_type)) {}
   // allocate from pool
   void* Alloc(TVMContext ctx, DeviceAPI* device, size_t nbytes) {
-    // Allocate align to page.
-    nbytes = (nbytes + (kWorkspacePageSize - 1)) / kWorkspacePageSize * kWorkspacePageSize;
-    if (nbytes == 0) nbytes = kWorkspacePageSize;
+    size_t pages = (nbytes + (kWorkspacePageSize - 1)) / kWorkspacePageSize;
+    if (pages == 0) pages = 1;
+    int cls = SizeClass(pages);
+    size_t size = ClassSize(cls);
+    counters_->num_allocs.fetch_add(1, std::memory_order_relaxed);
     Entry e;
-    DLDataType type;
-    type.code = kDLUInt;
-    type.bits = 8;
-    type.lanes = 1;
-    if (free_list_.size() == 2) {
-      e = free_list_.back();
-      free_list_.pop_back();
-      if (e.size < nbytes) {
-        // resize the page
-        device->FreeDataSpace(ctx, e.data);
-        e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
-        e.size = nbytes;
-      }
-    } else if (free_list_.size() == 1) {
-      e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
-      e.size = nbytes;
-    } else {
-      if (free_list_.back().size >= nbytes) {
-        // find smallest fit
-        auto it = free_list_.end() - 2;
-        for (; it->size >= nbytes; --it) {}
-        e = *(it + 1);
-        free_list_.erase(it + 1);
-      } else {
-        // resize the page
-        e = free_list_.back();
-        free_list_.pop_back();
-        device->FreeDataSpace(ctx, e.data);
-        e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
-        e.size = nbytes;
+    e.data = nullptr;
+    for (int i = cls; i < std::min(cls + kMaxClassDistance, kNumSizeClasses); ++i) {
+      if (!free_list_[i].empty()) {
+        e.data = free_list_[i].back();
+        e.size_class = i;
+        free_list_[i].pop_back();
+        free_bytes_ -= ClassSize(i);
+        counters_->num_hits.fetch_add(1, std::memory_order_relaxed);
+        break;
       }
     }
-    allocated_.push_back(e);
+    if (e.data == nullptr) {
+      this->Trim(ctx, device, size);
+      DLDataType type;
+      type.code = kDLUInt;
+      type.bits = 8;
+      type.lanes = 1;
+      e.data = device->AllocDataSpace(ctx, size, kTempAllocaAlignment, type);
+      e.size_class = cls;
+      counters_->num_device_allocs.fetch_add(1, std::memory_order_relaxed);
+      counters_->AddReserved(static_cast<int64_t>(size));
+    }
+    size_t used = ClassSize(e.size_class);
+    in_use_bytes_ += used;
+    peak_in_use_bytes_ = std::max(peak_in_use_bytes_, in_use_bytes_);
+    counters_->AddInUse(static_cast<int64_t>(used));
+    allocated_[e.data] = e.size_class;
     return e.data;
   }
   // free resource back to pool
   void Free(void* data) {
-    Entry e;
-    if (allocated_.back().data == data) {
-      // quick path, last allocated.
-      e = allocated_.back();
-      allocated_.pop_back();
-    } else {
-      int index = static_cast<int>(allocated_.size()) - 2;
-      for (; index > 0 && allocated_[index].data != data; --index) {}
-      CHECK_GT(index, 0) << "trying to free things that has not been allocated";
-      e = allocated_[index];
-      allocated_.erase(allocated_.begin() + index);
-    }
-    if (free_list_.back().size < e.size) {
-      free_list_.push_back(e);
-    } else if (free_list_.size() == 2) {
-      free_list_.push_back(free_list_.back());
-      free_list_[1] = e;
-    } else {
-      size_t i = free_list_.size() - 1;
-      free_list_.resize(free_list_.size() + 1);
-      for (; e.size < free_list_[i].size; --i) {
-        free_list_[i + 1] = free_list_[i];
-      }
-      free_list_[i + 1] = e;
-    }
+    auto it = allocated_.find(data);
+    CHECK(it != allocated_.end()) << "trying to free things that has not been allocated";
+    int cls = it->second;
+    allocated_.erase(it);
+    size_t size = ClassSize(cls);
+    free_list_[cls].push_back(data);
+    free_bytes_ += size;
+    in_use_bytes_ -= size;
+    counters_->AddInUse(-static_cast<int64_t>(size));
   }
   // Release all resources
   void Release(TVMContext ctx, DeviceAPI* device) {
-    CHECK_EQ(allocated_.size(), 1);
-    for (size_t i = 1; i < free_list_.size(); ++i) {
-      device->FreeDataSpace(ctx, free_list_[i].data);
+    CHECK_EQ(allocated_.size(), 0U);
+    for (int i = 0; i < kNumSizeClasses; ++i) {
+      for (void* data : free_list_[i]) {
+        device->FreeDataSpace(ctx, data);
+        counters_->AddReserved(-static_cast<int64_t>(ClassSize(i)));
+      }
+      free_list_[i].clear();
     }
-    free_list_.clear();
+    free_bytes_ = 0;
   }
 
  private:
   /*! \brief a single entry in the pool */
   struct Entry {
     void* data;
-    size_t size;
+    int size_class;
   };
-  /*! \brief List of free items, sorted from small to big size */
-  std::vector<Entry> free_list_;
-  /*! \brief List of allocated items */
-  std::vector<Entry> allocated_;
+  // Index of the smallest class holding the given number of pages.
+  // Up to 4 pages each page count is a class, above that there are four
+  // classes per power of two, so a block wastes at most a quarter of its size.
+  static int SizeClass(size_t pages) {
+    if (pages <= 4) return static_cast<int>(pages) - 1;
+    int k = Log2(pages - 1);
+    int sub = static_cast<int>((pages - 1) >> (k - 2));
+    return 4 * (k - 1) + (sub - 4);
+  }
+  // Bytes of the blocks of a class.
+  static size_t ClassSize(int cls) {
+    if (cls < 4) return static_cast<size_t>(cls + 1) * kWorkspacePageSize;
+    int k = cls / 4 + 1;
+    size_t sub = static_cast<size_t>(cls % 4 + 4);
+    return ((sub + 1) << (k - 2)) * kWorkspacePageSize;
+  }
+  // Floor of log2 of a positive value.
+  static int Log2(size_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(static_cast<unsigned long long>(value));  // NOLINT(*)
+#else
+    int k = 0;
+    while (value >>= 1) ++k;
+    return k;
+#endif
+  }
+  // Return cached blocks to the device when the pool holds more than twice
+  // its peak use, so workloads with growing sizes do not hoard memory.
+  void Trim(TVMContext ctx, DeviceAPI* device, size_t nbytes) {
+    size_t limit = 2 * std::max(peak_in_use_bytes_, in_use_bytes_ + nbytes);
+    for (int i = 0; i < kNumSizeClasses && in_use_bytes_ + free_bytes_ + nbytes > limit; ++i) {
+      while (!free_list_[i].empty() && in_use_bytes_ + free_bytes_ + nbytes > limit) {
+        device->FreeDataSpace(ctx, free_list_[i].back());
+        free_list_[i].pop_back();
+        free_bytes_ -= ClassSize(i);
+        counters_->AddReserved(-static_cast<int64_t>(ClassSize(i)));
+        counters_->num_reallocs.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+  /*! \brief Free blocks of each size class */
+  std::vector<void*> free_list_[kNumSizeClasses];
+  /*! \brief Size class of each allocated block */
+  std::unordered_map<void*, int> allocated_;
+  /*! \brief Bytes in the free lists */
+  size_t free_bytes_{0};
+  /*! \brief Bytes handed out */
+  size_t in_use_bytes_{0};
+  /*! \brief Peak of in_use_bytes_ */
+  size_t peak_in_use_bytes_{0};
+  /*! \brief Counters of the device type */
+  WorkspacePoolCounters* counters_;
 };
 
 WorkspacePool::WorkspacePool(DLDeviceType device_type, std::shared_ptr<DeviceAPI> device)
@@ -152,7 +259,7 @@ void* WorkspacePool::AllocWorkspace(TVMContext ctx, size_t size) {
     array_.resize(ctx.device_id + 1, nullptr);
   }
   if (array_[ctx.device_id] == nullptr) {
-    array_[ctx.device_id] = new Pool();
+    array_[ctx.device_id] = new Pool(device_type_);
   }
   return array_[ctx.device_id]->Alloc(ctx, device_.get(), size);
 }
@@ -163,5 +270,90 @@ void WorkspacePool::FreeWorkspace(TVMContext ctx, void* ptr) {
   array_[ctx.device_id]->Free(ptr);
 }
 
+WorkspaceArena::WorkspaceArena(TVMContext ctx, void* data, size_t size)
+    : ctx_(ctx), data_(static_cast<char*>(data)), size_(size) {}
+
+void* WorkspaceArena::Alloc(TVMContext ctx, size_t size) {
+  size_t nbytes = (size + kTempAllocaAlignment - 1) / kTempAllocaAlignment * kTempAllocaAlignment;
+  if (ctx.device_type != ctx_.device_type || ctx.device_id != ctx_.device_id ||
+      top_ + nbytes > size_) {
+    return nullptr;
+  }
+  Entry e;
+  e.ptr = data_ + top_;
+  e.size = nbytes;
+  e.in_arena = true;
+  e.live = true;
+  stack_.push_back(e);
+  top_ += nbytes;
+  demand_ += nbytes;
+  peak_ = std::max(peak_, demand_);
+  return e.ptr;
+}
+
+void WorkspaceArena::AddFallback(void* ptr, size_t size) {
+  Entry e;
+  e.ptr = ptr;
+  e.size = (size + kTempAllocaAlignment - 1) / kTempAllocaAlignment * kTempAllocaAlignment;
+  e.in_arena = false;
+  e.live = true;
+  stack_.push_back(e);
+  demand_ += e.size;
+  peak_ = std::max(peak_, demand_);
+}
+
+bool WorkspaceArena::Free(void* ptr) {
+  // workspaces are usually freed in reverse order, search from the top.
+  int index = static_cast<int>(stack_.size()) - 1;
+  for (; index >= 0 && !(stack_[index].live && stack_[index].ptr == ptr); --index) {}
+  if (index < 0) return false;
+  bool in_arena = stack_[index].in_arena;
+  stack_[index].live = false;
+  demand_ -= stack_[index].size;
+  while (!stack_.empty() && !stack_.back().live) {
+    stack_.pop_back();
+  }
+  top_ = 0;
+  for (int i = static_cast<int>(stack_.size()) - 1; i >= 0; --i) {
+    if (stack_[i].in_arena) {
+      top_ = static_cast<char*>(stack_[i].ptr) - data_ + stack_[i].size;
+      break;
+    }
+  }
+  return in_arena;
+}
+
+/*! \brief The arena bound to a thread. */
+struct WorkspaceArenaEntry {
+  WorkspaceArena* arena{nullptr};
+};
+
+static WorkspaceArena*& CurrentWorkspaceArena() {
+  return dmlc::ThreadLocalStore<WorkspaceArenaEntry>::Get()->arena;
+}
+
+WorkspaceArena* WorkspaceArena::Current() {
+  return CurrentWorkspaceArena();
+}
+
+WorkspaceArena::Scope::Scope(WorkspaceArena* arena)
+    : prev_(CurrentWorkspaceArena()), bound_(arena != nullptr) {
+  if (bound_) CurrentWorkspaceArena() = arena;
+}
+
+WorkspaceArena::Scope::~Scope() {
+  if (bound_) CurrentWorkspaceArena() = prev_;
+}
+
+TVM_REGISTER_GLOBAL("runtime.GetWorkspacePoolStats")
+.set_body_typed([](int device_type) {
+    return WorkspacePoolCounters::Get(device_type)->ToJSON();
+});
+
+TVM_REGISTER_GLOBAL("runtime.ResetWorkspacePoolStats")
+.set_body_typed([](int device_type) {
+    WorkspacePoolCounters::Get(device_type)->Reset();
+});
+
 }  // namespace runtime
 }  // namespace tvm
@@ -40,6 +40,11 @@ namespace runtime {
  *  - Only a few allocation will happen, and space will be released after use.
  *  - The release order is usually in reverse order of allocate
  *  - Repeative pattern of same allocations over different runs.
+ *
+ *  Blocks are cached in size classes, four per power of two, so allocation
+ *  and free are constant time and a block is reused by any request of its
+ *  class. Counters for each device type are available through the
+ *  runtime.GetWorkspacePoolStats global function.
  */
 class TVM_DLL WorkspacePool {
  public:
@@ -75,6 +80,80 @@ class TVM_DLL WorkspacePool {
   std::shared_ptr<DeviceAPI> device_;
 };
 
+/*!
+ * \brief A stack of workspaces carved from memory owned by the caller.
+ *
+ *  A runtime binds an arena to the current thread with Scope, and
+ *  TVMBackendAllocWorkspace then serves requests of the arena's context
+ *  from it, falling back to the WorkspacePool when it is full. The peak
+ *  demand, including the requests which did not fit, is recorded so the
+ *  caller can size the region after a first run.
+ */
+class TVM_DLL WorkspaceArena {
+ public:
+  /*!
+   * \brief Create an arena over a region.
+   * \param ctx The context of the region.
+   * \param data The start of the region, aligned to kTempAllocaAlignment.
+   * \param size The size of the region.
+   */
+  WorkspaceArena(TVMContext ctx, void* data, size_t size);
+  /*!
+   * \brief Allocate from the arena.
+   * \param ctx The context of allocation.
+   * \param size The size to be allocated.
+   * \return The workspace, nullptr when it does not fit or ctx differs.
+   */
+  void* Alloc(TVMContext ctx, size_t size);
+  /*!
+   * \brief Record a workspace which did not fit and came from the pool.
+   * \param ptr The workspace.
+   * \param size The size requested.
+   */
+  void AddFallback(void* ptr, size_t size);
+  /*!
+   * \brief Free a workspace.
+   * \param ptr The workspace from Alloc or AddFallback.
+   * \return Whether ptr is in the arena, otherwise it goes back to the pool.
+   */
+  bool Free(void* ptr);
+  /*! \return The peak bytes requested while the arena was bound. */
+  size_t peak_bytes() const { return peak_; }
+  /*! \return The arena bound to the current thread, or nullptr. */
+  static WorkspaceArena* Current();
+
+  /*! \brief RAII scope binding an arena to the current thread. */
+  class Scope {
+   public:
+    /*! \param arena The arena, nullptr keeps the current binding. */
+    explicit Scope(WorkspaceArena* arena);
+    ~Scope();
+
+   private:
+    WorkspaceArena* prev_;
+    bool bound_;
+  };
+
+ private:
+  /*! \brief a single workspace handed out */
+  struct Entry {
+    void* ptr;
+    size_t size;
+    bool in_arena;
+    bool live;
+  };
+  TVMContext ctx_;
+  char* data_;
+  size_t size_;
+  /*! \brief End of the last live workspace of the arena. */
+  size_t top_{0};
+  /*! \brief Bytes of the live workspaces, in or out of the arena. */
+  size_t demand_{0};
+  size_t peak_{0};
+  /*! \brief Workspaces in allocation order. */
+  std::vector<Entry> stack_;
+};
+
 }  // namespace runtime
 }  // namespace tvm
 #endif  // TVM_RUNTIME_WORKSPACE_POOL_H_
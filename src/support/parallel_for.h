@@ -0,0 +1,59 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file parallel_for.h
+ * \brief Parallel loops used by the compiler to build independent functions.
+ */
+#ifndef TVM_SUPPORT_PARALLEL_FOR_H_
+#define TVM_SUPPORT_PARALLEL_FOR_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace tvm {
+namespace support {
+
+/*!
+ * \brief The number of threads used to lower and generate code of independent functions.
+ *
+ *  Read from TVM_NUM_BUILD_THREADS on every call, the number of hardware
+ *  threads by default. 1 builds everything on the calling thread.
+ *
+ * \return The number of build threads, at least 1.
+ */
+int NumBuildThreads();
+
+/*!
+ * \brief Run f(i) for every i in [0, n) on up to NumBuildThreads() threads.
+ *
+ *  The calling thread takes part in the loop. The tasks are handed out one
+ *  at a time, so uneven tasks balance. Thread local state such as the current
+ *  target or build config is not propagated, the tasks set what they need.
+ *  When tasks throw, the remaining tasks are skipped and the first exception
+ *  is rethrown on the calling thread once all the threads have joined.
+ *
+ * \param n The number of tasks.
+ * \param f The task body.
+ */
+void parallel_for(size_t n, const std::function<void(size_t)>& f);
+
+}  // namespace support
+}  // namespace tvm
+#endif  // TVM_SUPPORT_PARALLEL_FOR_H_
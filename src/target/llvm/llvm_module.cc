@@ -26,12 +26,15 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/target/codegen.h>
+#include <algorithm>
 #include <mutex>
+#include <vector>
 #include "llvm_common.h"
 #include "codegen_llvm.h"
 #include "codegen_blob.h"
 #include "../../runtime/file_util.h"
 #include "../../runtime/library_module.h"
+#include "../../support/parallel_for.h"
 
 namespace tvm {
 namespace codegen {
@@ -40,6 +43,9 @@ using runtime::TVMArgs;
 using runtime::TVMRetValue;
 using runtime::PackedFunc;
 
+// Modules with fewer functions per build thread are generated in fewer parts.
+constexpr size_t kMinFunctionsPerPart = 4;
+
 class LLVMModuleNode final : public runtime::ModuleNode {
  public:
   ~LLVMModuleNode() {
@@ -198,14 +204,21 @@ class LLVMModuleNode final : public runtime::ModuleNode {
     bool system_lib = (target.find("-system-lib") != std::string::npos);
     CHECK_NE(funcs.size(), 0U);
     ctx_ = std::make_shared<llvm::LLVMContext>();
-    std::unique_ptr<CodeGenLLVM> cg = CodeGenLLVM::Create(tm_.get());
     entry_func_ = funcs[0]->name;
-    cg->Init(funcs[0]->name, tm_.get(), ctx_.get(), system_lib, system_lib);
-    for (LoweredFunc f :  funcs) {
-      cg->AddFunction(f);
+    // The startup function of a system library registers every function, keep them in one part.
+    size_t num_parts = system_lib ? 1 : std::min(static_cast<size_t>(support::NumBuildThreads()),
+                                                 funcs.size() / kMinFunctionsPerPart);
+    if (num_parts > 1) {
+      module_ = BuildParts(funcs, target, num_parts);
+    } else {
+      std::unique_ptr<CodeGenLLVM> cg = CodeGenLLVM::Create(tm_.get());
+      cg->Init(funcs[0]->name, tm_.get(), ctx_.get(), system_lib, system_lib);
+      for (LoweredFunc f :  funcs) {
+        cg->AddFunction(f);
+      }
+      cg->AddMainFunction(funcs[0]->name);
+      module_ = cg->Finish();
     }
-    cg->AddMainFunction(funcs[0]->name);
-    module_ = cg->Finish();
 
     module_->addModuleFlag(llvm::Module::Warning, "tvm_target", llvm::MDString::get(*ctx_, target));
     module_->addModuleFlag(llvm::Module::Override, "Debug Info Version",
@@ -262,6 +275,59 @@ class LLVMModuleNode final : public runtime::ModuleNode {
   }
 
  private:
+  /*!
+   * \brief Generate and optimize the functions in parts on the build threads,
+   *  then link the parts into one module of ctx_.
+   *
+   *  Each part has an LLVM context of its own and moves to ctx_ as bitcode.
+   *  The globals the parts share are link once, the entry is in the first part.
+   * \param funcs The functions, funcs[0] is the entry.
+   * \param target The target string.
+   * \param num_parts The number of parts.
+   * \return The linked module.
+   */
+  std::unique_ptr<llvm::Module> BuildParts(const Array<LoweredFunc>& funcs,
+                                           const std::string& target,
+                                           size_t num_parts) {
+    std::vector<std::string> bitcode(num_parts);
+    support::parallel_for(num_parts, [&](size_t part) {
+      llvm::LLVMContext ctx;
+      std::unique_ptr<llvm::TargetMachine> tm = GetLLVMTargetMachine(target);
+      std::unique_ptr<CodeGenLLVM> cg = CodeGenLLVM::Create(tm.get());
+      cg->Init(funcs[part]->name, tm.get(), &ctx, false, false);
+      for (size_t i = part; i < funcs.size(); i += num_parts) {
+        cg->AddFunction(funcs[i]);
+      }
+      if (part == 0) {
+        cg->AddMainFunction(funcs[0]->name);
+      }
+      std::unique_ptr<llvm::Module> module = cg->Finish();
+      llvm::raw_string_ostream os(bitcode[part]);
+#if TVM_LLVM_VERSION <= 60
+      llvm::WriteBitcodeToFile(module.get(), os);
+#else
+      llvm::WriteBitcodeToFile(*module, os);
+#endif
+      os.flush();
+    });
+    std::unique_ptr<llvm::Module> module;
+    for (size_t part = 0; part < num_parts; ++part) {
+      llvm::SMDiagnostic err;
+      std::unique_ptr<llvm::MemoryBuffer> buf =
+          llvm::MemoryBuffer::getMemBuffer(bitcode[part], funcs[part]->name, false);
+      std::unique_ptr<llvm::Module> mpart = llvm::parseIR(*buf, err, *ctx_);
+      CHECK(mpart != nullptr) << "Fail to load the code of " << funcs[part]->name
+                              << ": " << std::string(err.getMessage());
+      if (module == nullptr) {
+        module = std::move(mpart);
+      } else {
+        CHECK(!llvm::Linker::linkModules(*module, std::move(mpart)))
+            << "Failed to link modules";
+      }
+    }
+    return module;
+  }
+
   void LazyInitJIT() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (ee_) {
@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__) && !defined(__ANDROID__)
+namespace {
+
+constexpr size_t kHugePageSize = 2 << 20;
+
+// Whether ptr is in a mapping of the process.
+bool IsMapped(const void* ptr) {
+  uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+  std::ifstream maps("/proc/self/maps");
+  std::string line;
+  while (std::getline(maps, line)) {
+    std::string range = line.substr(0, line.find(' '));
+    size_t dash = range.find('-');
+    uintptr_t begin = std::stoull(range.substr(0, dash), nullptr, 16);
+    uintptr_t end = std::stoull(range.substr(dash + 1), nullptr, 16);
+    if (begin <= addr && addr < end) return true;
+  }
+  return false;
+}
+
+/*
+ * Allocate arrays with the CPU device API under the given settings. The
+ * settings are read once per process, so each call runs in a death test
+ * child and exits with 0 when all the checks pass.
+ */
+void CheckLargeAlloc(const char* huge_pages, const char* numa_policy) {
+  setenv("TVM_CPU_HUGE_PAGES", huge_pages, 1);
+  setenv("TVM_CPU_NUMA_POLICY", numa_policy, 1);
+  setenv("TVM_CPU_HUGE_PAGE_THRESHOLD", "1048576", 1);
+  TVMContext ctx{kDLCPU, 0};
+  DLDataType type{kDLFloat, 32, 1};
+  tvm::runtime::DeviceAPI* api = tvm::runtime::DeviceAPI::Get(ctx);
+  bool active = strlen(huge_pages) != 0 || strlen(numa_policy) != 0;
+  // above the threshold, below the default one.
+  for (size_t nbytes : {size_t(3) << 19, size_t(5) << 20}) {
+    char* ptr = static_cast<char*>(api->AllocDataSpace(ctx, nbytes, 64, type));
+    CHECK(ptr != nullptr);
+    CHECK_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0U);
+    // a mapped array starts on a huge page, malloc puts its header before the array.
+    CHECK_EQ(reinterpret_cast<uintptr_t>(ptr) % kHugePageSize == 0, active);
+    memset(ptr, 1, nbytes);
+    CHECK_EQ(ptr[nbytes - 1], 1);
+    api->FreeDataSpace(ctx, ptr);
+    // munmap, not free, released it.
+    if (active) CHECK(!IsMapped(ptr));
+  }
+  // below the threshold the array comes from malloc and goes back to it.
+  char* ptr = static_cast<char*>(api->AllocDataSpace(ctx, 4096, 64, type));
+  CHECK_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0U);
+  memset(ptr, 1, 4096);
+  api->FreeDataSpace(ctx, ptr);
+  CHECK(IsMapped(ptr));
+  exit(0);
+}
+
+}  // namespace
+
+TEST(CPUDeviceAPI, LargeAllocDefault) {
+  EXPECT_EXIT(CheckLargeAlloc("", ""), ::testing::ExitedWithCode(0), "");
+}
+
+TEST(CPUDeviceAPI, LargeAllocHugePages) {
+  EXPECT_EXIT(CheckLargeAlloc("thp", ""), ::testing::ExitedWithCode(0), "");
+  // without a hugetlbfs pool the allocator falls back to transparent huge pages.
+  EXPECT_EXIT(CheckLargeAlloc("explicit", ""), ::testing::ExitedWithCode(0), "");
+}
+
+TEST(CPUDeviceAPI, LargeAllocNumaPolicy) {
+  // mbind may be denied in containers, the allocation still succeeds.
+  EXPECT_EXIT(CheckLargeAlloc("", "interleave"), ::testing::ExitedWithCode(0), "");
+  EXPECT_EXIT(CheckLargeAlloc("", "local"), ::testing::ExitedWithCode(0), "");
+  EXPECT_EXIT(CheckLargeAlloc("", "0"), ::testing::ExitedWithCode(0), "");
+  EXPECT_EXIT(CheckLargeAlloc("thp", "interleave"), ::testing::ExitedWithCode(0), "");
+}
+#endif
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
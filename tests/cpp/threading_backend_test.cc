@@ -18,11 +18,18 @@
  */
 
 #include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <memory>
+#include <set>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
 
 constexpr size_t N = 128;
 
@@ -64,6 +71,98 @@ TEST(ThreadingBackend, TVMBackendParallelLaunchMultipleThreads) {
   }
 }
 
+TEST(ThreadingBackend, TVMBackendParallelLaunchNested) {
+  std::atomic<size_t> acc(0);
+  std::atomic<int> num_outer(0);
+  struct Closure {
+    std::atomic<size_t>* acc;
+    std::atomic<int>* num_outer;
+  } closure{&acc, &num_outer};
+  FTVMParallelLambda outer = [](int task_id, TVMParallelGroupEnv* penv, void* cdata) -> int {
+    auto* c = reinterpret_cast<Closure*>(cdata);
+    c->num_outer->fetch_add(1);
+    // launched from inside a task, runs on the idle workers of the same pool
+    return TVMBackendParallelLaunch(atomic_add_task_id, c->acc, 0);
+  };
+  EXPECT_EQ(TVMBackendParallelLaunch(outer, &closure, 0), 0);
+  EXPECT_EQ(acc.load(std::memory_order_relaxed),
+            num_outer.load() * (N * (N - 1) / 2));
+}
+
+TEST(ThreadingBackend, TVMBackendParallelLaunchWorkStealing) {
+  // The pool is created per master thread, so configure it before
+  // the first launch of a fresh thread.
+  setenv("TVM_THREAD_POOL_WORK_STEALING", "1", 1);
+  setenv("TVM_THREAD_POOL_STEAL_GRAIN", "8", 1);
+  std::thread t([]() {
+    for (size_t j = 0; j < 16; ++j) {
+      std::atomic<size_t> acc(0);
+      TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
+      EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+    }
+  });
+  t.join();
+  unsetenv("TVM_THREAD_POOL_WORK_STEALING");
+  unsetenv("TVM_THREAD_POOL_STEAL_GRAIN");
+}
+
+// The sum of a counter over the workers in the JSON of GetThreadPoolStats.
+static uint64_t SumWorkerCounter(const std::string& stats, const std::string& name) {
+  const std::string key = "\"" + name + "\": ";
+  uint64_t sum = 0;
+  for (size_t pos = stats.find(key); pos != std::string::npos; pos = stats.find(key, pos)) {
+    pos += key.size();
+    sum += std::stoull(stats.substr(pos));
+  }
+  return sum;
+}
+
+TEST(ThreadingBackend, TVMBackendParallelLaunchAdaptiveWait) {
+  setenv("TVM_THREAD_POOL_WAIT_POLICY", "adaptive", 1);
+  std::string stats;
+  std::thread t([&stats]() {
+    for (size_t j = 0; j < 16; ++j) {
+      std::atomic<size_t> acc(0);
+      TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
+      EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    const tvm::runtime::PackedFunc* fstats =
+        tvm::runtime::Registry::Get("runtime.GetThreadPoolStats");
+    ASSERT_TRUE(fstats != nullptr);
+    stats = (*fstats)().operator std::string();
+  });
+  t.join();
+  unsetenv("TVM_THREAD_POOL_WAIT_POLICY");
+  EXPECT_NE(stats.find("\"wait_policy\": \"adaptive\""), std::string::npos);
+  if (tvm::runtime::threading::MaxConcurrency() > 1) {
+    // the workers park while the average gap is unknown, then run the tasks.
+    EXPECT_GT(SumWorkerCounter(stats, "parks"), 0U);
+    EXPECT_GT(SumWorkerCounter(stats, "tasks"), 0U);
+  }
+}
+
+TEST(ThreadingBackend, NumaNodeCpus) {
+  unsigned int num_cpus = std::thread::hardware_concurrency();
+  auto nodes = tvm::runtime::threading::NumaNodeCpus();
+  auto physical = tvm::runtime::threading::NumaNodeCpus(true);
+  ASSERT_FALSE(nodes.empty());
+  ASSERT_EQ(nodes.size(), physical.size());
+  std::set<unsigned int> seen;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    EXPECT_FALSE(nodes[i].empty());
+    EXPECT_LE(physical[i].size(), nodes[i].size());
+    // physical cores come first.
+    for (size_t j = 0; j < physical[i].size(); ++j) {
+      EXPECT_EQ(physical[i][j], nodes[i][j]);
+    }
+    for (unsigned int cpu : nodes[i]) {
+      EXPECT_LT(cpu, num_cpus);
+      EXPECT_TRUE(seen.insert(cpu).second);
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
@@ -0,0 +1,80 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/registry.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string WorkspaceStats() {
+  const tvm::runtime::PackedFunc* f = tvm::runtime::Registry::Get("runtime.GetWorkspacePoolStats");
+  CHECK(f != nullptr);
+  std::string stats = (*f)(static_cast<int>(kDLCPU));
+  return stats;
+}
+
+}  // namespace
+
+TEST(WorkspacePool, ReuseSizeClass) {
+  // run in a fresh thread so the pool of this thread starts empty.
+  std::thread([]() {
+    const std::vector<uint64_t> sizes = {100, 5000, 70000, 300000, 4096, 1 << 20};
+    void* first = nullptr;
+    for (int run = 0; run < 3; ++run) {
+      std::vector<void*> ptrs;
+      for (uint64_t size : sizes) {
+        void* ptr = TVMBackendAllocWorkspace(kDLCPU, 0, size, kDLFloat, 32);
+        ASSERT_NE(ptr, nullptr);
+        // the whole block is writable.
+        static_cast<char*>(ptr)[size - 1] = 1;
+        ptrs.push_back(ptr);
+      }
+      if (run == 0) {
+        first = ptrs[0];
+      } else {
+        // same sizes are served from the cache.
+        EXPECT_EQ(ptrs[0], first);
+      }
+      for (auto it = ptrs.rbegin(); it != ptrs.rend(); ++it) {
+        EXPECT_EQ(TVMBackendFreeWorkspace(kDLCPU, 0, *it), 0);
+      }
+    }
+    // freeing in a different order than allocation is allowed.
+    void* a = TVMBackendAllocWorkspace(kDLCPU, 0, 1000, kDLFloat, 32);
+    void* b = TVMBackendAllocWorkspace(kDLCPU, 0, 1000, kDLFloat, 32);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(TVMBackendFreeWorkspace(kDLCPU, 0, a), 0);
+    EXPECT_EQ(TVMBackendFreeWorkspace(kDLCPU, 0, b), 0);
+  }).join();
+  std::string stats = WorkspaceStats();
+  EXPECT_NE(stats.find("\"hit_rate\""), std::string::npos);
+  EXPECT_NE(stats.find("\"peak_in_use_bytes\""), std::string::npos);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
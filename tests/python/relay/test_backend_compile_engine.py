@@ -14,12 +14,14 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
+import os
 import numpy as np
 import tvm
 from tvm import te
 import tvm.testing
 from tvm import relay
 from tvm import autotvm
+from tvm.contrib import graph_runtime, util
 import topi
 from tvm.relay.testing import run_infer_type
 from tvm.relay.testing.temp_op_attr import TempOpAttr
@@ -177,6 +179,108 @@ def test_compile_engine():
                 y.asnumpy(), x.asnumpy() * 3)
     engine.dump()
 
+def test_compile_engine_lower_all():
+    engine = relay.backend.compile_engine.get()
+    def get_func(shape):
+        x = relay.var("x", shape=shape)
+        f = relay.Function([x], relay.exp(relay.add(x, x)))
+        mod = relay.transform.InferType()(tvm.IRModule.from_expr(f))
+        return mod["main"]
+    funcs = [get_func((i + 1, 8)) for i in range(8)]
+    engine.lower_all(funcs + funcs[:2], "llvm")
+    lowered = [engine.lower(f, "llvm") for f in funcs]
+    assert len(set(z.func_name for z in lowered)) == len(funcs)
+    for f, z in zip(funcs, lowered):
+        assert len(z.funcs) > 0
+        assert z.same_as(engine.lower(f, "llvm"))
+
+
+def test_compile_parallel_build():
+    # differently shaped layers, so that every fused function is lowered
+    x = relay.var("x", shape=(1, 16))
+    out = x
+    weights = []
+    for i in range(12):
+        weight = np.random.uniform(-1, 1, size=(17 + i, 16 + i)).astype("float32")
+        out = relay.nn.relu(relay.nn.dense(out, relay.const(weight)))
+        weights.append(weight)
+    mod = tvm.IRModule.from_expr(relay.Function([x], out))
+    x_np = np.random.uniform(-1, 1, size=(1, 16)).astype("float32")
+    ref = x_np
+    for weight in weights:
+        ref = np.maximum(np.dot(ref, weight.T), 0)
+
+    # conv2d pads and softmax compute inside tag scopes, which the threads must not share
+    data = relay.var("data", shape=(1, 3, 16, 16))
+    conv = data
+    for i in range(4):
+        weight = np.random.uniform(-1, 1, size=(4 + i, 3 + i, 3, 3))
+        conv = relay.nn.relu(relay.nn.conv2d(conv, relay.const(weight.astype("float32")),
+                                             padding=(1, 1)))
+    conv_out = relay.nn.softmax(relay.nn.batch_flatten(conv))
+    conv_mod = tvm.IRModule.from_expr(relay.Function([data], conv_out))
+    data_np = np.random.uniform(-1, 1, size=(1, 3, 16, 16)).astype("float32")
+
+    old_threads = os.environ.get("TVM_NUM_BUILD_THREADS")
+    try:
+        conv_outs = []
+        for num_threads in ["1", "4"]:
+            os.environ["TVM_NUM_BUILD_THREADS"] = num_threads
+            relay.backend.compile_engine.get().clear()
+            graph, lib, params = relay.build(mod, "llvm")
+            module = graph_runtime.create(graph, lib, tvm.cpu())
+            module.set_input(**params)
+            module.run(x=x_np)
+            tvm.testing.assert_allclose(module.get_output(0).asnumpy(), ref, rtol=1e-4)
+
+            relay.backend.compile_engine.get().clear()
+            graph, lib, params = relay.build(conv_mod, "llvm")
+            module = graph_runtime.create(graph, lib, tvm.cpu())
+            module.set_input(**params)
+            module.run(data=data_np)
+            conv_outs.append(module.get_output(0).asnumpy())
+        tvm.testing.assert_allclose(conv_outs[0], conv_outs[1], rtol=1e-4)
+    finally:
+        if old_threads is None:
+            del os.environ["TVM_NUM_BUILD_THREADS"]
+        else:
+            os.environ["TVM_NUM_BUILD_THREADS"] = old_threads
+
+
+def test_compile_engine_persistent_cache():
+    engine = relay.backend.compile_engine.get()
+    def get_func(shape):
+        x = relay.var("x", shape=shape)
+        f = relay.Function([x], relay.sqrt(relay.abs(x)))
+        mod = relay.transform.InferType()(tvm.IRModule.from_expr(f))
+        return mod["main"]
+    temp = util.tempdir()
+    old_dir = engine.get_cache_dir()
+    try:
+        engine.set_cache_dir(temp.relpath("cache"))
+        engine.clear()
+        z1 = engine.lower(get_func((3, 5)), "llvm")
+        assert z1.schedule is not None
+        assert len(os.listdir(temp.relpath("cache"))) == 1
+        # a new engine state loads the function instead of scheduling it
+        engine.clear()
+        z2 = engine.lower(get_func((3, 5)), "llvm")
+        assert z2.schedule is None
+        assert z2.func_name != z1.func_name
+        assert z2.funcs[0].name == z2.func_name
+        f = engine.jit(get_func((3, 5)), "llvm")
+        x = tvm.nd.array(np.random.uniform(-1, 1, size=(3, 5)).astype("float32"))
+        y = tvm.nd.empty((3, 5))
+        f(x, y)
+        tvm.testing.assert_allclose(y.asnumpy(), np.sqrt(np.abs(x.asnumpy())), rtol=1e-5)
+        # another target is another entry
+        engine.lower(get_func((3, 5)), "llvm -mcpu=core-avx2")
+        assert len(os.listdir(temp.relpath("cache"))) == 2
+    finally:
+        engine.set_cache_dir(old_dir)
+        engine.clear()
+
+
 def test_compile_placeholder_bypass():
     engine = relay.backend.compile_engine.get()
     x = relay.var("x", shape=(2, 3))
@@ -238,6 +342,9 @@ if __name__ == "__main__":
     test_get_valid_implementations()
     test_select_implementation()
     test_compile_engine()
+    test_compile_engine_lower_all()
+    test_compile_parallel_build()
+    test_compile_engine_persistent_cache()
     test_compile_placeholder_bypass()
     test_compile_injective_with_tuple()
     test_compile_tuple_dup()
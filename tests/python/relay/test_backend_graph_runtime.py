@@ -19,7 +19,7 @@ import numpy as np
 import tvm
 from tvm import te
 from tvm import relay
-from tvm.contrib import graph_runtime
+from tvm.contrib import graph_runtime, util
 from tvm.relay.scope_builder import ScopeBuilder
 from tvm.relay.op import add
 from tvm.relay.testing.config import ctx_list
@@ -143,6 +143,62 @@ def test_plan_memory():
     assert len(device_types) == 1
 
 
+def test_plan_memory_offset():
+    # a diamond, the token planner cannot reuse the large buffer for both branches
+    x = relay.var("x", shape=(64, 64))
+    a = relay.exp(x)
+    b = relay.sum(a, axis=1, keepdims=True)
+    c = relay.tanh(a)
+    d = relay.nn.relu(c + b)
+    e = relay.sigmoid(d)
+    func = relay.Function([x], e)
+    mod = tvm.IRModule.from_expr(func)
+    mod = relay.transform.FuseOps(0)(relay.transform.InferType()(mod))
+    smap = relay.backend._backend.GraphPlanMemoryOffset(mod["main"])
+    for k, v in smap.items():
+        assert len(v) == 3
+        for offset in v[2]:
+            assert offset.value % 64 == 0
+    report = relay.backend._backend.GraphMemoryPlanReport(mod["main"])
+    assert report["offset_bytes"].value <= report["token_bytes"].value
+
+    x_data = np.random.rand(64, 64).astype("float32")
+    outs = []
+    for memory_plan in ["token", "offset"]:
+        with relay.build_config(opt_level=2):
+            graph, lib, params = relay.build(tvm.IRModule.from_expr(func), "llvm",
+                                             memory_plan=memory_plan)
+        assert ("storage_offset" in graph) == (memory_plan == "offset")
+        m = graph_runtime.create(graph, lib, tvm.cpu(0))
+        m.set_input("x", x_data)
+        m.run()
+        outs.append(m.get_output(0).asnumpy())
+    tvm.testing.assert_allclose(outs[0], outs[1], rtol=1e-5)
+
+
+def test_plan_memory_offset_shared_params():
+    x = relay.var("x", shape=(64, 64))
+    w = relay.var("w", shape=(64, 64))
+    func = relay.Function([x, w], relay.nn.relu(relay.exp(x) + w))
+    w_data = np.random.rand(64, 64).astype("float32")
+    with relay.build_config(opt_level=2):
+        graph, lib, params = relay.build(tvm.IRModule.from_expr(func), "llvm",
+                                         params={"w": w_data}, memory_plan="offset")
+    assert "storage_offset" in graph
+    m = graph_runtime.create(graph, lib, tvm.cpu(0))
+    m.load_params(relay.save_param_dict(params))
+    model = graph_runtime.create_model(graph, lib, tvm.cpu(0))
+    model.load_params(relay.save_param_dict(params))
+    e = model.create_executor()
+    # the executor has no storage for the shared weight, and no hole for it
+    assert e.get_storage_bytes() == m.get_storage_bytes() - w_data.nbytes
+    x_data = np.random.rand(64, 64).astype("float32")
+    for mod in [m, e]:
+        mod.run(x=x_data)
+        tvm.testing.assert_allclose(mod.get_output(0).asnumpy(),
+                                    np.maximum(np.exp(x_data) + w_data, 0), rtol=1e-5)
+
+
 def test_gru_like():
     def unit(rnn_dim):
         X = relay.var("X", shape=(1, rnn_dim))
@@ -180,10 +236,92 @@ def test_gru_like():
             tvm.testing.assert_allclose(out, ref, rtol=1e-5, atol=1e-5)
 
 
+def test_inter_op_parallelism():
+    # independent branches joined at the end, with buffers reused across them
+    x = relay.var("x", shape=(16, 64))
+    w = relay.var("w", shape=(64, 64))
+    branches = []
+    for i in range(4):
+        y = relay.nn.dense(relay.exp(x * relay.const(0.1 * (i + 1))), w)
+        branches.append(relay.tanh(y) + relay.const(float(i)))
+    out = relay.concatenate(branches, axis=1)
+    func = relay.Function([x, w], out)
+
+    x_data = np.random.rand(16, 64).astype("float32")
+    w_data = np.random.rand(64, 64).astype("float32") * 0.01
+    with relay.build_config(opt_level=2):
+        graph, lib, params = relay.build(tvm.IRModule.from_expr(func), "llvm")
+    m = graph_runtime.create(graph, lib, tvm.cpu(0))
+    m.set_input("x", x_data)
+    m.set_input("w", w_data)
+    m.set_input(**params)
+    m.run()
+    ref = m.get_output(0).asnumpy()
+    m.set_inter_op_parallelism(2)
+    for _ in range(10):
+        m.run()
+        tvm.testing.assert_allclose(m.get_output(0).asnumpy(), ref, rtol=1e-5)
+
+    # more streams than the workers of the bound pool
+    tvm.runtime.create_thread_pool("test_inter_op_pool", 2)
+    m.set_thread_pool("test_inter_op_pool")
+    m.set_inter_op_parallelism(8)
+    for _ in range(10):
+        m.run()
+        tvm.testing.assert_allclose(m.get_output(0).asnumpy(), ref, rtol=1e-5)
+    tvm.runtime.remove_thread_pool("test_inter_op_pool")
+
+
+def test_incremental_build():
+    shape = (4, 8)
+    x = relay.var("x", shape=shape)
+    y = relay.nn.softmax(relay.exp(x))
+    mod1 = tvm.IRModule.from_expr(relay.Function([x], relay.add(y, relay.const(1.0))))
+    mod2 = tvm.IRModule.from_expr(relay.Function([x], relay.multiply(y, relay.const(2.0))))
+    data = np.random.uniform(size=shape).astype("float32")
+    exp = np.exp(data)
+    softmax = np.exp(exp - exp.max(axis=1, keepdims=True))
+    softmax /= softmax.sum(axis=1, keepdims=True)
+
+    def check(graph, lib, params, ref):
+        m = graph_runtime.create(graph, lib, tvm.cpu())
+        m.set_input(**params)
+        m.run(x=data)
+        tvm.testing.assert_allclose(m.get_output(0).asnumpy(), ref, rtol=1e-5)
+
+    bld = relay.build_module.BuildModule(incremental=True)
+    graph, lib1, params = bld.build(mod1, "llvm")
+    check(graph, lib1, params, softmax + 1)
+    assert lib1.type_key == "composite"
+    assert len(lib1.imported_modules) == 1
+    part1 = lib1.imported_modules[0]
+
+    # exp and softmax are reused, only the multiplication is built.
+    graph, lib2, params = bld.build(mod2, "llvm")
+    check(graph, lib2, params, softmax * 2)
+    assert len(lib2.imported_modules) == 2
+    assert lib2.imported_modules[0].handle.value == part1.handle.value
+
+    temp = util.tempdir()
+    path = temp.relpath("incremental.so")
+    lib2.export_library(path)
+    check(graph, tvm.runtime.load_module(path), params, softmax * 2)
+
+    # Nothing is built when all the functions were built before.
+    graph, lib3, params = bld.build(mod1, "llvm")
+    check(graph, lib3, params, softmax + 1)
+    assert len(lib3.imported_modules) == 1
+    assert lib3.imported_modules[0].handle.value == part1.handle.value
+
+
 if __name__ == "__main__":
     test_plan_memory()
+    test_plan_memory_offset()
+    test_plan_memory_offset_shared_params()
     test_with_params()
     test_add_op_scalar()
     test_add_op_tensor()
     test_add_op_broadcast()
     test_gru_like()
+    test_inter_op_parallelism()
+    test_incremental_build()
@@ -53,6 +53,37 @@ def test_ndarray_reflection():
     np.testing.assert_equal(deser_param_dict['x'].asnumpy(), deser_param_dict['y'].asnumpy())
 
 
+def test_load_mapped_params():
+    x = relay.var("x", shape=(4, 16))
+    w = relay.var("w", shape=(8, 16))
+    b = relay.var("b", shape=(8,))
+    func = relay.Function([x, w, b], relay.nn.bias_add(relay.nn.dense(x, w), b))
+    params = {"w": np.random.uniform(size=(8, 16)).astype("float32"),
+              "b": np.random.uniform(size=(8,)).astype("float32")}
+    graph, lib, params = relay.build(func, "llvm", params=params)
+
+    temp = util.tempdir()
+    path = temp.relpath("deploy.params")
+    with open(path, "wb") as fo:
+        fo.write(relay.save_mapped_param_dict(params))
+
+    x_in = np.random.uniform(size=(4, 16)).astype("float32")
+    outs = []
+    for mapped in [False, True]:
+        mod = graph_runtime.create(graph, lib, tvm.cpu(0))
+        if mapped:
+            mod.load_mapped_params(path)
+        else:
+            mod.load_params(relay.save_param_dict(params))
+        mod.run(x=x_in)
+        outs.append(mod.get_output(0).asnumpy())
+    tvm.testing.assert_allclose(outs[0], outs[1])
+    # the clone keeps using the mapped parameters.
+    clone = mod.clone()
+    clone.run(x=x_in)
+    tvm.testing.assert_allclose(clone.get_output(0).asnumpy(), outs[0])
+
+
 def test_bigendian_rpc_param():
     """Test big endian rpc when there is a PowerPC RPC server available"""
     host = os.environ.get("TVM_POWERPC_TEST_HOST", None)
@@ -92,4 +123,5 @@ def test_bigendian_rpc_param():
 if __name__ == "__main__":
     test_save_load()
     test_ndarray_reflection()
+    test_load_mapped_params()
     test_bigendian_rpc_param()
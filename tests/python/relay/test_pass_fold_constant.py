@@ -205,6 +205,31 @@ def test_fold_batch_norm():
     assert relay.analysis.graph_equal(mod["main"], expect)
 
 
+def test_fold_identical_subexpressions():
+    c_data = np.array([1, 2, 3]).astype("float32")
+    t = relay.TensorType([3], "float32")
+    def before():
+        x = relay.var("x", t)
+        a = relay.negative(relay.const(c_data))
+        b = relay.negative(relay.const(c_data))
+        c = relay.multiply(relay.const(c_data), relay.const(2, "float32"))
+        y = relay.add(relay.add(x, a), b)
+        return relay.Function([x], relay.Tuple([y, c]))
+
+    def expected():
+        x = relay.var("x", t)
+        e = relay.const(-c_data)
+        y = relay.add(relay.add(x, e), e)
+        return relay.Function([x], relay.Tuple([y, relay.const(c_data * 2)]))
+
+    zz = run_opt_pass(before(), transform.FoldConstant())
+    zexpected = run_opt_pass(expected(), transform.InferType())
+    assert relay.analysis.alpha_equal(zz, zexpected)
+    # The identical subexpressions are evaluated once.
+    y = zz.body.fields[0]
+    assert y.args[0].args[1].same_as(y.args[1])
+
+
 if __name__ == "__main__":
     test_fold_const()
     test_fold_let()
@@ -213,3 +238,4 @@ if __name__ == "__main__":
     test_fold_shape_of()
     test_fold_full()
     test_fold_batch_norm()
+    test_fold_identical_subexpressions()
@@ -15,12 +15,15 @@
 # specific language governing permissions and limitations
 # under the License.
 """Unit tests for relay pass manager."""
+import json
+
 import numpy as np
 import pytest
 
 import tvm
 from tvm import te
 from tvm import relay
+from tvm.contrib import util
 from tvm.relay import ExprFunctor
 from tvm.relay import Function, Call
 from tvm.relay import analysis
@@ -554,5 +557,51 @@ def test_print_debug_callback():
     assert __TRACE_COUNTER__ == 4
 
 
+def test_pass_profiler():
+    x = relay.var("x", relay.TensorType((1, 2, 3), "float32"))
+    c = relay.add(relay.const(1, "float32"), relay.const(2, "float32"))
+    func = relay.Function([x], relay.multiply(x, c))
+    seq = _transform.Sequential([
+        relay.transform.InferType(),
+        _transform.Sequential([
+            relay.transform.FoldConstant(),
+            relay.transform.DeadCodeElimination()
+        ], name="inner"),
+    ])
+    mod = tvm.IRModule({"main": func})
+
+    profiler = tvm.transform.PassProfiler()
+    with relay.build_config(opt_level=3, profiler=profiler):
+        seq(mod)
+
+    records = profiler.records()
+    for r in records:
+        assert r["duration_us"] >= 0 and r["nodes_before"] > 0 and r["nodes_after"] > 0
+        assert r["memory_growth_kb"] >= 0
+    # FoldConstant runs its own Sequential, which is recorded at depth 2.
+    outer = [r for r in records if r["depth"] <= 1]
+    assert [(r["name"], r["depth"]) for r in outer] == [
+        ("InferType", 0), ("inner", 0), ("FoldConstant", 1), ("DeadCodeElimination", 1)]
+    inner, fold = outer[1], outer[2]
+    assert fold["nodes_after"] < fold["nodes_before"]
+    assert inner["start_us"] <= fold["start_us"]
+    assert fold["start_us"] + fold["duration_us"] <= inner["start_us"] + inner["duration_us"]
+    assert "FoldConstant" in profiler.summary()
+
+    temp = util.tempdir()
+    path = temp.relpath("trace.json")
+    profiler.save(path, fmt="chrome")
+    with open(path) as f:
+        events = json.load(f)["traceEvents"]
+    assert [e["name"] for e in events] == [r["name"] for r in records]
+    assert all(e["ph"] == "X" for e in events)
+
+    profiler.clear()
+    assert not profiler.records()
+    with relay.build_config(opt_level=3):
+        seq(mod)
+    assert not profiler.records()
+
+
 if __name__ == "__main__":
     pytest.main()
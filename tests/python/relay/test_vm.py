@@ -604,5 +604,132 @@ def test_loop_free_var():
         mod["main"] = relay.Function(relay.analysis.free_vars(ret), ret)
         check_result(args, expected, mod=mod)
 
+
+def test_best_fit_allocator():
+    import gc
+    from tvm.runtime import vm as vm_rt
+    # dynamic-like workload, each size differs so exact-size pools would miss
+    ctx = tvm.cpu()
+    gc.collect()
+    vm_rt.set_allocator(ctx, "best_fit", arena_size=1 << 16, high_water=1 << 20)
+    try:
+        for n in [7, 13, 64, 100, 33]:
+            x = relay.var('x', shape=(n, 16))
+            y = relay.var('y', shape=(n, 16))
+            mod = tvm.IRModule()
+            mod["main"] = relay.Function([x, y], relay.exp(x) + relay.log(y))
+            x_data = np.random.rand(n, 16).astype('float32')
+            y_data = np.random.rand(n, 16).astype('float32') + 1
+            res = veval(mod, x_data, y_data, ctx=ctx)
+            tvm.testing.assert_allclose(res.asnumpy(), np.exp(x_data) + np.log(y_data),
+                                        rtol=1e-5)
+            del res
+            gc.collect()
+            # the buffers of every size are carved out of the first arena
+            assert vm_rt.get_allocator_memory(ctx, reserved=True) == 1 << 16
+        assert vm_rt.get_allocator_memory(ctx) == 0
+    finally:
+        gc.collect()
+        vm_rt.set_allocator(ctx, "naive")
+
+
+def test_invoke_async():
+    x = relay.var('x', shape=(10, 10))
+    mod = tvm.IRModule()
+    mod["main"] = relay.Function([x], relay.exp(x) * relay.const(2.0))
+    exe = relay.vm.compile(mod, "llvm")
+    vm = runtime.vm.VirtualMachine(exe)
+    vm.init(tvm.cpu())
+    # the inputs are taken at submission, so the calls can be queued back to back
+    inputs = [np.random.rand(10, 10).astype('float32') for _ in range(4)]
+    futures = [vm.run_async(data) for data in inputs]
+    for data, future in zip(inputs, futures):
+        tvm.testing.assert_allclose(future.result().asnumpy(), np.exp(data) * 2.0, rtol=1e-5)
+
+
+def test_deep_recursion_reuses_frames():
+    mod = tvm.IRModule({})
+    sum_up = relay.GlobalVar('sum_up')
+    i = relay.var('i', shape=[], dtype='int32')
+    accum = relay.var('accum', shape=[], dtype='int32')
+    sb = ScopeBuilder()
+    with sb.if_scope(relay.equal(i, relay.const(0, 'int32'))):
+        sb.ret(accum)
+    with sb.else_scope():
+        one_less = relay.subtract(i, relay.const(1, 'int32'))
+        new_accum = relay.add(accum, i)
+        sb.ret(relay.Call(sum_up, [one_less, new_accum]))
+    mod[sum_up] = relay.Function([i, accum], sb.get())
+    iarg = relay.var('i', shape=[], dtype='int32')
+    aarg = relay.var('accum', shape=[], dtype='int32')
+    mod["main"] = relay.Function([iarg, aarg], sum_up(iarg, aarg))
+    exe = relay.vm.compile(mod, "llvm")
+    vm = runtime.vm.VirtualMachine(exe)
+    vm.init(tvm.cpu())
+    get_num_executed = vm.mod["get_num_executed"]
+    bound = 1000
+    args = [np.array(bound, dtype='int32'), np.array(0, dtype='int32')]
+    counts = []
+    for _ in range(2):
+        start = get_num_executed()
+        result = vm.run(*args)
+        counts.append(get_num_executed() - start)
+        tvm.testing.assert_allclose(result.asnumpy(), bound * (bound + 1) // 2)
+    # the second call runs on the registers left by the first one
+    assert counts[0] == counts[1] and counts[0] > bound
+
+
+def test_static_tensor_allocation():
+    x = relay.var('x', shape=(10, 10))
+    y = relay.add(relay.exp(x), x)
+    mod = tvm.IRModule.from_expr(relay.Function([x], relay.multiply(y, y)))
+    exe = relay.vm.compile(mod, "llvm")
+    assert "alloc_static_tensor" in exe.bytecode
+    assert "alloc_storage" not in exe.bytecode
+    vm = runtime.vm.VirtualMachine(exe)
+    vm.init(tvm.cpu())
+    x_data = np.random.rand(10, 10).astype('float32')
+    ref = np.square(np.exp(x_data) + x_data)
+    first = vm.run(x_data)
+    second = vm.run(x_data + 1)
+    # the storage of a live result is not reused by the next call
+    tvm.testing.assert_allclose(first.asnumpy(), ref, rtol=1e-5)
+    tvm.testing.assert_allclose(second.asnumpy(),
+                                np.square(np.exp(x_data + 1) + x_data + 1), rtol=1e-5)
+
+
+def test_concurrent_vms_local_allocators():
+    import threading
+    x = relay.var('x', shape=(32, 32))
+    w = relay.var('w', shape=(32, 32))
+    mod = tvm.IRModule.from_expr(
+        relay.Function([x, w], relay.nn.relu(relay.nn.dense(relay.tanh(x), w))))
+    exe = relay.vm.compile(mod, "llvm")
+    w_data = np.random.uniform(-1, 1, size=(32, 32)).astype('float32')
+    errors = []
+
+    def worker(seed):
+        try:
+            vm = runtime.vm.VirtualMachine(exe)
+            vm.init(tvm.cpu())
+            vm.set_allocator("pooled")
+            rng = np.random.RandomState(seed)
+            for _ in range(20):
+                x_data = rng.uniform(-1, 1, size=(32, 32)).astype('float32')
+                res = vm.run(x_data, w_data)
+                ref = np.maximum(np.dot(np.tanh(x_data), w_data.T), 0)
+                tvm.testing.assert_allclose(res.asnumpy(), ref, rtol=1e-5, atol=1e-5)
+            assert vm.get_allocator_memory() > 0
+        except Exception as err:  # pylint: disable=broad-except
+            errors.append(err)
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert not errors, errors
+
+
 if __name__ == "__main__":
     pytest.main([__file__])
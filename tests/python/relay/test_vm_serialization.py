@@ -322,6 +322,37 @@ def test_closure():
     tvm.testing.assert_allclose(res.asnumpy(), 3.0)
 
 
+def test_save_load_mapped():
+    x = relay.var('x', shape=(10, 10))
+    w = relay.const(np.random.uniform(size=(10, 10)).astype('float32'))
+    b = relay.const(np.random.uniform(size=(10,)).astype('float32'))
+    i = relay.var('i', shape=(), dtype='int32')
+    f = relay.Function([x, i], relay.nn.bias_add(relay.nn.dense(x, w), b) *
+                       relay.cast(i, 'float32'))
+    exe = create_exec(f)
+    tmp = util.tempdir()
+    path = tmp.relpath("code.ro")
+    exe.save_mapped(path)
+    des_exec = _vm.Executable.load_mapped(path, exe.lib)
+    assert des_exec.bytecode == exe.bytecode
+    # the stats print every constant, they are read from the mapping.
+    assert des_exec.stats == exe.stats
+
+    x_data = np.random.rand(10, 10).astype('float32')
+    ref = (np.dot(x_data, w.data.asnumpy().T) + b.data.asnumpy()) * 3
+    des_vm = _vm.VirtualMachine(des_exec)
+    des_vm.init(tvm.cpu())
+    res = veval(des_vm, x_data, np.array(3, dtype='int32'))
+    tvm.testing.assert_allclose(res.asnumpy(), ref, rtol=1e-5)
+
+    # the executable still saves to the stream format.
+    code, lib = des_exec.save()
+    vm = _vm.VirtualMachine(_vm.Executable.load_exec(code, lib))
+    vm.init(tvm.cpu())
+    res = veval(vm, x_data, np.array(3, dtype='int32'))
+    tvm.testing.assert_allclose(res.asnumpy(), ref, rtol=1e-5)
+
+
 def test_resnet():
     mod, params = testing.resnet.get_workload(batch_size=1, num_layers=18)
     run_network(mod, params)
@@ -342,5 +373,6 @@ if __name__ == "__main__":
     test_adt_list()
     test_adt_compose()
     test_closure()
+    test_save_load_mapped()
     test_resnet()
     test_mobilenet()
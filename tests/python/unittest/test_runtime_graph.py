@@ -119,9 +119,186 @@ def test_graph_simple():
             np.testing.assert_equal(out.asnumpy(), x_in + a)
             del mod
 
+    def check_thread_pool():
+        if not tvm.runtime.enabled("llvm"):
+            print("Skip because llvm is not enabled")
+            return
+        import threading
+        m = 1024
+        C = te.placeholder((m,), name='C')
+        D = te.compute(C.shape, lambda i: C[i] * 2.0, name='D')
+        sch = te.create_schedule(D.op)
+        xo, xi = sch[D].split(D.op.axis[0], factor=64)
+        sch[D].parallel(xo)
+        mlib = tvm.build(sch, [C, D], "llvm", name="myadd")
+        tvm.runtime.create_thread_pool("test_graph_pool", 2)
+        pgraph = graph.replace("[[4], [4]]", "[[%d], [%d]]" % (m, m))
+        mods = [graph_runtime.create(pgraph, mlib, tvm.cpu(0)) for _ in range(4)]
+        results = [None] * len(mods)
+
+        def run(i):
+            c = np.random.uniform(size=(m,)).astype(C.dtype)
+            mods[i].set_thread_pool("test_graph_pool")
+            for _ in range(10):
+                mods[i].run(x=c)
+            results[i] = (c, mods[i].get_output(0).asnumpy())
+
+        threads = [threading.Thread(target=run, args=(i,)) for i in range(len(mods))]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        for c, out in results:
+            np.testing.assert_equal(out, c * 2.0)
+        tvm.runtime.remove_thread_pool("test_graph_pool")
+
+    def check_memory_arena():
+        if not tvm.runtime.enabled("llvm"):
+            print("Skip because llvm is not enabled")
+            return
+        m = 4096
+        C = te.placeholder((m,), name='C')
+        # the intermediate stage is too large for the stack and uses a workspace
+        T = te.compute(C.shape, lambda i: C[i] * 2.0, name='T')
+        D = te.compute(C.shape, lambda i: T[i] + 1.0, name='D')
+        sch = te.create_schedule(D.op)
+        mlib = tvm.build(sch, [C, D], "llvm", name="myadd")
+        agraph = graph.replace("[[4], [4]]", "[[%d], [%d]]" % (m, m))
+        mod = graph_runtime.create(agraph, mlib, tvm.cpu(0))
+        c = np.random.uniform(size=(m,)).astype(C.dtype)
+        mod.set_input(x=c)
+        # the input is kept, a warm-up run sizes the workspace region
+        mod.set_memory_arena(True)
+        out = mod.get_output(0)
+        for _ in range(3):
+            mod.run()
+            np.testing.assert_equal(out.asnumpy(), c * 2.0 + 1.0)
+        clone = mod.clone()
+        c2 = np.random.uniform(size=(m,)).astype(C.dtype)
+        clone.run(x=c2)
+        np.testing.assert_equal(clone.get_output(0).asnumpy(), c2 * 2.0 + 1.0)
+        mod.run()
+        np.testing.assert_equal(mod.get_output(0).asnumpy(), c * 2.0 + 1.0)
+        mod.set_memory_arena(True, m * 4)
+        mod.run()
+        np.testing.assert_equal(mod.get_output(0).asnumpy(), c * 2.0 + 1.0)
+        mod.set_memory_arena(False)
+        mod.run()
+        np.testing.assert_equal(mod.get_output(0).asnumpy(), c * 2.0 + 1.0)
+
+    def check_model():
+        if not tvm.runtime.enabled("llvm"):
+            print("Skip because llvm is not enabled")
+            return
+        from tvm import relay
+        x = relay.var('x', shape=(1, 10))
+        y = relay.var('y', shape=(1, 10))
+        func = relay.Function([x, y], relay.add(x, y))
+        x_in = np.ones((1, 10)).astype("float32")
+        graph, lib, params = relay.build(func, target="llvm", params={'x': x_in})
+
+        model = graph_runtime.create_model(graph, lib, tvm.cpu(0))
+        model.load_params(relay.save_param_dict(params))
+        mods = [model.create_executor() for _ in range(10)]
+        # the executors see the same parameters, they cannot write them
+        x_name = list(params.keys())[0]
+        try:
+            mods[0].module["set_input"](x_name, tvm.nd.array(np.zeros((1, 10), "float32")))
+            assert False
+        except tvm.error.TVMError:
+            pass
+        del model
+        for mod in mods:
+            a = np.random.uniform(size=(1, 10)).astype("float32")
+            mod.run(y=a)
+            np.testing.assert_equal(mod.get_output(0).asnumpy(), x_in + a)
+
+    def check_batcher():
+        if not tvm.runtime.enabled("llvm"):
+            print("Skip because llvm is not enabled")
+            return
+        import threading
+        from tvm import relay
+        batch = 4
+        x = relay.var('x', shape=(batch, 8))
+        func = relay.Function([x], relay.nn.relu(x) * relay.const(2.0))
+        graph, lib, _ = relay.build(func, target="llvm")
+        mod = graph_runtime.create(graph, lib, tvm.cpu(0))
+        batcher = graph_runtime.create_batcher(mod, ["x"], max_latency_ms=5)
+        assert batcher.batch_size == batch
+        num_requests = 10
+        results = [None] * num_requests
+
+        def request(i):
+            rows = i % 2 + 1
+            a = np.random.uniform(-1, 1, size=(rows, 8)).astype("float32")
+            results[i] = (a, batcher.run(x=a)[0].asnumpy())
+
+        threads = [threading.Thread(target=request, args=(i,)) for i in range(num_requests)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        for a, out in results:
+            np.testing.assert_allclose(out, np.maximum(a, 0) * 2.0)
+        stats = batcher.stats()
+        assert stats["requests"] == num_requests
+        assert stats["rows"] == 15
+        assert stats["batches"] * batch == stats["rows"] + stats["padded_rows"]
+
+    def check_pipeline():
+        if not tvm.runtime.enabled("llvm"):
+            print("Skip because llvm is not enabled")
+            return
+        from tvm import relay
+        x = relay.var('x', shape=(4, 16))
+        y = x
+        for i in range(6):
+            y = relay.nn.relu(y + relay.const(float(i))) * relay.const(0.5)
+        func = relay.Function([x], y)
+        with relay.build_config(opt_level=0):
+            graph, lib, params = relay.build(func, target="llvm")
+        ref = graph_runtime.create(graph, lib, tvm.cpu(0))
+        ref.set_input(**params)
+        model = graph_runtime.create_model(graph, lib, tvm.cpu(0))
+        model.load_params(relay.save_param_dict(params))
+        pipeline = graph_runtime.create_pipeline(model, 3)
+        batches = [{"x": np.random.uniform(-4, 4, size=(4, 16)).astype("float32")}
+                   for _ in range(10)]
+        results = pipeline.run(batches)
+        for inputs, outputs in zip(batches, results):
+            ref.run(**inputs)
+            np.testing.assert_allclose(outputs[0].asnumpy(), ref.get_output(0).asnumpy())
+        stats = pipeline.stats()
+        assert stats["batches"] == len(batches)
+        stages = stats["stages"]
+        assert len(stages) == 3
+        assert stages[0]["begin"] == 0
+        for prev, cur in zip(stages, stages[1:]):
+            assert prev["end"] == cur["begin"] and cur["begin"] < cur["end"]
+        assert all(0 <= stage["utilization"] <= 1 for stage in stages)
+
+    def check_run_async():
+        if not tvm.runtime.enabled("llvm"):
+            print("Skip because llvm is not enabled")
+            return
+        mlib = tvm.build(s, [A, B], "llvm", name="myadd")
+        mods = [graph_runtime.create(graph, mlib, tvm.cpu(0)) for _ in range(3)]
+        inputs = [np.random.uniform(size=(n,)).astype(A.dtype) for _ in mods]
+        futures = [mod.run_async(x=a) for mod, a in zip(mods, inputs)]
+        for mod, a, future in zip(mods, inputs, futures):
+            future.result()
+            np.testing.assert_equal(mod.get_output(0).asnumpy(), a + 1)
+
     check_verify()
     check_remote()
     check_sharing()
+    check_model()
+    check_batcher()
+    check_pipeline()
+    check_run_async()
+    check_thread_pool()
+    check_memory_arena()
 
 if __name__ == "__main__":
     test_graph_simple()
@@ -86,3 +86,23 @@ int TVMBackendParallelLaunch(
 int TVMBackendParallelBarrier(int task_id, TVMParallelGroupEnv* penv) {
   return 0;
 }
+
+namespace tvm {
+namespace runtime {
+namespace threading {
+// named thread pools are not available, graph runtime always uses the default.
+std::shared_ptr<ThreadPool> GetThreadPool(const std::string& name) {
+  CHECK(name.empty()) << "Thread pools are not supported in Web runtime";
+  return nullptr;
+}
+ThreadPoolScope::ThreadPoolScope(const std::shared_ptr<ThreadPool>& pool) : prev_(nullptr) {}
+ThreadPoolScope::~ThreadPoolScope() {}
+// the web runtime is single threaded, inter-op parallel runs fail at launch.
+void Yield() {}
+int MaxConcurrency() { return 1; }
+int CurrentConcurrency() { return 1; }
+// no threads either, asynchronous calls complete before returning.
+void RunAsync(const void* key, std::function<void()> task) { task(); }
+}  // namespace threading
+}  // namespace runtime
+}  // namespace tvm